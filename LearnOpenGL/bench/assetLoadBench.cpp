@@ -0,0 +1,183 @@
+// 资源读取基准：对比 ifstream/stdio 与 mmap 两种方式读取一个目录下所有资源的耗时，
+// 图片完整解码（stbi_load 对比 stbi_load_from_memory），其它文件按着色器源码的方式读入并逐字节访问。
+// 冷缓存在 Linux 上用 posix_fadvise(DONTNEED) 逐个文件丢弃页缓存，其它平台只测热缓存
+// 用法: assetLoadBench [目录] [重复次数]，默认 resource 目录和 5 次
+
+#include "config.h"
+#include "mappedFile.h"
+#include "stb_image.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+    void listFiles(const std::string &directory, std::vector<std::string> &files)
+    {
+        DIR *dir = opendir(directory.c_str());
+        if (!dir)
+            return;
+        while (dirent *entry = readdir(dir))
+        {
+            std::string name = entry->d_name;
+            if (name == "." || name == "..")
+                continue;
+            std::string path = directory + "/" + name;
+            struct stat info;
+            if (stat(path.c_str(), &info) != 0)
+                continue;
+            if (S_ISDIR(info.st_mode))
+                listFiles(path, files);
+            else if (S_ISREG(info.st_mode))
+                files.push_back(path);
+        }
+        closedir(dir);
+    }
+
+    bool isImage(const std::string &path)
+    {
+        std::string extension = path.substr(path.find_last_of('.') + 1);
+        std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+        return extension == "png" || extension == "jpg" || extension == "jpeg" || extension == "tga" || extension == "bmp";
+    }
+
+    // 丢弃文件的页缓存，成功返回 true
+    bool dropCache(const std::string &path)
+    {
+#ifdef __linux__
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        int result = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+        return result == 0;
+#else
+        (void)path;
+        return false;
+#endif
+    }
+
+    // 模拟 GL 驱动读取源码：逐字节累加，保证映射的页真正被访问
+    unsigned int touch(const char *data, size_t size)
+    {
+        unsigned int sum = 0;
+        for (size_t i = 0; i < size; i++)
+            sum += (unsigned char)data[i];
+        return sum;
+    }
+
+    // 旧的读取方式：ifstream -> stringstream -> string，图片用 stdio 版本的 stbi_load
+    size_t loadStream(const std::string &path, unsigned int &checksum)
+    {
+        if (isImage(path))
+        {
+            int width, height, channels;
+            unsigned char *pixels = stbi_load(path.c_str(), &width, &height, &channels, 0);
+            if (!pixels)
+                return 0;
+            checksum += pixels[0];
+            stbi_image_free(pixels);
+            return (size_t)width * height * channels;
+        }
+        std::ifstream file(path.c_str(), std::ios::binary);
+        std::stringstream stream;
+        stream << file.rdbuf();
+        std::string code = stream.str();
+        checksum += touch(code.c_str(), code.size());
+        return code.size();
+    }
+
+    // 新的读取方式：MappedFile，图片用 stbi_load_from_memory
+    size_t loadMapped(const std::string &path, unsigned int &checksum)
+    {
+        MappedFile file;
+        if (!file.Open(path, true))
+            return 0;
+        if (isImage(path))
+        {
+            int width, height, channels;
+            unsigned char *pixels = stbi_load_from_memory(file.Data(), (int)file.Size(), &width, &height, &channels, 0);
+            if (!pixels)
+                return 0;
+            checksum += pixels[0];
+            stbi_image_free(pixels);
+            return (size_t)width * height * channels;
+        }
+        checksum += touch(file.Chars(), file.Size());
+        return file.Size();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string directory = argc > 1 ? argv[1] : PROJECT_PATH + "/resource";
+    int repeat = argc > 2 ? std::max(1, atoi(argv[2])) : 5;
+
+    std::vector<std::string> files;
+    listFiles(directory, files);
+    size_t fileBytes = 0, images = 0;
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        uint64_t size;
+        int64_t mtime;
+        if (MappedFile::Stat(files[i], size, mtime))
+            fileBytes += (size_t)size;
+        images += isImage(files[i]) ? 1 : 0;
+    }
+    std::cout << "BENCH::ASSET_LOAD " << directory << " files: " << files.size() << " (" << images << " images), "
+              << fileBytes / (1024.0 * 1024.0) << " MB, repeat: " << repeat << std::endl;
+
+    bool coldSupported = !files.empty() && dropCache(files[0]);
+    if (!coldSupported)
+        std::cout << "BENCH::ASSET_LOAD cold cache not supported on this platform, warm only" << std::endl;
+
+    const char *modes[] = { "ifstream/stdio", "mmap" };
+    for (int cold = coldSupported ? 1 : 0; cold >= 0; cold--)
+    {
+        for (int mode = 0; mode < 2; mode++)
+        {
+            // 热缓存先完整读一遍预热；各类分别取 repeat 次中最快的一次
+            unsigned int checksum = 0;
+            if (!cold)
+            {
+                for (size_t i = 0; i < files.size(); i++)
+                    mode == 0 ? loadStream(files[i], checksum) : loadMapped(files[i], checksum);
+            }
+            // 文本（着色器等）和图片分开计时，图片的解码时间会掩盖读取方式的差别
+            double bestText = 1e30, bestImages = 1e30;
+            size_t decoded = 0;
+            for (int r = 0; r < repeat; r++)
+            {
+                if (cold)
+                {
+                    for (size_t i = 0; i < files.size(); i++)
+                        dropCache(files[i]);
+                }
+                decoded = 0;
+                double seconds[2] = { 0.0, 0.0 };
+                for (size_t i = 0; i < files.size(); i++)
+                {
+                    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                    decoded += mode == 0 ? loadStream(files[i], checksum) : loadMapped(files[i], checksum);
+                    seconds[isImage(files[i]) ? 1 : 0] += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                }
+                bestText = std::min(bestText, seconds[0]);
+                bestImages = std::min(bestImages, seconds[1]);
+            }
+            std::cout << "BENCH::ASSET_LOAD " << (cold ? "cold" : "warm") << " " << modes[mode]
+                      << " text ms: " << bestText * 1000.0 << " images ms: " << bestImages * 1000.0
+                      << " (" << decoded / (1024.0 * 1024.0) << " MB decoded, checksum " << checksum << ")" << std::endl;
+        }
+    }
+    return 0;
+}
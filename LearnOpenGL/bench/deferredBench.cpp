@@ -0,0 +1,206 @@
+// 前向和延迟着色的 GPU 耗时对比：nanosuit 周围随机放 4、64、512 个点光源，分别用
+// 前向逐光源、前向分簇、延迟逐光源、延迟分簇画同一帧，用 GL_TIME_ELAPSED 查询取每帧平均的 GPU 时间；
+// 另外用 glFinish 前后的墙钟时间做对照，软件光栅化等延后执行的驱动上查询可能测不到实际的绘制
+// 用法: deferredBench [帧数]，默认每种方式 100 帧
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "config.h"
+#include "model.h"
+#include "cameraUniforms.h"
+#include "lightBuffer.h"
+#include "deferredRenderer.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+    const int WIDTH = 800;
+    const int HEIGHT = 600;
+    const float FOVY = glm::radians(45.0f);
+    const float NEAR_PLANE = 0.1f;
+    const float FAR_PLANE = 100.0f;
+
+    enum Mode
+    {
+        FORWARD,
+        FORWARD_CLUSTERED,
+        DEFERRED,
+        DEFERRED_CLUSTERED,
+        MODE_COUNT
+    };
+    const char *MODE_NAMES[MODE_COUNT] = { "forward", "forward+clusters", "deferred", "deferred+clusters" };
+
+    // 光源散布在模型周围，半径约 1.5 个单位（模型约 1.5 个单位高），每个光源只照亮模型的一部分
+    std::vector<PointLight> randomLights(size_t count)
+    {
+        std::mt19937 random(1234u + (unsigned int)count);
+        std::uniform_real_distribution<float> x(-2.0f, 2.0f), y(-0.5f, 1.5f), z(-4.5f, -0.5f), color(0.2f, 1.0f);
+        std::vector<PointLight> lights(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            PointLight &light = lights[i];
+            light.position = glm::vec3(x(random), y(random), z(random));
+            light.linear = 1.4f;
+            light.quadratic = 20.0f;
+            light.diffuse = glm::vec3(color(random), color(random), color(random));
+            light.ambient = light.diffuse * 0.05f;
+            light.specular = light.diffuse;
+        }
+        return lights;
+    }
+
+    void run(GLFWwindow *window, int frames)
+    {
+        int framebufferWidth, framebufferHeight;
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        glViewport(0, 0, framebufferWidth, framebufferHeight);
+
+        Model nanosuit(PROJECT_PATH + "/resource/models/nanosuit/nanosuit.obj",
+                       MODEL_UPLOAD_PACKED | MODEL_UPLOAD_QUANTIZED | MODEL_UPLOAD_TEXTURE_ARRAYS);
+        Shader forward((PROJECT_PATH + "/resource/modelVertexColor.vex").c_str(), (PROJECT_PATH + "/resource/modelFragColor.frag").c_str());
+        DeferredRenderer deferred(PROJECT_PATH + "/resource/modelVertexColor.vex", PROJECT_PATH + "/resource/modelGBuffer.frag",
+                                  PROJECT_PATH + "/resource/deferredLighting.vex", PROJECT_PATH + "/resource/deferredLighting.frag");
+        ShaderUniform<float> forwardShininess = forward.Uniform<float>("material.shininess");
+        ShaderUniform<int> forwardLightData = forward.Uniform<int>("pointLightData");
+        ShaderUniform<int> forwardLightCount = forward.Uniform<int>("pointLightCount");
+        ShaderUniform<bool> forwardClustered = forward.Uniform<bool>("clusteredLighting");
+        ShaderUniform<int> forwardClusterRanges = forward.Uniform<int>("clusterRanges");
+        ShaderUniform<int> forwardClusterIndices = forward.Uniform<int>("clusterLightIndices");
+        ShaderUniform<glm::ivec3> forwardClusterGrid = forward.Uniform<glm::ivec3>("clusterGrid");
+        ShaderUniform<glm::vec2> forwardClusterViewport = forward.Uniform<glm::vec2>("clusterViewport");
+        ShaderUniform<glm::vec2> forwardClusterDepth = forward.Uniform<glm::vec2>("clusterDepth");
+        ShaderUniform<float> deferredShininess = deferred.Geometry().Uniform<float>("material.shininess");
+
+        // 相机正对模型，模型占屏幕高度的大部分
+        glm::vec3 cameraPosition(0.0f, 0.3f, -0.5f);
+        glm::mat4 view = glm::lookAt(cameraPosition, glm::vec3(0.0f, 0.2f, -2.5f), glm::vec3(0.0f, 1.0f, 0.0f));
+        glm::mat4 projection = glm::perspective(FOVY, (float)WIDTH / HEIGHT, NEAR_PLANE, FAR_PLANE);
+        glm::mat4 model = glm::mat4(1.0f);
+        model = glm::translate(model, glm::vec3(0.0f, -0.5f, -2.5f));
+        model = glm::scale(model, glm::vec3(0.1f, 0.1f, 0.1f));
+        LodView lodView = LodView::Perspective(cameraPosition, FOVY, (float)framebufferHeight);
+
+        CameraUniformBuffer cameraUniforms;
+        cameraUniforms.Create();
+        cameraUniforms.Update(view, projection, cameraPosition);
+        LightBuffer lightBuffer;
+        lightBuffer.Create();
+        LightClusterer clusterer;
+        clusterer.SetProjection(FOVY, (float)WIDTH / HEIGHT, NEAR_PLANE, FAR_PLANE);
+        ClusterLightBuffer clusterBuffer;
+        clusterBuffer.Create();
+
+        GLuint query;
+        glGenQueries(1, &query);
+        glEnable(GL_DEPTH_TEST);
+
+        std::cout << "BENCH::DEFERRED " << framebufferWidth << "x" << framebufferHeight
+                  << " gbuffer " << GBuffer::BYTES_PER_PIXEL << " bytes/pixel" << std::endl;
+        const size_t counts[] = { 4, 64, 512 };
+        for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+        {
+            std::vector<PointLight> lights = randomLights(counts[c]);
+            lightBuffer.Upload(lights);
+            size_t pairs = clusterer.Bin(view, lights);
+            clusterBuffer.Upload(clusterer);
+
+            std::cout << "BENCH::DEFERRED lights " << counts[c] << " pairs " << pairs;
+            for (int mode = 0; mode < MODE_COUNT; mode++)
+            {
+                bool clustered = mode == FORWARD_CLUSTERED || mode == DEFERRED_CLUSTERED;
+                GLuint64 totalNs = 0;
+                double totalSeconds = 0.0;
+                // 第一帧预热（编译着色器变体、分配 G-buffer），不计入
+                for (int frame = 0; frame <= frames; frame++)
+                {
+                    glFinish();
+                    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                    glBeginQuery(GL_TIME_ELAPSED, query);
+                    lightBuffer.Bind();
+                    clusterBuffer.Bind();
+                    if (mode == DEFERRED || mode == DEFERRED_CLUSTERED)
+                    {
+                        deferred.BeginGeometry(framebufferWidth, framebufferHeight);
+                        deferred.Geometry().Set(deferredShininess, 32.0f);
+                        nanosuit.Draw(deferred.Geometry(), model, lodView);
+                        deferred.EndGeometry();
+                        deferred.Shade(projection * view, lightBuffer.Count(), clustered ? &clusterer : nullptr);
+                    }
+                    else
+                    {
+                        forward.use();
+                        forward.Set(forwardShininess, 32.0f);
+                        forward.Set(forwardLightData, (int)LightBuffer::TEXTURE_UNIT);
+                        forward.Set(forwardLightCount, (int)lightBuffer.Count());
+                        forward.Set(forwardClustered, clustered);
+                        forward.Set(forwardClusterRanges, (int)ClusterLightBuffer::RANGES_TEXTURE_UNIT);
+                        forward.Set(forwardClusterIndices, (int)ClusterLightBuffer::INDICES_TEXTURE_UNIT);
+                        forward.Set(forwardClusterGrid, glm::ivec3(clusterer.TilesX(), clusterer.TilesY(), clusterer.Slices()));
+                        forward.Set(forwardClusterViewport, glm::vec2(framebufferWidth, framebufferHeight));
+                        forward.Set(forwardClusterDepth, glm::vec2(clusterer.NearPlane(), clusterer.SliceScale()));
+                        nanosuit.Draw(forward, model, lodView);
+                    }
+                    glEndQuery(GL_TIME_ELAPSED);
+                    glFinish();
+                    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                    GLuint64 ns = 0;
+                    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &ns);
+                    if (frame > 0)
+                    {
+                        totalNs += ns;
+                        totalSeconds += seconds;
+                    }
+                    glfwSwapBuffers(window);
+                }
+                std::cout << " | " << MODE_NAMES[mode] << " gpu ms: " << totalNs / 1e6 / frames
+                          << " wall ms: " << totalSeconds * 1000.0 / frames;
+            }
+            std::cout << std::endl;
+        }
+
+        glDeleteQueries(1, &query);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int frames = argc > 1 ? std::max(1, atoi(argv[1])) : 100;
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE); // 只需要GL上下文，不显示窗口
+
+    GLFWwindow *window = glfwCreateWindow(WIDTH, HEIGHT, "deferredBench", nullptr, nullptr);
+    if (window == nullptr)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+    // 模型、着色器和缓冲都是 run 的局部变量，在上下文销毁前析构
+    run(window, frames);
+    TextureManager::Instance().FinishPending();
+    Model::ReleaseSharedPools();
+    glfwTerminate();
+    return 0;
+}
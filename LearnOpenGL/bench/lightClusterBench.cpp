@@ -0,0 +1,143 @@
+// 分簇光源分配基准（纯CPU）：随机分布在相机前方的点光源，统计 LightClusterer::Bin 的耗时、
+// 每个 cluster 平均/最多的光源数（着色器每个片段要循环的光源数，对比逐光源循环的 N），
+// 并在每个 cluster 里取样点暴力检查，保证没有漏掉能照到样点的光源
+// 用法: lightClusterBench [重复次数]，默认 200 次，光源数为 64、512、4096
+
+#include "lightClusters.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+    const float FOVY = glm::radians(45.0f);
+    const float ASPECT = 800.0f / 600.0f;
+    const float NEAR_PLANE = 0.1f;
+    const float FAR_PLANE = 100.0f;
+
+    // LearnOpenGL 衰减表里覆盖 7/13/20/32 个单位的几组参数
+    const float ATTENUATION[][2] = { { 0.7f, 1.8f }, { 0.35f, 0.44f }, { 0.22f, 0.20f }, { 0.14f, 0.07f } };
+
+    std::vector<PointLight> randomLights(size_t count, unsigned int seed)
+    {
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<float> x(-30.0f, 30.0f), y(-10.0f, 10.0f), z(-80.0f, 5.0f), color(0.2f, 1.0f);
+        std::uniform_int_distribution<int> range(0, 3);
+        std::vector<PointLight> lights(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            PointLight &light = lights[i];
+            int r = range(random);
+            light.position = glm::vec3(x(random), y(random), z(random));
+            light.linear = ATTENUATION[r][0];
+            light.quadratic = ATTENUATION[r][1];
+            light.diffuse = glm::vec3(color(random), color(random), color(random));
+            light.ambient = light.diffuse * 0.05f;
+            light.specular = light.diffuse;
+        }
+        return lights;
+    }
+
+    // 在每个 cluster 的截头锥体里取随机点，照到这个点的光源（距离不超过半径）必须都在 cluster 的列表里；
+    // 返回漏掉的 (点, 光源) 数。列表比精确结果多出光源只影响性能，不影响正确性
+    size_t verify(const LightClusterer &clusterer, const glm::mat4 &view, const std::vector<PointLight> &lights)
+    {
+        const std::vector<unsigned int> &ranges = clusterer.ClusterRanges();
+        const std::vector<unsigned int> &indices = clusterer.LightIndices();
+        float scaleY = 1.0f / std::tan(FOVY * 0.5f), scaleX = scaleY / ASPECT;
+        std::vector<glm::vec3> centers(lights.size());
+        std::vector<float> radii(lights.size());
+        for (size_t i = 0; i < lights.size(); i++)
+        {
+            centers[i] = glm::vec3(view * glm::vec4(lights[i].position, 1.0f));
+            radii[i] = lights[i].Radius();
+        }
+
+        std::mt19937 random(42);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        size_t missing = 0;
+        for (unsigned int k = 0; k < clusterer.Slices(); k++)
+        {
+            float depthNear = NEAR_PLANE * std::pow(FAR_PLANE / NEAR_PLANE, (float)k / clusterer.Slices());
+            float depthFar = NEAR_PLANE * std::pow(FAR_PLANE / NEAR_PLANE, (float)(k + 1) / clusterer.Slices());
+            for (unsigned int y = 0; y < clusterer.TilesY(); y++)
+            {
+                for (unsigned int x = 0; x < clusterer.TilesX(); x++)
+                {
+                    unsigned int cluster = clusterer.ClusterIndex(x, y, k);
+                    const unsigned int *first = indices.empty() ? nullptr : &indices[0] + ranges[cluster * 2];
+                    const unsigned int *last = first + ranges[cluster * 2 + 1];
+                    for (int sample = 0; sample < 8; sample++)
+                    {
+                        float ndcX = -1.0f + 2.0f * (x + unit(random)) / clusterer.TilesX();
+                        float ndcY = -1.0f + 2.0f * (y + unit(random)) / clusterer.TilesY();
+                        float depth = depthNear + (depthFar - depthNear) * unit(random);
+                        glm::vec3 point(ndcX * depth / scaleX, ndcY * depth / scaleY, -depth);
+                        for (unsigned int i = 0; i < lights.size(); i++)
+                        {
+                            glm::vec3 offset = point - centers[i];
+                            if (radii[i] > 0.0f && glm::dot(offset, offset) <= radii[i] * radii[i] &&
+                                !std::binary_search(first, last, i))
+                                missing++;
+                        }
+                    }
+                }
+            }
+        }
+        return missing;
+    }
+
+    void run(size_t lightCount, int repeat)
+    {
+        std::vector<PointLight> lights = randomLights(lightCount, 1234u + (unsigned int)lightCount);
+        glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 1.0f, 3.0f), glm::vec3(0.0f, 0.0f, -10.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+        LightClusterer clusterer;
+        clusterer.SetProjection(FOVY, ASPECT, NEAR_PLANE, FAR_PLANE);
+        size_t pairs = clusterer.Bin(view, lights);
+
+        double best = 1e30;
+        for (int r = 0; r < repeat; r++)
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            clusterer.Bin(view, lights);
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+
+        const std::vector<unsigned int> &ranges = clusterer.ClusterRanges();
+        unsigned int maxCount = 0, occupied = 0;
+        for (unsigned int c = 0; c < clusterer.ClusterCount(); c++)
+        {
+            maxCount = std::max(maxCount, ranges[c * 2 + 1]);
+            occupied += ranges[c * 2 + 1] > 0 ? 1 : 0;
+        }
+        size_t missing = verify(clusterer, view, lights);
+        std::cout << "BENCH::LIGHT_CLUSTERS lights " << lightCount
+                  << " bin ms: " << best * 1000.0
+                  << " pairs: " << pairs
+                  << " lights/cluster avg " << (double)pairs / clusterer.ClusterCount()
+                  << " avg occupied " << (occupied ? (double)pairs / occupied : 0.0)
+                  << " max " << maxCount
+                  << " (all-lights loop: " << lightCount << ")"
+                  << " verify: " << (missing == 0 ? "ok" : std::to_string(missing) + " missing") << std::endl;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int repeat = argc > 1 ? std::max(1, atoi(argv[1])) : 200;
+    LightClusterer clusterer;
+    std::cout << "BENCH::LIGHT_CLUSTERS grid " << clusterer.TilesX() << "x" << clusterer.TilesY() << "x" << clusterer.Slices()
+              << " = " << clusterer.ClusterCount() << " clusters" << std::endl;
+    const size_t counts[] = { 64, 512, 4096 };
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++)
+        run(counts[i], repeat);
+    return 0;
+}
@@ -0,0 +1,43 @@
+// 顶点缓存优化基准：不需要GPU，直接用 FIFO 缓存模拟比较优化前后的 ACMR/ATVR
+// 用法: meshOptimizerBench [模型路径]，默认 nanosuit
+
+#include "config.h"
+#include "model.h"
+#include "meshOptimizer.h"
+
+#include <chrono>
+#include <iostream>
+
+int main(int argc, char **argv)
+{
+    std::string path = argc > 1 ? argv[1] : PROJECT_PATH + "/resource/models/nanosuit/nanosuit.obj";
+
+    // 不读缓存也不优化，拿到Assimp导出的原始顺序
+    ModelData data;
+    if (!Model::LoadData(path, data, 0))
+        return -1;
+
+    double totalSeconds = 0.0;
+    for (unsigned int i = 0; i < data.meshes.size(); i++)
+    {
+        MeshData &mesh = data.meshes[i];
+        size_t vertexCount = mesh.vertices.size();
+        VertexCacheStats before = MeshOptimizer::AnalyzeVertexCache(mesh.indices, mesh.vertices.size());
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        MeshOptimizer::Optimize(mesh);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        totalSeconds += seconds;
+
+        VertexCacheStats after = MeshOptimizer::AnalyzeVertexCache(mesh.indices, mesh.vertices.size());
+        // 原始数据没有去重，ATVR 统一按去重后的顶点数计算
+        float atvrBefore = before.acmr * (mesh.indices.size() / 3) / mesh.vertices.size();
+        std::cout << "BENCH::MESH " << i << " triangles: " << mesh.indices.size() / 3
+                  << " vertices: " << vertexCount << " -> " << mesh.vertices.size()
+                  << " ACMR: " << before.acmr << " -> " << after.acmr
+                  << " ATVR: " << atvrBefore << " -> " << after.atvr
+                  << " (" << seconds * 1000.0 << " ms)" << std::endl;
+    }
+    std::cout << "BENCH::MESH total optimize time: " << totalSeconds * 1000.0 << " ms" << std::endl;
+    return 0;
+}
@@ -0,0 +1,119 @@
+// CPU mipmap 生成基准：不需要GPU，统计标量/SIMD 降采样和完整 mip 链（线性/sRGB）的吞吐，
+// 每个线程处理自己的图片，按源数据字节数计算 MB/s 和单核 MB/s
+// 用法: mipmapBench [边长] [线程数]，默认 2048 和硬件线程数
+
+#include "mipmapGenerator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    enum Mode
+    {
+        MODE_DOWNSAMPLE_SCALAR,
+        MODE_DOWNSAMPLE_SIMD,
+        MODE_CHAIN_LINEAR,
+        MODE_CHAIN_SRGB
+    };
+
+    const char *modeName(Mode mode)
+    {
+        switch (mode)
+        {
+        case MODE_DOWNSAMPLE_SCALAR: return "downsample scalar";
+        case MODE_DOWNSAMPLE_SIMD:   return "downsample simd";
+        case MODE_CHAIN_LINEAR:      return "chain linear";
+        default:                     return "chain srgb";
+        }
+    }
+
+    // 单个线程反复处理同一张图片 iterations 次，返回处理的源数据字节数，seconds 只统计处理部分
+    size_t run(Mode mode, int size, int iterations, double &seconds)
+    {
+        std::vector<unsigned char> rgba8((size_t)size * size * 4);
+        std::vector<uint16_t> rgba16((size_t)size * size * 4);
+        uint32_t seed = 12345;
+        for (size_t i = 0; i < rgba8.size(); i++)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            rgba8[i] = (unsigned char)(seed >> 24);
+            rgba16[i] = (uint16_t)(rgba8[i] * 257);
+        }
+        std::vector<uint16_t> half((size_t)(size / 2) * (size / 2) * 4);
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        size_t bytes = 0;
+        for (int i = 0; i < iterations; i++)
+        {
+            if (mode == MODE_DOWNSAMPLE_SCALAR || mode == MODE_DOWNSAMPLE_SIMD)
+            {
+                MipmapGenerator::Downsample(&rgba16[0], size, size, &half[0], mode == MODE_DOWNSAMPLE_SIMD);
+                bytes += rgba16.size() * sizeof(uint16_t);
+            }
+            else
+            {
+                std::vector<MipLevel> levels = MipmapGenerator::Generate(&rgba8[0], size, size, 4, mode == MODE_CHAIN_SRGB);
+                bytes += rgba8.size();
+            }
+        }
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return bytes;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int size = argc > 1 ? atoi(argv[1]) : 2048;
+    unsigned int threads = argc > 2 ? (unsigned int)atoi(argv[2]) : std::thread::hardware_concurrency();
+    if (size < 2)
+        size = 2048;
+    if (threads == 0)
+        threads = 1;
+    int iterations = std::max(1, (int)(64LL * 1024 * 1024 / ((long long)size * size * 4)));
+
+    std::cout << "BENCH::MIPMAP " << size << "x" << size << " RGBA, simd: " << MipmapGenerator::SimdName()
+              << ", iterations: " << iterations << std::endl;
+
+    const Mode modes[] = { MODE_DOWNSAMPLE_SCALAR, MODE_DOWNSAMPLE_SIMD, MODE_CHAIN_LINEAR, MODE_CHAIN_SRGB };
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++)
+    {
+        // 单线程和多线程各跑一次，对比单核吞吐是否随线程数下降（内存带宽瓶颈）
+        unsigned int counts[] = { 1, threads };
+        for (int c = 0; c < (threads > 1 ? 2 : 1); c++)
+        {
+            unsigned int threadCount = counts[c];
+            std::vector<size_t> bytes(threadCount, 0);
+            std::vector<double> times(threadCount, 0.0);
+            std::vector<std::thread> workers;
+            for (unsigned int t = 0; t < threadCount; t++)
+            {
+                Mode mode = modes[m];
+                size_t *result = &bytes[t];
+                double *time = &times[t];
+                workers.push_back(std::thread([mode, size, iterations, result, time]() {
+                    *result = run(mode, size, iterations, *time);
+                }));
+            }
+            for (size_t t = 0; t < workers.size(); t++)
+                workers[t].join();
+
+            // 以最慢的线程计时
+            size_t total = 0;
+            double seconds = 0.0;
+            for (size_t t = 0; t < bytes.size(); t++)
+            {
+                total += bytes[t];
+                seconds = std::max(seconds, times[t]);
+            }
+            double mbPerSecond = total / (1024.0 * 1024.0) / seconds;
+            std::cout << "BENCH::MIPMAP " << modeName(modes[m]) << " threads: " << threadCount
+                      << " MB/s: " << mbPerSecond << " per core: " << mbPerSecond / threadCount << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,141 @@
+// OBJ 导入基准：原生 ObjLoader（单线程 / 全部线程）对比 Assimp，模型为 nanosuit 和生成的大网格（纯CPU）
+// 只计导入本身，不读 .meshcache，也不做优化和 LOD
+// 用法: objLoaderBench [生成网格的三角形数] [重复次数]，默认 1000 万个三角形和 3 次。
+// 生成的 OBJ 写在临时目录，文件已经存在时直接复用
+
+#include "config.h"
+#include "model.h"
+#include "objLoader.h"
+#include "mappedFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace
+{
+    // side x side 的网格，每个格子两个三角形，按行平均分成 4 个对象；每个顶点有 v/vt/vn
+    bool generateGrid(const std::string &path, size_t triangles)
+    {
+        uint64_t size;
+        int64_t mtime;
+        if (MappedFile::Stat(path, size, mtime) && size > 0)
+            return true;
+
+        FILE *file = fopen(path.c_str(), "wb");
+        if (!file)
+        {
+            std::cout << "ERROR::BENCH::CANNOT_WRITE " << path << std::endl;
+            return false;
+        }
+        size_t side = std::max<size_t>(1, (size_t)std::ceil(std::sqrt(triangles / 2.0)));
+        size_t row = side + 1;
+        std::cout << "BENCH::OBJ_LOADER generating " << side << "x" << side << " grid -> " << path << std::endl;
+
+        std::vector<char> buffer(1 << 20);
+        setvbuf(file, &buffer[0], _IOFBF, buffer.size());
+        for (size_t y = 0; y <= side; y++)
+        {
+            for (size_t x = 0; x <= side; x++)
+            {
+                float u = (float)x / side, v = (float)y / side;
+                float height = 0.05f * std::sin(u * 20.0f) * std::cos(v * 20.0f);
+                fprintf(file, "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn 0.000000 1.000000 0.000000\n", u, height, v, u, v);
+            }
+        }
+        for (size_t y = 0; y < side; y++)
+        {
+            if (y % std::max<size_t>(1, side / 4) == 0)
+                fprintf(file, "o part_%u\n", (unsigned int)(y / std::max<size_t>(1, side / 4)));
+            for (size_t x = 0; x < side; x++)
+            {
+                size_t a = y * row + x + 1, b = a + 1, c = a + row, d = c + 1;
+                fprintf(file, "f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\nf %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n",
+                        a, a, a, c, c, c, b, b, b, b, b, b, c, c, c, d, d, d);
+            }
+        }
+        bool ok = ferror(file) == 0;
+        ok = fclose(file) == 0 && ok;
+        if (!ok)
+            remove(path.c_str());
+        return ok;
+    }
+
+    void summarize(const ModelData &data, size_t &vertices, size_t &triangles)
+    {
+        vertices = triangles = 0;
+        for (size_t i = 0; i < data.meshes.size(); i++)
+        {
+            vertices += data.meshes[i].vertices.size();
+            triangles += data.meshes[i].indices.size() / 3;
+        }
+    }
+
+    // mode: 0 Assimp，其它为 ObjLoader 使用的线程数
+    void run(const std::string &path, const char *name, unsigned int mode, int repeat)
+    {
+        uint64_t fileSize = 0;
+        int64_t mtime;
+        MappedFile::Stat(path, fileSize, mtime);
+
+        double best = 1e30;
+        size_t meshes = 0, vertices = 0, triangles = 0;
+        for (int r = 0; r < repeat; r++)
+        {
+            ModelData data;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            bool ok = mode == 0 ? Model::LoadData(path, data, 0) : ObjLoader::Load(path, data, mode);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (!ok)
+            {
+                std::cout << "BENCH::OBJ_LOADER " << name << " failed" << std::endl;
+                return;
+            }
+            best = std::min(best, seconds);
+            meshes = data.meshes.size();
+            summarize(data, vertices, triangles);
+        }
+        std::cout << "BENCH::OBJ_LOADER " << name << " ms: " << best * 1000.0
+                  << " MB/s: " << fileSize / (1024.0 * 1024.0) / best
+                  << " meshes: " << meshes << " triangles: " << triangles << " vertices: " << vertices << std::endl;
+    }
+
+    void compare(const std::string &path, int repeat)
+    {
+        uint64_t size;
+        int64_t mtime;
+        MappedFile::Stat(path, size, mtime);
+        std::cout << "BENCH::OBJ_LOADER " << path << " (" << size / (1024.0 * 1024.0) << " MB)" << std::endl;
+
+        // 先完整读一遍，三种方式都在热缓存上比较
+        ModelData warmup;
+        ObjLoader::Load(path, warmup, 1);
+
+        unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+        run(path, "assimp", 0, repeat);
+        run(path, "native 1 thread", 1, repeat);
+        if (threads > 1)
+            run(path, ("native " + std::to_string(threads) + " threads").c_str(), threads, repeat);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t triangles = argc > 1 ? (size_t)std::max(1.0, atof(argv[1])) : 10000000;
+    int repeat = argc > 2 ? std::max(1, atoi(argv[2])) : 3;
+
+    compare(PROJECT_PATH + "/resource/models/nanosuit/nanosuit.obj", repeat);
+
+    const char *temp = getenv("TMPDIR");
+    std::string directory = temp && *temp ? temp : "/tmp";
+    std::string path = directory + "/objLoaderBench_" + std::to_string(triangles) + ".obj";
+    if (!generateGrid(path, triangles))
+        return -1;
+    compare(path, repeat);
+    return 0;
+}
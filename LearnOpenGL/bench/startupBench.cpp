@@ -0,0 +1,73 @@
+// 启动耗时基准：分别以串行和 N 个解码线程加载 nanosuit，比较总的墙钟时间
+// 用法: startupBench [线程数...]，默认测试 0(串行) 1 2 4 和硬件线程数
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "config.h"
+#include "model.h"
+#include "textureManager.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+int main(int argc, char **argv)
+{
+    std::vector<unsigned int> threadCounts;
+    for (int i = 1; i < argc; i++)
+        threadCounts.push_back((unsigned int)atoi(argv[i]));
+    if (threadCounts.empty())
+    {
+        unsigned int counts[] = { 0, 1, 2, 4, std::thread::hardware_concurrency() };
+        threadCounts.assign(counts, counts + 5);
+    }
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE); // 只需要GL上下文，不显示窗口
+
+    GLFWwindow *window = glfwCreateWindow(64, 64, "startupBench", nullptr, nullptr);
+    if (window == nullptr)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+
+    const std::string modelPath = PROJECT_PATH + "/resource/models/nanosuit/nanosuit.obj";
+    double serialSeconds = 0.0;
+    for (size_t i = 0; i < threadCounts.size(); i++)
+    {
+        TextureManager::Instance().SetDecodeThreads(threadCounts[i]);
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        {
+            // Model 析构后纹理引用归零，下一轮会重新解码而不是命中缓存
+            Model model(modelPath);
+            glFinish();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (i == 0)
+            serialSeconds = seconds;
+
+        std::cout << "BENCH::STARTUP threads: " << threadCounts[i]
+                  << " load: " << seconds * 1000.0 << " ms"
+                  << " speedup: " << serialSeconds / seconds << "x" << std::endl;
+    }
+    TextureManager::Instance().PrintStats();
+
+    glfwTerminate();
+    return 0;
+}
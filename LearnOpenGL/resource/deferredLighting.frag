@@ -0,0 +1,148 @@
+#version 330 core
+
+// 延迟着色的光照阶段：每个像素从 G-buffer 还原位置、法线和材质，再累加点光源。
+// 点光源和 cluster 的读取方式和 modelFragColor.frag 相同
+layout (std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition; // xyz 为相机位置
+};
+
+out vec4 color;
+
+uniform sampler2D gAlbedoSpecular;  // rgb 漫反射颜色，a 镜面反射强度
+uniform sampler2D gNormalShininess; // rg 八面体编码的法线，b 是 log2(shininess) / 11
+uniform sampler2D gDepth;
+uniform mat4 inverseViewProjection;
+
+struct PointLight {
+    vec3 position;
+
+    float constant;
+    float linear;
+    float quadratic;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+// 点光源数据在 texture buffer 里，每个光源 4 个纹素（布局见 pointLight.h）
+uniform samplerBuffer pointLightData;
+uniform int pointLightCount;
+
+PointLight fetchPointLight(int index)
+{
+    int base = index * 4;
+    vec4 t0 = texelFetch(pointLightData, base);
+    vec4 t1 = texelFetch(pointLightData, base + 1);
+    vec4 t2 = texelFetch(pointLightData, base + 2);
+    vec4 t3 = texelFetch(pointLightData, base + 3);
+    PointLight light;
+    light.position = t0.xyz;
+    light.constant = t0.w;
+    light.ambient = t1.xyz;
+    light.linear = t1.w;
+    light.diffuse = t2.xyz;
+    light.quadratic = t2.w;
+    light.specular = t3.xyz;
+    return light;
+}
+
+// 分簇模式：只计算像素所在 cluster 里的光源（见 lightClusters.h）
+uniform bool clusteredLighting;
+uniform usamplerBuffer clusterRanges;       // 每个 cluster 的 (offset, count)
+uniform usamplerBuffer clusterLightIndices;
+uniform ivec3 clusterGrid;                  // tile 列数、行数、深度层数
+uniform vec2 clusterViewport;               // 帧缓冲大小（像素）
+uniform vec2 clusterDepth;                  // 近平面、层数 / log(远平面 / 近平面)
+
+int clusterIndex(vec3 fragPos)
+{
+    float depth = -(view * vec4(fragPos, 1.0)).z;
+    int slice = int(floor(log(max(depth, clusterDepth.x) / clusterDepth.x) * clusterDepth.y));
+    slice = clamp(slice, 0, clusterGrid.z - 1);
+    ivec2 tile = ivec2(gl_FragCoord.xy / clusterViewport * vec2(clusterGrid.xy));
+    tile = clamp(tile, ivec2(0), clusterGrid.xy - 1);
+    return (slice * clusterGrid.y + tile.y) * clusterGrid.x + tile.x;
+}
+
+vec3 decodeOctahedral(vec2 e)
+{
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0)
+    {
+        vec2 signs = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+        n.xy = (1.0 - abs(n.yx)) * signs;
+    }
+    return normalize(n);
+}
+
+vec3 calculatePointLight(PointLight light, vec3 normal, vec3 viewDir, vec3 fragPos,
+                         vec3 albedo, float specularStrength, float shininess);
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gDepth, pixel, 0).r;
+    // 几何阶段没有写到的像素保留前向绘制的结果
+    if (depth >= 1.0)
+        discard;
+
+    // 位置由深度还原：屏幕坐标和深度转回 NDC，再乘 viewProjection 的逆矩阵
+    vec2 uv = gl_FragCoord.xy / vec2(textureSize(gDepth, 0));
+    vec4 world = inverseViewProjection * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+    vec3 fragPos = world.xyz / world.w;
+
+    vec4 albedoSpecular = texelFetch(gAlbedoSpecular, pixel, 0);
+    vec4 normalShininess = texelFetch(gNormalShininess, pixel, 0);
+    vec3 normal = decodeOctahedral(normalShininess.xy * 2.0 - 1.0);
+    float shininess = exp2(normalShininess.z * 11.0);
+    vec3 viewDir = normalize(cameraPosition.xyz - fragPos);
+
+    vec3 finalColor = vec3(0.0);
+    if (clusteredLighting)
+    {
+        uvec2 range = texelFetch(clusterRanges, clusterIndex(fragPos)).xy;
+        for (uint i = 0u; i < range.y; i++)
+        {
+            int light = int(texelFetch(clusterLightIndices, int(range.x + i)).r);
+            finalColor += calculatePointLight(fetchPointLight(light), normal, viewDir, fragPos,
+                                              albedoSpecular.rgb, albedoSpecular.a, shininess);
+        }
+    }
+    else
+    {
+        for(int i = 0; i < pointLightCount; i++)
+        {
+            finalColor += calculatePointLight(fetchPointLight(i), normal, viewDir, fragPos,
+                                              albedoSpecular.rgb, albedoSpecular.a, shininess);
+        }
+    }
+
+    color = vec4(finalColor, 1.0);
+    // 写回深度，之后前向绘制的物体和这个模型正确遮挡
+    gl_FragDepth = depth;
+}
+
+vec3 calculatePointLight(PointLight light, vec3 normal, vec3 viewDir, vec3 fragPos,
+                         vec3 albedo, float specularStrength, float shininess)
+{
+    vec3 lightDir = normalize(light.position - fragPos);
+    // 计算漫反射强度
+    float diff = max(dot(normal, lightDir), 0.0);
+    // 计算镜面反射
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    // 计算衰减
+    float distance = length(light.position - fragPos);
+    float attenuation = 1.0f / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+    // 将各个分量合并
+    vec3 ambient  = light.ambient  * albedo;
+    vec3 diffuse  = light.diffuse  * diff * albedo;
+    vec3 specular = light.specular * spec * specularStrength;
+    ambient  *= attenuation;
+    diffuse  *= attenuation;
+    specular *= attenuation;
+    return (ambient + diffuse + specular);
+}
@@ -0,0 +1,141 @@
+#version 330 core
+
+in vec2 TexCoords;
+in vec3 outNormal;
+in vec3 outFragPos;
+
+// 和顶点着色器声明相同的 Camera 块，这里只用到相机位置
+layout (std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition; // xyz 为相机位置
+};
+
+out vec4 color;
+
+struct Material {
+    sampler2D texture_diffuse1;
+    sampler2D texture_specular1;
+    // 贴图打包成纹理数组时使用，layer 为负表示这个mesh使用上面的普通纹理
+    sampler2DArray diffuseArray;
+    sampler2DArray specularArray;
+    float diffuseLayer;
+    float specularLayer;
+    float shininess;
+};
+uniform Material material;
+
+vec3 diffuseColor()
+{
+    if (material.diffuseLayer >= 0.0)
+        return vec3(texture(material.diffuseArray, vec3(TexCoords, material.diffuseLayer)));
+    return vec3(texture(material.texture_diffuse1, TexCoords));
+}
+
+vec3 specularColor()
+{
+    if (material.specularLayer >= 0.0)
+        return vec3(texture(material.specularArray, vec3(TexCoords, material.specularLayer)));
+    return vec3(texture(material.texture_specular1, TexCoords));
+}
+
+struct PointLight {
+    vec3 position;
+
+    float constant;
+    float linear;
+    float quadratic;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+// 点光源数据在 texture buffer 里，每个光源 4 个纹素（布局见 lightBuffer.h），数量运行时给出
+uniform samplerBuffer pointLightData;
+uniform int pointLightCount;
+
+PointLight fetchPointLight(int index)
+{
+    int base = index * 4;
+    vec4 t0 = texelFetch(pointLightData, base);
+    vec4 t1 = texelFetch(pointLightData, base + 1);
+    vec4 t2 = texelFetch(pointLightData, base + 2);
+    vec4 t3 = texelFetch(pointLightData, base + 3);
+    PointLight light;
+    light.position = t0.xyz;
+    light.constant = t0.w;
+    light.ambient = t1.xyz;
+    light.linear = t1.w;
+    light.diffuse = t2.xyz;
+    light.quadratic = t2.w;
+    light.specular = t3.xyz;
+    return light;
+}
+
+// 分簇模式：只计算片段所在 cluster 里的光源，分配在 CPU 上完成（见 lightClusters.h）
+uniform bool clusteredLighting;
+uniform usamplerBuffer clusterRanges;       // 每个 cluster 的 (offset, count)
+uniform usamplerBuffer clusterLightIndices;
+uniform ivec3 clusterGrid;                  // tile 列数、行数、深度层数
+uniform vec2 clusterViewport;               // 帧缓冲大小（像素）
+uniform vec2 clusterDepth;                  // 近平面、层数 / log(远平面 / 近平面)
+
+int clusterIndex(vec3 fragPos)
+{
+    float depth = -(view * vec4(fragPos, 1.0)).z;
+    int slice = int(floor(log(max(depth, clusterDepth.x) / clusterDepth.x) * clusterDepth.y));
+    slice = clamp(slice, 0, clusterGrid.z - 1);
+    ivec2 tile = ivec2(gl_FragCoord.xy / clusterViewport * vec2(clusterGrid.xy));
+    tile = clamp(tile, ivec2(0), clusterGrid.xy - 1);
+    return (slice * clusterGrid.y + tile.y) * clusterGrid.x + tile.x;
+}
+
+vec3 calculatePointLight(PointLight light, vec3 normal, vec3 viewDir, vec3 fragPos);
+void main()
+{    
+    vec3 normal = normalize(outNormal);
+    vec3 viewDir = normalize(cameraPosition.xyz - outFragPos);
+
+    vec3 finalColor = vec3(0.0);
+    if (clusteredLighting)
+    {
+        uvec2 range = texelFetch(clusterRanges, clusterIndex(outFragPos)).xy;
+        for (uint i = 0u; i < range.y; i++)
+        {
+            int light = int(texelFetch(clusterLightIndices, int(range.x + i)).r);
+            finalColor += calculatePointLight(fetchPointLight(light), normal, viewDir, outFragPos);
+        }
+    }
+    else
+    {
+        for(int i = 0; i < pointLightCount; i++)
+        {
+            finalColor += calculatePointLight(fetchPointLight(i), normal, viewDir, outFragPos);
+        }
+    }
+
+    color = vec4(finalColor, 1.0);
+}
+
+vec3 calculatePointLight(PointLight light, vec3 normal, vec3 viewDir, vec3 fragPos)
+{
+    vec3 lightDir = normalize(light.position - fragPos);
+    // 计算漫反射强度
+    float diff = max(dot(normal, lightDir), 0.0);
+    // 计算镜面反射
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    // 计算衰减
+    float distance = length(light.position - fragPos);
+    float attenuation = 1.0f / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+    // 将各个分量合并
+    vec3 ambient  = light.ambient  * diffuseColor();
+    vec3 diffuse  = light.diffuse  * diff * diffuseColor();
+    vec3 specular = light.specular * spec * specularColor();
+    ambient  *= attenuation;
+    diffuse  *= attenuation;
+    specular *= attenuation;
+    return (ambient + diffuse + specular);
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#version 330 core
+
+// 延迟着色的几何阶段，和 modelVertexColor.vex 搭配使用，G-buffer 布局见 deferredRenderer.h
+in vec2 TexCoords;
+in vec3 outNormal; // 世界空间法线（顶点着色器里已经乘过 normalMatrix）
+
+layout (location = 0) out vec4 albedoSpecular;
+layout (location = 1) out vec4 normalShininess;
+
+struct Material {
+    sampler2D texture_diffuse1;
+    sampler2D texture_specular1;
+    // 贴图打包成纹理数组时使用，layer 为负表示这个mesh使用上面的普通纹理
+    sampler2DArray diffuseArray;
+    sampler2DArray specularArray;
+    float diffuseLayer;
+    float specularLayer;
+    float shininess;
+};
+uniform Material material;
+
+vec3 diffuseColor()
+{
+    if (material.diffuseLayer >= 0.0)
+        return vec3(texture(material.diffuseArray, vec3(TexCoords, material.diffuseLayer)));
+    return vec3(texture(material.texture_diffuse1, TexCoords));
+}
+
+vec3 specularColor()
+{
+    if (material.specularLayer >= 0.0)
+        return vec3(texture(material.specularArray, vec3(TexCoords, material.specularLayer)));
+    return vec3(texture(material.texture_specular1, TexCoords));
+}
+
+// 单位法线投影到八面体再展开到 [-1, 1] 的正方形，和 modelVertexColor.vex 里的 decodeOctahedral 对应
+vec2 encodeOctahedral(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 e = n.xy;
+    if (n.z < 0.0)
+    {
+        vec2 signs = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+        e = (1.0 - abs(n.yx)) * signs;
+    }
+    return e;
+}
+
+void main()
+{
+    // 镜面反射贴图只保留一个强度（三个分量的平均）
+    vec3 specular = specularColor();
+    albedoSpecular = vec4(diffuseColor(), (specular.r + specular.g + specular.b) / 3.0);
+    // shininess 取对数后放进 10 位，覆盖 1..2048
+    normalShininess = vec4(encodeOctahedral(normalize(outNormal)) * 0.5 + 0.5,
+                           clamp(log2(max(material.shininess, 1.0)) / 11.0, 0.0, 1.0), 0.0);
+}
@@ -0,0 +1,373 @@
+#include "assetPack.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+    const char ASSET_PACK_MAGIC[8] = { 'L', 'O', 'G', 'L', 'P', 'A', 'K', '\0' };
+
+    uint64_t alignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    void writePadding(FILE *file, uint64_t &offset, uint64_t alignment)
+    {
+        static const char zeros[AssetPack::ALIGNMENT] = { 0 };
+        uint64_t aligned = alignUp(offset, alignment);
+        fwrite(zeros, 1, (size_t)(aligned - offset), file);
+        offset = aligned;
+    }
+
+    // 按字面规范化路径：统一分隔符，去掉 "." 和多余的 "/"，折叠 "a/.."
+    std::string normalize(const std::string &path)
+    {
+        std::string unified = path;
+        std::replace(unified.begin(), unified.end(), '\\', '/');
+        bool absolute = !unified.empty() && unified[0] == '/';
+
+        std::vector<std::string> segments;
+        size_t begin = 0;
+        while (begin <= unified.size())
+        {
+            size_t end = unified.find('/', begin);
+            if (end == std::string::npos)
+                end = unified.size();
+            std::string segment = unified.substr(begin, end - begin);
+            if (segment == ".." && !segments.empty() && segments.back() != "..")
+                segments.pop_back();
+            else if (!segment.empty() && segment != ".")
+                segments.push_back(segment);
+            begin = end + 1;
+        }
+
+        std::string result = absolute ? "/" : "";
+        for (size_t i = 0; i < segments.size(); i++)
+            result += (i ? "/" : "") + segments[i];
+        return result;
+    }
+
+    // 递归列出 directory 下的文件，返回相对路径
+    void listFiles(const std::string &directory, const std::string &prefix, std::vector<std::string> &files)
+    {
+#ifndef _WIN32
+        DIR *dir = opendir(directory.c_str());
+        if (!dir)
+            return;
+        while (dirent *entry = readdir(dir))
+        {
+            std::string name = entry->d_name;
+            if (name.empty() || name[0] == '.')
+                continue;
+            std::string path = directory + "/" + name;
+            struct stat info;
+            if (stat(path.c_str(), &info) != 0)
+                continue;
+            if (S_ISDIR(info.st_mode))
+                listFiles(path, prefix + name + "/", files);
+            else if (S_ISREG(info.st_mode))
+                files.push_back(prefix + name);
+        }
+        closedir(dir);
+#endif
+    }
+}
+
+uint64_t AssetPack::Hash(const std::string &name)
+{
+    // FNV-1a，0 留给空槽
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < name.size(); i++)
+    {
+        hash ^= (unsigned char)name[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash != 0 ? hash : 1;
+}
+
+AssetPack &AssetPack::Instance()
+{
+    static AssetPack instance;
+    return instance;
+}
+
+AssetPack::AssetPack() : _header(nullptr), _index(nullptr), _strings(nullptr)
+{
+}
+
+bool AssetPack::Build(const std::string &directory, const std::string &packPath)
+{
+    std::vector<std::string> names;
+    listFiles(directory, "", names);
+    // 包自己在打包目录里时跳过
+    std::string packName = normalize(packPath);
+    std::string root = normalize(directory) + "/";
+    if (packName.compare(0, root.size(), root) == 0)
+        names.erase(std::remove(names.begin(), names.end(), packName.substr(root.size())), names.end());
+    std::sort(names.begin(), names.end()); // 同一目录的文件在包里相邻，预读更有效
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, ASSET_PACK_MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.alignment = ALIGNMENT;
+    header.entryCount = (uint32_t)names.size();
+    header.bucketCount = 16;
+    while (header.bucketCount < header.entryCount * 2)
+        header.bucketCount *= 2;
+
+    std::string strings;
+    std::vector<uint64_t> sizes(names.size());
+    std::vector<int64_t> mtimes(names.size());
+    for (size_t i = 0; i < names.size(); i++)
+    {
+        uint64_t size;
+        int64_t mtime;
+        if (!MappedFile::Stat(directory + "/" + names[i], size, mtime))
+        {
+            std::cout << "ERROR::ASSET_PACK::CANNOT_READ " << names[i] << std::endl;
+            return false;
+        }
+        sizes[i] = size;
+        mtimes[i] = mtime;
+    }
+
+    // 索引按哈希线性探测放置，数据按对齐依次排在字符串表之后
+    std::vector<IndexEntry> index(header.bucketCount);
+    memset(&index[0], 0, index.size() * sizeof(IndexEntry));
+    header.indexOffset = alignUp(sizeof(Header), ALIGNMENT);
+    header.stringOffset = header.indexOffset + index.size() * sizeof(IndexEntry);
+    for (size_t i = 0; i < names.size(); i++)
+        strings += names[i];
+    uint64_t dataOffset = alignUp(header.stringOffset + strings.size(), ALIGNMENT);
+    uint32_t nameOffset = 0;
+    for (size_t i = 0; i < names.size(); i++)
+    {
+        uint64_t hash = Hash(names[i]);
+        uint32_t slot = (uint32_t)hash & (header.bucketCount - 1);
+        while (index[slot].hash != 0)
+            slot = (slot + 1) & (header.bucketCount - 1);
+        index[slot].hash = hash;
+        index[slot].offset = dataOffset;
+        index[slot].size = sizes[i];
+        index[slot].nameOffset = nameOffset;
+        index[slot].nameLength = (uint32_t)names[i].size();
+        index[slot].mtime = mtimes[i];
+        nameOffset += (uint32_t)names[i].size();
+        dataOffset = alignUp(dataOffset + sizes[i], ALIGNMENT);
+    }
+    header.fileSize = dataOffset;
+
+    // 写到临时文件再改名，避免运行中的程序映射到写了一半的包
+    std::string tempPath = packPath + ".tmp";
+    FILE *file = fopen(tempPath.c_str(), "wb");
+    if (!file)
+    {
+        std::cout << "ERROR::ASSET_PACK::CANNOT_WRITE " << tempPath << std::endl;
+        return false;
+    }
+    uint64_t offset = 0;
+    fwrite(&header, sizeof(Header), 1, file);
+    offset += sizeof(Header);
+    writePadding(file, offset, ALIGNMENT);
+    fwrite(&index[0], sizeof(IndexEntry), index.size(), file);
+    offset += index.size() * sizeof(IndexEntry);
+    fwrite(strings.data(), 1, strings.size(), file);
+    offset += strings.size();
+    bool ok = true;
+    for (size_t i = 0; i < names.size() && ok; i++)
+    {
+        writePadding(file, offset, ALIGNMENT);
+        MappedFile source;
+        if (sizes[i] > 0 && (!source.Open(directory + "/" + names[i]) || source.Size() != sizes[i]))
+        {
+            std::cout << "ERROR::ASSET_PACK::CANNOT_READ " << names[i] << std::endl;
+            ok = false;
+            break;
+        }
+        if (sizes[i] > 0)
+            fwrite(source.Data(), 1, source.Size(), file);
+        offset += sizes[i];
+    }
+    writePadding(file, offset, ALIGNMENT);
+
+    ok = ok && ferror(file) == 0 && offset == header.fileSize;
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(tempPath.c_str(), packPath.c_str()) != 0)
+    {
+        std::cout << "ERROR::ASSET_PACK::CANNOT_WRITE " << packPath << std::endl;
+        remove(tempPath.c_str());
+        return false;
+    }
+    std::cout << "ASSET_PACK::BUILD " << packPath << " files: " << names.size()
+              << " size: " << header.fileSize / (1024.0 * 1024.0) << " MB" << std::endl;
+    return true;
+}
+
+bool AssetPack::Mount(const std::string &packPath, const std::string &root)
+{
+    Unmount();
+    if (!_file.Open(packPath))
+        return false;
+
+    const unsigned char *data = _file.Data();
+    const Header *header = reinterpret_cast<const Header *>(data);
+    if (_file.Size() < sizeof(Header)
+        || memcmp(header->magic, ASSET_PACK_MAGIC, sizeof(header->magic)) != 0
+        || header->version != VERSION
+        || header->fileSize != _file.Size()
+        || header->bucketCount == 0 || (header->bucketCount & (header->bucketCount - 1)) != 0
+        || header->stringOffset != header->indexOffset + (uint64_t)header->bucketCount * sizeof(IndexEntry)
+        || header->indexOffset < sizeof(Header) || header->indexOffset > _file.Size()
+        || header->indexOffset % sizeof(uint64_t) != 0
+        || header->stringOffset > _file.Size())
+    {
+        std::cout << "ERROR::ASSET_PACK::INVALID " << packPath << std::endl;
+        _file.Close();
+        return false;
+    }
+
+    // 每个非空槽的名字和数据都要在文件里，否则 Find 的比较和返回的 span 会读到映射外面
+    const IndexEntry *index = reinterpret_cast<const IndexEntry *>(data + header->indexOffset);
+    uint64_t stringSize = _file.Size() - header->stringOffset;
+    uint32_t used = 0;
+    for (uint32_t i = 0; i < header->bucketCount; i++)
+    {
+        const IndexEntry &entry = index[i];
+        if (entry.hash == 0)
+            continue;
+        used++;
+        if ((uint64_t)entry.nameOffset + entry.nameLength > stringSize
+            || entry.offset > header->fileSize || entry.size > header->fileSize - entry.offset)
+        {
+            std::cout << "ERROR::ASSET_PACK::INVALID_ENTRY " << i << " in " << packPath << std::endl;
+            _file.Close();
+            return false;
+        }
+    }
+    if (used != header->entryCount)
+    {
+        std::cout << "ERROR::ASSET_PACK::INVALID " << packPath << std::endl;
+        _file.Close();
+        return false;
+    }
+
+    _header = header;
+    _index = reinterpret_cast<const IndexEntry *>(data + header->indexOffset);
+    _strings = reinterpret_cast<const char *>(data + header->stringOffset);
+    _roots.clear();
+    _roots.push_back(normalize(root));
+#ifndef _WIN32
+    char resolved[PATH_MAX];
+    if (realpath(root.c_str(), resolved) && normalize(resolved) != _roots[0])
+        _roots.push_back(normalize(resolved));
+#endif
+    std::cout << "ASSET_PACK::MOUNT " << packPath << " files: " << header->entryCount << std::endl;
+    return true;
+}
+
+void AssetPack::Unmount()
+{
+    _file.Close();
+    _header = nullptr;
+    _index = nullptr;
+    _strings = nullptr;
+    _roots.clear();
+    std::lock_guard<std::mutex> lock(_mutex);
+    _overrides.clear();
+}
+
+bool AssetPack::IsMounted() const
+{
+    return _header != nullptr;
+}
+
+unsigned int AssetPack::EntryCount() const
+{
+    return _header ? _header->entryCount : 0;
+}
+
+std::string AssetPack::relativePath(const std::string &path) const
+{
+    std::string normalized = normalize(path);
+    for (size_t i = 0; i < _roots.size(); i++)
+    {
+        const std::string &root = _roots[i];
+        if (normalized.size() > root.size() && normalized.compare(0, root.size(), root) == 0 && normalized[root.size()] == '/')
+            return normalized.substr(root.size() + 1);
+    }
+    return normalized; // 已经是相对路径
+}
+
+const AssetPack::IndexEntry *AssetPack::lookup(const std::string &path) const
+{
+    if (!_header)
+        return nullptr;
+    std::string name = relativePath(path);
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_overrides.empty() && _overrides.count(name))
+            return nullptr;
+    }
+
+    uint64_t hash = Hash(name);
+    uint32_t mask = _header->bucketCount - 1;
+    for (uint32_t slot = (uint32_t)hash & mask, probes = 0; probes <= mask; slot = (slot + 1) & mask, probes++)
+    {
+        const IndexEntry &entry = _index[slot];
+        if (entry.hash == 0)
+            return nullptr;
+        if (entry.hash == hash && entry.nameLength == name.size()
+            && memcmp(_strings + entry.nameOffset, name.data(), name.size()) == 0)
+        {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+bool AssetPack::Find(const std::string &path, AssetSpan &span) const
+{
+    const IndexEntry *entry = lookup(path);
+    if (!entry)
+        return false;
+    // 松散文件在打包之后改过，包里的内容已经过期
+    uint64_t size;
+    int64_t mtime;
+    if (MappedFile::Stat(path, size, mtime) && (size != entry->size || mtime != entry->mtime))
+        return false;
+    span.data = _file.Data() + entry->offset;
+    span.size = (size_t)entry->size;
+    return true;
+}
+
+bool AssetPack::Stamp(const std::string &path, uint64_t &size, int64_t &mtime) const
+{
+    if (MappedFile::Stat(path, size, mtime))
+        return true;
+    const IndexEntry *entry = lookup(path);
+    if (!entry)
+        return false;
+    size = entry->size;
+    mtime = entry->mtime;
+    return true;
+}
+
+void AssetPack::Override(const std::string &path)
+{
+    if (!_header)
+        return;
+    std::string name = relativePath(path);
+    std::lock_guard<std::mutex> lock(_mutex);
+    _overrides.insert(name);
+}
@@ -0,0 +1,97 @@
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include "mappedFile.h"
+
+#include <mutex>
+#include <set>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// 资源包里一个文件的只读视图，直接指向映射的内存
+struct AssetSpan
+{
+    const unsigned char *data;
+    size_t size;
+
+    AssetSpan() : data(nullptr), size(0) {}
+    const char *Chars() const { return reinterpret_cast<const char *>(data); }
+};
+
+// 单文件资源包：一个目录下的所有文件按 ALIGNMENT 对齐依次拼接，
+// 前面是以相对路径哈希为键的开放寻址索引。运行时整个包只映射一次，Find 返回不拷贝的 span。
+// 挂载时记录打包的目录，调用方继续传原来的完整路径（比如 PROJECT_PATH + "/resource/..."）即可
+class AssetPack
+{
+public:
+    static const uint32_t VERSION = 2; // 2: 索引记录源文件的修改时间
+    static const uint32_t ALIGNMENT = 64;
+
+    // 全局挂载的资源包，Shader、TextureManager 和 Model 读文件前先在这里查找，找不到再读松散文件。
+    // 松散文件存在并且大小或修改时间和打包时不同时以松散文件为准，过期的包不会盖住修改过的文件
+    static AssetPack &Instance();
+
+    // 把 directory 下的所有文件（递归，跳过隐藏文件）打包写到 packPath
+    static bool Build(const std::string &directory, const std::string &packPath);
+
+    // 映射资源包并校验索引，root 为打包时的目录
+    bool Mount(const std::string &packPath, const std::string &root);
+    void Unmount();
+    bool IsMounted() const;
+    unsigned int EntryCount() const;
+
+    // 线程安全，可以在解码线程上调用；span 在卸载之前一直有效
+    bool Find(const std::string &path, AssetSpan &span) const;
+    // path 实际会读到的内容的大小和修改时间：松散文件存在时是它的，否则是包里记录的。
+    // 由源文件生成的缓存用它记录来源，两边都没有时返回 false
+    bool Stamp(const std::string &path, uint64_t &size, int64_t &mtime) const;
+    // 热重载修改了松散文件之后调用，这个路径以后不再从包里读取
+    void Override(const std::string &path);
+
+public:
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t alignment;
+        uint32_t entryCount;
+        uint32_t bucketCount; // 2 的幂，至少是 entryCount 的两倍
+        uint64_t indexOffset;
+        uint64_t stringOffset;
+        uint64_t fileSize;
+    };
+
+    struct IndexEntry
+    {
+        uint64_t hash;        // 0 表示空槽
+        uint64_t offset;
+        uint64_t size;
+        uint32_t nameOffset;  // 相对路径，查找时用来排除哈希冲突
+        uint32_t nameLength;
+        int64_t mtime;        // 打包时源文件的修改时间
+    };
+
+    static uint64_t Hash(const std::string &name);
+
+private:
+    AssetPack();
+    AssetPack(const AssetPack &);
+    AssetPack &operator=(const AssetPack &);
+
+    // 完整路径 -> 包里的相对路径（按字面规范化，不访问文件系统）
+    std::string relativePath(const std::string &path) const;
+    // 按路径查找索引项，不检查松散文件
+    const IndexEntry *lookup(const std::string &path) const;
+
+private:
+    MappedFile _file;
+    const Header *_header;
+    const IndexEntry *_index;
+    const char *_strings;
+    std::vector<std::string> _roots; // 打包目录的原始写法和 realpath 之后的写法
+    mutable std::mutex _mutex;
+    std::set<std::string> _overrides;
+};
+
+#endif
@@ -0,0 +1,38 @@
+#include "cameraUniforms.h"
+#include "shader.hpp"
+
+#include <cstring>
+
+static_assert(sizeof(CameraUniforms) == 3 * 64 + 16, "CameraUniforms must match the std140 Camera block");
+
+CameraUniformBuffer::CameraUniformBuffer() : _uploaded(false)
+{
+}
+
+void CameraUniformBuffer::Create()
+{
+    _buffer.Create();
+    glBindBuffer(GL_UNIFORM_BUFFER, _buffer.Id());
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraUniforms), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    // 绑定点对所有程序有效，程序链接时由 Shader 把 Camera 块指向这里
+    glBindBufferBase(GL_UNIFORM_BUFFER, UNIFORM_BLOCK_CAMERA, _buffer.Id());
+    _uploaded = false;
+}
+
+void CameraUniformBuffer::Update(const glm::mat4 &view, const glm::mat4 &projection, const glm::vec3 &position)
+{
+    CameraUniforms data;
+    data.view = view;
+    data.projection = projection;
+    data.viewProjection = projection * view;
+    data.position = glm::vec4(position, 1.0f);
+    if (_uploaded && memcmp(&data, &_data, sizeof(data)) == 0)
+        return;
+
+    _data = data;
+    glBindBuffer(GL_UNIFORM_BUFFER, _buffer.Id());
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(CameraUniforms), &_data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    _uploaded = true;
+}
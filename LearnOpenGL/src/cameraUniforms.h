@@ -0,0 +1,34 @@
+#ifndef CAMERA_UNIFORMS_H
+#define CAMERA_UNIFORMS_H
+
+#include "glObjects.h"
+#include "glm/glm.hpp"
+
+// 着色器里 Camera 块的 std140 布局：mat4 按 4 个 vec4 列排列，vec4 16 字节对齐，和 C++ 结构体逐字节一致
+struct CameraUniforms
+{
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProjection;
+    glm::vec4 position;
+};
+
+// 所有程序共用的相机 uniform 缓冲，绑定在 UNIFORM_BLOCK_CAMERA。
+// 每帧调用一次 Update，用一次 glBufferSubData 写入，不再对每个程序分别设置 view/projection
+class CameraUniformBuffer
+{
+public:
+    CameraUniformBuffer();
+
+    // GL线程：创建缓冲并绑定到固定的绑定点
+    void Create();
+    // 和上一帧相同时不上传
+    void Update(const glm::mat4 &view, const glm::mat4 &projection, const glm::vec3 &position);
+
+private:
+    GLBuffer _buffer;
+    CameraUniforms _data;
+    bool _uploaded;
+};
+
+#endif
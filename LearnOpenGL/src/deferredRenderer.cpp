@@ -0,0 +1,153 @@
+#include "deferredRenderer.h"
+#include "lightBuffer.h"
+#include "renderStats.h"
+
+#include <iostream>
+
+namespace
+{
+    void allocate(const GLTexture &texture, GLint internalFormat, GLenum format, GLenum type, int width, int height)
+    {
+        glBindTexture(GL_TEXTURE_2D, texture.Id());
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, nullptr);
+        // 光照阶段用 texelFetch 逐像素读取，不需要过滤和 mip
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+}
+
+GBuffer::GBuffer() : _width(0), _height(0), _complete(false)
+{
+}
+
+void GBuffer::Create()
+{
+    _framebuffer.Create();
+    _albedo.Create();
+    _normal.Create();
+    _depth.Create();
+    _width = 0;
+    _height = 0;
+    _complete = false;
+}
+
+bool GBuffer::Resize(int width, int height)
+{
+    if (width == _width && height == _height)
+        return _complete;
+    _width = width;
+    _height = height;
+
+    allocate(_albedo, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, width, height);
+    allocate(_normal, GL_RGB10_A2, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, width, height);
+    allocate(_depth, GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, width, height);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer.Id());
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _albedo.Id(), 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, _normal.Id(), 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, _depth.Id(), 0);
+    const GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(2, drawBuffers);
+    _complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!_complete)
+        std::cout << "ERROR::GBUFFER::FRAMEBUFFER_INCOMPLETE " << width << "x" << height << std::endl;
+    return _complete;
+}
+
+void GBuffer::Bind() const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer.Id());
+    glViewport(0, 0, _width, _height);
+}
+
+void GBuffer::BindTextures() const
+{
+    glActiveTexture(GL_TEXTURE0 + ALBEDO_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, _albedo.Id());
+    glActiveTexture(GL_TEXTURE0 + NORMAL_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, _normal.Id());
+    glActiveTexture(GL_TEXTURE0 + DEPTH_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, _depth.Id());
+    glActiveTexture(GL_TEXTURE0);
+}
+
+DeferredRenderer::DeferredRenderer(const std::string &geometryVertexPath, const std::string &geometryFragmentPath,
+                                   const std::string &lightingVertexPath, const std::string &lightingFragmentPath) :
+    _geometry(geometryVertexPath.c_str(), geometryFragmentPath.c_str()),
+    _lighting(lightingVertexPath.c_str(), lightingFragmentPath.c_str()),
+    _blend(GL_FALSE)
+{
+    _gbuffer.Create();
+    _fullscreen.Create();
+
+    _albedoUnit = _lighting.Uniform<int>("gAlbedoSpecular");
+    _normalUnit = _lighting.Uniform<int>("gNormalShininess");
+    _depthUnit = _lighting.Uniform<int>("gDepth");
+    _inverseViewProjection = _lighting.Uniform<glm::mat4>("inverseViewProjection");
+    _lightData = _lighting.Uniform<int>("pointLightData");
+    _lightCount = _lighting.Uniform<int>("pointLightCount");
+    _clustered = _lighting.Uniform<bool>("clusteredLighting");
+    _clusterRanges = _lighting.Uniform<int>("clusterRanges");
+    _clusterIndices = _lighting.Uniform<int>("clusterLightIndices");
+    _clusterGrid = _lighting.Uniform<glm::ivec3>("clusterGrid");
+    _clusterViewport = _lighting.Uniform<glm::vec2>("clusterViewport");
+    _clusterDepth = _lighting.Uniform<glm::vec2>("clusterDepth");
+}
+
+void DeferredRenderer::BeginGeometry(int width, int height)
+{
+    // 颜色附件的 alpha 存的是数据，不能被混合
+    _blend = glIsEnabled(GL_BLEND);
+    glDisable(GL_BLEND);
+    _gbuffer.Resize(width, height);
+    _gbuffer.Bind();
+    // 光照阶段会丢弃深度为 1 的像素，颜色附件不需要清空
+    glClear(GL_DEPTH_BUFFER_BIT);
+    _geometry.use();
+}
+
+void DeferredRenderer::EndGeometry()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, _gbuffer.Width(), _gbuffer.Height());
+    if (_blend)
+        glEnable(GL_BLEND);
+}
+
+void DeferredRenderer::Shade(const glm::mat4 &viewProjection, unsigned int lightCount, const LightClusterer *clusterer)
+{
+    GLboolean blend = glIsEnabled(GL_BLEND);
+    glDisable(GL_BLEND);
+
+    _lighting.use();
+    _gbuffer.BindTextures();
+    _lighting.Set(_albedoUnit, (int)GBuffer::ALBEDO_TEXTURE_UNIT);
+    _lighting.Set(_normalUnit, (int)GBuffer::NORMAL_TEXTURE_UNIT);
+    _lighting.Set(_depthUnit, (int)GBuffer::DEPTH_TEXTURE_UNIT);
+    _lighting.Set(_inverseViewProjection, glm::inverse(viewProjection));
+    _lighting.Set(_lightData, (int)LightBuffer::TEXTURE_UNIT);
+    _lighting.Set(_lightCount, (int)lightCount);
+    _lighting.Set(_clustered, clusterer != nullptr);
+    if (clusterer)
+    {
+        _lighting.Set(_clusterRanges, (int)ClusterLightBuffer::RANGES_TEXTURE_UNIT);
+        _lighting.Set(_clusterIndices, (int)ClusterLightBuffer::INDICES_TEXTURE_UNIT);
+        _lighting.Set(_clusterGrid, glm::ivec3(clusterer->TilesX(), clusterer->TilesY(), clusterer->Slices()));
+        _lighting.Set(_clusterViewport, glm::vec2(_gbuffer.Width(), _gbuffer.Height()));
+        _lighting.Set(_clusterDepth, glm::vec2(clusterer->NearPlane(), clusterer->SliceScale()));
+    }
+
+    glBindVertexArray(_fullscreen.Id());
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+    RenderStats::Instance().vaoBinds++;
+    RenderStats::Instance().drawCalls++;
+    RenderStats::Instance().triangles++;
+
+    if (blend)
+        glEnable(GL_BLEND);
+}
@@ -0,0 +1,89 @@
+#ifndef DEFERRED_RENDERER_H
+#define DEFERRED_RENDERER_H
+
+#include "glObjects.h"
+#include "shader.hpp"
+#include "lightClusters.h"
+
+#include <string>
+
+// 紧凑的 G-buffer，每个像素 12 字节，不单独存位置：
+//   albedo  RGBA8     rgb 漫反射颜色，a 镜面反射强度
+//   normal  RGB10_A2  rg 八面体编码的法线，b 是 log2(shininess) / 11
+//   depth   DEPTH24   光照阶段用 viewProjection 的逆矩阵还原世界坐标
+class GBuffer
+{
+public:
+    // 接在点光源和 cluster 的纹理单元（10..12）之后，GL 3.3 至少保证 16 个
+    static const unsigned int ALBEDO_TEXTURE_UNIT = 13;
+    static const unsigned int NORMAL_TEXTURE_UNIT = 14;
+    static const unsigned int DEPTH_TEXTURE_UNIT = 15;
+    static const unsigned int BYTES_PER_PIXEL = 4 + 4 + 4;
+
+    GBuffer();
+
+    // GL线程：创建帧缓冲和三张附件纹理
+    void Create();
+    // 尺寸变化时重新分配附件，返回帧缓冲是否完整
+    bool Resize(int width, int height);
+    // 绑定为绘制目标并设置视口
+    void Bind() const;
+    // 附件绑定到上面的纹理单元，之后活动纹理单元恢复为 0
+    void BindTextures() const;
+
+    int Width() const { return _width; }
+    int Height() const { return _height; }
+
+private:
+    GLFramebuffer _framebuffer;
+    GLTexture _albedo;
+    GLTexture _normal;
+    GLTexture _depth;
+    int _width;
+    int _height;
+    bool _complete;
+};
+
+// 延迟着色：几何阶段把不透明的模型写进 G-buffer，材质贴图每个像素只采样一次；
+// 光照阶段画一个全屏三角形，按 cluster 列表（或全部光源）累加点光源，并写回深度，
+// 之后前向绘制的半透明物体照常做深度测试
+class DeferredRenderer
+{
+public:
+    DeferredRenderer(const std::string &geometryVertexPath, const std::string &geometryFragmentPath,
+                     const std::string &lightingVertexPath, const std::string &lightingFragmentPath);
+
+    // 绑定并清空 G-buffer，启用几何阶段的程序，之后用 Geometry() 绘制模型
+    void BeginGeometry(int width, int height);
+    // 恢复默认帧缓冲、视口和混合状态
+    void EndGeometry();
+    // 全屏光照，画到当前帧缓冲。点光源需要已经绑定在 LightBuffer::TEXTURE_UNIT；
+    // clusterer 不为空时只计算像素所在 cluster 的光源，需要 ClusterLightBuffer 已经绑定
+    void Shade(const glm::mat4 &viewProjection, unsigned int lightCount, const LightClusterer *clusterer);
+
+    Shader &Geometry() { return _geometry; }
+    Shader &Lighting() { return _lighting; }
+    const GBuffer &Buffer() const { return _gbuffer; }
+
+private:
+    Shader _geometry;
+    Shader _lighting;
+    GBuffer _gbuffer;
+    GLVertexArray _fullscreen; // 全屏三角形由 gl_VertexID 生成，core profile 仍然需要绑定一个 VAO
+    GLboolean _blend;          // BeginGeometry 之前的混合状态
+
+    ShaderUniform<int> _albedoUnit;
+    ShaderUniform<int> _normalUnit;
+    ShaderUniform<int> _depthUnit;
+    ShaderUniform<glm::mat4> _inverseViewProjection;
+    ShaderUniform<int> _lightData;
+    ShaderUniform<int> _lightCount;
+    ShaderUniform<bool> _clustered;
+    ShaderUniform<int> _clusterRanges;
+    ShaderUniform<int> _clusterIndices;
+    ShaderUniform<glm::ivec3> _clusterGrid;
+    ShaderUniform<glm::vec2> _clusterViewport;
+    ShaderUniform<glm::vec2> _clusterDepth;
+};
+
+#endif
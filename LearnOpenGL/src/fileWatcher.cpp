@@ -0,0 +1,263 @@
+#include "fileWatcher.h"
+#include "mappedFile.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    bool isDirectory(const std::string &path)
+    {
+#ifdef _WIN32
+        return false;
+#else
+        struct stat info;
+        return stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+#endif
+    }
+
+    bool endsWith(const std::string &text, const char *suffix)
+    {
+        size_t length = strlen(suffix);
+        return text.size() >= length && text.compare(text.size() - length, length, suffix) == 0;
+    }
+
+    // 程序自己生成的文件（网格缓存、压缩贴图缓存和写缓存用的临时文件）不触发回调，
+    // 否则重新导入时写出的缓存又会被当成资源修改
+    bool isGenerated(const std::string &path)
+    {
+        return endsWith(path, ".meshcache") || endsWith(path, ".bctex") || endsWith(path, ".tmp");
+    }
+
+    // 递归列出 directory 下的所有子目录（含自身）和文件
+    void listTree(const std::string &directory, std::vector<std::string> &directories, std::vector<std::string> *files)
+    {
+        directories.push_back(directory);
+#ifndef _WIN32
+        DIR *dir = opendir(directory.c_str());
+        if (!dir)
+            return;
+        while (dirent *entry = readdir(dir))
+        {
+            std::string name = entry->d_name;
+            if (name == "." || name == "..")
+                continue;
+            std::string path = directory + "/" + name;
+            if (isDirectory(path))
+                listTree(path, directories, files);
+            else if (files)
+                files->push_back(path);
+        }
+        closedir(dir);
+#endif
+    }
+}
+
+#ifdef __linux__
+FileWatcher::FileWatcher() : _nextId(1), _fd(inotify_init1(IN_NONBLOCK | IN_CLOEXEC))
+{
+    if (_fd < 0)
+        std::cout << "ERROR::FILE_WATCHER::INOTIFY_INIT_FAILED" << std::endl;
+}
+
+FileWatcher::~FileWatcher()
+{
+    if (_fd >= 0)
+        close(_fd); // 关闭后所有 watch 自动移除
+}
+
+bool FileWatcher::watchDirectory(const std::string &directory)
+{
+    if (_fd < 0)
+        return false;
+    // 文件只关心写完关闭和改名进来两种事件，避免读到写了一半的文件；IN_CREATE 只用来发现新建的子目录
+    int wd = inotify_add_watch(_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (wd < 0)
+    {
+        std::cout << "ERROR::FILE_WATCHER::WATCH_FAILED " << directory << std::endl;
+        return false;
+    }
+    _directories[wd] = directory;
+    return true;
+}
+
+void FileWatcher::Poll()
+{
+    if (_fd < 0)
+        return;
+
+    std::set<std::string> changed;
+    alignas(inotify_event) char buffer[4096];
+    while (true)
+    {
+        ssize_t length = read(_fd, buffer, sizeof(buffer));
+        if (length <= 0)
+            break; // EAGAIN：没有更多事件
+        for (char *p = buffer; p < buffer + length;)
+        {
+            const inotify_event *event = reinterpret_cast<const inotify_event *>(p);
+            p += sizeof(inotify_event) + event->len;
+            if (event->mask & IN_IGNORED)
+            {
+                _directories.erase(event->wd); // 目录被删除或移走，watch 已经自动移除
+                continue;
+            }
+            std::map<int, std::string>::const_iterator it = _directories.find(event->wd);
+            if (event->len == 0 || it == _directories.end())
+                continue;
+            std::string path = it->second + "/" + event->name;
+            if (event->mask & IN_ISDIR)
+            {
+                if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                    watchNewDirectory(path, changed);
+                continue;
+            }
+            if ((event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) && !isGenerated(path))
+                changed.insert(path);
+        }
+    }
+    dispatch(changed);
+}
+
+void FileWatcher::watchNewDirectory(const std::string &directory, std::set<std::string> &changed)
+{
+    // 只有被监视的目录子树里新建的目录才需要监视；单个文件的订阅虽然也监视所在目录，但不关心子目录
+    bool covered = false;
+    for (std::map<unsigned int, Subscription>::const_iterator it = _subscriptions.begin(); it != _subscriptions.end(); ++it)
+    {
+        if (it->second.directory && directory.compare(0, it->second.path.size() + 1, it->second.path + "/") == 0)
+            covered = true;
+    }
+    if (!covered)
+        return;
+
+    // 添加 watch 之前目录里可能已经有文件了（mkdir -p 后立即复制、整个目录改名进来），当作修改报告
+    std::vector<std::string> directories, files;
+    listTree(directory, directories, &files);
+    for (size_t i = 0; i < directories.size(); i++)
+        watchDirectory(directories[i]);
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        if (!isGenerated(files[i]))
+            changed.insert(files[i]);
+    }
+}
+#else
+FileWatcher::FileWatcher() : _nextId(1), _lastScan(0.0)
+{
+}
+
+FileWatcher::~FileWatcher()
+{
+}
+
+bool FileWatcher::watchDirectory(const std::string &directory)
+{
+    // 记录现有文件的大小和修改时间作为基准
+    std::vector<std::string> directories, files;
+    listTree(directory, directories, &files);
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        uint64_t size;
+        int64_t mtime;
+        if (MappedFile::Stat(files[i], size, mtime))
+            _stamps[files[i]] = std::make_pair(size, mtime);
+    }
+    return true;
+}
+
+void FileWatcher::Poll()
+{
+    // 没有 inotify 时每 0.5 秒扫描一次，修改时间只精确到秒，同时比较文件大小
+    double now = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    if (now - _lastScan < 0.5)
+        return;
+    _lastScan = now;
+
+    std::set<std::string> changed;
+    for (std::map<unsigned int, Subscription>::const_iterator it = _subscriptions.begin(); it != _subscriptions.end(); ++it)
+    {
+        std::vector<std::string> directories, files;
+        if (it->second.directory)
+            listTree(it->second.path, directories, &files);
+        else
+            files.push_back(it->second.path);
+        for (size_t i = 0; i < files.size(); i++)
+        {
+            uint64_t size;
+            int64_t mtime;
+            if (!MappedFile::Stat(files[i], size, mtime))
+                continue;
+            if (isGenerated(files[i]))
+                continue;
+            // 监视开始时已有的文件都记录过基准，没见过的是之后新建的（包括新建目录里的）
+            std::pair<uint64_t, int64_t> stamp(size, mtime);
+            std::map<std::string, std::pair<uint64_t, int64_t> >::iterator known = _stamps.find(files[i]);
+            if (known == _stamps.end() || known->second != stamp)
+                changed.insert(files[i]);
+            _stamps[files[i]] = stamp;
+        }
+    }
+    dispatch(changed);
+}
+#endif
+
+unsigned int FileWatcher::Watch(const std::string &path, const Callback &callback)
+{
+    Subscription subscription;
+    subscription.path = path;
+    subscription.directory = isDirectory(path);
+    subscription.callback = callback;
+
+    // 文件通过所在目录监视，目录则监视整棵子树
+    std::vector<std::string> directories;
+    if (subscription.directory)
+        listTree(path, directories, nullptr);
+    else
+        directories.push_back(path.find('/') == std::string::npos ? "." : path.substr(0, path.find_last_of('/')));
+    for (size_t i = 0; i < directories.size(); i++)
+    {
+        if (!watchDirectory(directories[i]))
+            return 0;
+    }
+
+    unsigned int id = _nextId++;
+    _subscriptions[id] = subscription;
+    return id;
+}
+
+void FileWatcher::Unwatch(unsigned int id)
+{
+    _subscriptions.erase(id);
+}
+
+void FileWatcher::dispatch(const std::set<std::string> &changed)
+{
+    if (changed.empty())
+        return;
+    // 回调里可能会增删监视，先复制一份
+    std::map<unsigned int, Subscription> subscriptions = _subscriptions;
+    for (std::set<std::string>::const_iterator path = changed.begin(); path != changed.end(); ++path)
+    {
+        for (std::map<unsigned int, Subscription>::const_iterator it = subscriptions.begin(); it != subscriptions.end(); ++it)
+        {
+            const Subscription &subscription = it->second;
+            bool matches = subscription.directory
+                ? path->compare(0, subscription.path.size() + 1, subscription.path + "/") == 0
+                : *path == subscription.path;
+            if (matches)
+                subscription.callback(*path);
+        }
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef FILE_WATCHER_H
+#define FILE_WATCHER_H
+
+#include <stdint.h>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+
+// 监视文件或目录的修改，用于着色器、贴图和模型的热重载。
+// Linux 上使用 inotify 监视所在目录（兼容编辑器先写临时文件再改名的保存方式），
+// 其他平台退化为定期比较文件的修改时间。之后新建的子目录也会被监视；程序自己写出的
+// .meshcache/.bctex 缓存和 .tmp 临时文件不会触发回调。回调都在调用 Poll() 的线程上执行
+class FileWatcher
+{
+public:
+    typedef std::function<void(const std::string &path)> Callback;
+
+    FileWatcher();
+    ~FileWatcher();
+
+    // path 为文件时只关心这个文件；为目录时包括所有子目录下的文件，回调参数为被修改文件的路径。
+    // 返回的 id 用于取消监视，失败时返回 0
+    unsigned int Watch(const std::string &path, const Callback &callback);
+    void Unwatch(unsigned int id);
+
+    // 每帧调用一次，不会阻塞：同一次 Poll 内同一个文件的多次写入只回调一次
+    void Poll();
+
+private:
+    FileWatcher(const FileWatcher &);
+    FileWatcher &operator=(const FileWatcher &);
+
+    struct Subscription
+    {
+        std::string path;
+        bool directory;
+        Callback callback;
+    };
+
+    bool watchDirectory(const std::string &directory);
+#ifdef __linux__
+    // 监视的子树里新建或改名进来的目录：补上整棵子树的 watch，里面已有的文件加进 changed
+    void watchNewDirectory(const std::string &directory, std::set<std::string> &changed);
+#endif
+    void dispatch(const std::set<std::string> &changed);
+
+private:
+    std::map<unsigned int, Subscription> _subscriptions;
+    unsigned int _nextId;
+#ifdef __linux__
+    int _fd;
+    std::map<int, std::string> _directories; // inotify watch descriptor -> 目录路径
+#else
+    std::map<std::string, std::pair<uint64_t, int64_t> > _stamps; // 上次扫描时各文件的大小和修改时间（秒）
+    double _lastScan;
+#endif
+};
+
+#endif
@@ -0,0 +1,184 @@
+#include "geometryPool.h"
+#include "renderStats.h"
+
+#include <algorithm>
+
+namespace
+{
+    // 通过 COPY 目标读写缓冲，避免改动当前VAO记录的索引缓冲绑定
+    void growBuffer(GLBuffer &buffer, size_t oldBytes, size_t newBytes)
+    {
+        GLBuffer grown;
+        grown.Create();
+        glBindBuffer(GL_COPY_WRITE_BUFFER, grown.Id());
+        glBufferData(GL_COPY_WRITE_BUFFER, newBytes, nullptr, GL_STATIC_DRAW);
+        if (buffer.IsValid() && oldBytes > 0)
+        {
+            glBindBuffer(GL_COPY_READ_BUFFER, buffer.Id());
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldBytes);
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        buffer = std::move(grown);
+    }
+}
+
+GeometryPool::GeometryPool(size_t vertexStride, AttributeSetup setup, GLenum indexType) :
+    _setup(setup), _vertexStride(vertexStride), _indexType(indexType),
+    _indexSize(indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint)), _vertexCount(0), _vertexCapacity(0),
+    _indexCount(0), _indexCapacity(0)
+{
+}
+
+bool GeometryPool::takeFree(std::vector<Span> &free, size_t count, size_t &offset)
+{
+    for (size_t i = 0; i < free.size(); i++)
+    {
+        if (free[i].count < count)
+            continue;
+        offset = free[i].offset;
+        free[i].offset += count;
+        free[i].count -= count;
+        if (free[i].count == 0)
+            free.erase(free.begin() + i);
+        return true;
+    }
+    return false;
+}
+
+void GeometryPool::addFree(std::vector<Span> &free, size_t offset, size_t count, size_t &used)
+{
+    if (count == 0)
+        return;
+    size_t i = 0;
+    while (i < free.size() && free[i].offset < offset)
+        i++;
+    Span span = { offset, count };
+    free.insert(free.begin() + i, span);
+    // 和后一段、前一段合并
+    if (i + 1 < free.size() && free[i].offset + free[i].count == free[i + 1].offset)
+    {
+        free[i].count += free[i + 1].count;
+        free.erase(free.begin() + i + 1);
+    }
+    if (i > 0 && free[i - 1].offset + free[i - 1].count == free[i].offset)
+    {
+        free[i - 1].count += free[i].count;
+        free.erase(free.begin() + i);
+        i--;
+    }
+    // 末尾的空闲段不需要记录，下次直接追加
+    if (free[i].offset + free[i].count == used)
+    {
+        used = free[i].offset;
+        free.erase(free.begin() + i);
+    }
+}
+
+void GeometryPool::reserve(size_t vertexCapacity, size_t indexCapacity)
+{
+    if (vertexCapacity <= _vertexCapacity && indexCapacity <= _indexCapacity && _VAO.IsValid())
+        return;
+
+    vertexCapacity = std::max(vertexCapacity, _vertexCapacity);
+    indexCapacity = std::max(indexCapacity, _indexCapacity);
+    if (vertexCapacity > _vertexCapacity || !_VBO.IsValid())
+        growBuffer(_VBO, _vertexCount * _vertexStride, vertexCapacity * _vertexStride);
+    if (indexCapacity > _indexCapacity || !_EBO.IsValid())
+        growBuffer(_EBO, _indexCount * _indexSize, indexCapacity * _indexSize);
+    _vertexCapacity = vertexCapacity;
+    _indexCapacity = indexCapacity;
+
+    // 缓冲对象换了，重新记录VAO里的顶点属性和索引缓冲
+    if (!_VAO.IsValid())
+        _VAO.Create();
+    glBindVertexArray(_VAO.Id());
+    glBindBuffer(GL_ARRAY_BUFFER, _VBO.Id());
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _EBO.Id());
+    _setup();
+    glBindVertexArray(0);
+}
+
+GeometryRange GeometryPool::Allocate(const void *vertices, size_t vertexCount, const void *indices, size_t indexCount)
+{
+    // 空闲表里放不下的部分追加到末尾，必要时成倍扩容
+    size_t vertexOffset, indexOffset;
+    bool vertexReused = takeFree(_freeVertices, vertexCount, vertexOffset);
+    bool indexReused = takeFree(_freeIndices, indexCount, indexOffset);
+    if (!vertexReused)
+        vertexOffset = _vertexCount;
+    if (!indexReused)
+        indexOffset = _indexCount;
+    size_t vertexEnd = std::max(_vertexCount, vertexOffset + vertexCount);
+    size_t indexEnd = std::max(_indexCount, indexOffset + indexCount);
+
+    size_t vertexCapacity = _vertexCapacity, indexCapacity = _indexCapacity;
+    while (vertexEnd > vertexCapacity)
+        vertexCapacity = std::max<size_t>(vertexCapacity * 2, 1 << 16);
+    while (indexEnd > indexCapacity)
+        indexCapacity = std::max<size_t>(indexCapacity * 2, 1 << 16);
+    reserve(vertexCapacity, indexCapacity);
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, _VBO.Id());
+    glBufferSubData(GL_COPY_WRITE_BUFFER, vertexOffset * _vertexStride, vertexCount * _vertexStride, vertices);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, _EBO.Id());
+    glBufferSubData(GL_COPY_WRITE_BUFFER, indexOffset * _indexSize, indexCount * _indexSize, indices);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    GeometryRange range;
+    range.baseVertex = (GLint)vertexOffset;
+    range.vertexCount = (unsigned int)vertexCount;
+    range.firstIndex = (unsigned int)indexOffset;
+    range.indexCount = (unsigned int)indexCount;
+    _vertexCount = vertexEnd;
+    _indexCount = indexEnd;
+    return range;
+}
+
+void GeometryPool::Release(const GeometryRange &range)
+{
+    addFree(_freeVertices, (size_t)range.baseVertex, range.vertexCount, _vertexCount);
+    addFree(_freeIndices, range.firstIndex, range.indexCount, _indexCount);
+}
+
+void GeometryPool::Reset()
+{
+    _VAO.Reset();
+    _VBO.Reset();
+    _EBO.Reset();
+    _vertexCount = 0;
+    _vertexCapacity = 0;
+    _indexCount = 0;
+    _indexCapacity = 0;
+    _freeVertices.clear();
+    _freeIndices.clear();
+}
+
+void GeometryPool::Bind() const
+{
+    glBindVertexArray(_VAO.Id());
+    RenderStats::Instance().vaoBinds++;
+}
+
+void GeometryPool::Draw(const GeometryRange &range) const
+{
+    glDrawElementsBaseVertex(GL_TRIANGLES, range.indexCount, _indexType,
+                             (GLvoid*)(range.firstIndex * _indexSize), range.baseVertex);
+    RenderStats::Instance().drawCalls++;
+    RenderStats::Instance().triangles += range.indexCount / 3;
+}
+
+size_t GeometryPool::VertexCount() const
+{
+    return _vertexCount;
+}
+
+size_t GeometryPool::IndexCount() const
+{
+    return _indexCount;
+}
+
+GLenum GeometryPool::IndexType() const
+{
+    return _indexType;
+}
@@ -0,0 +1,76 @@
+#ifndef GEOMETRY_POOL_H
+#define GEOMETRY_POOL_H
+
+#include "glObjects.h"
+
+#include <cstddef>
+#include <vector>
+
+// 一个mesh在共享缓冲里的位置，用 glDrawElementsBaseVertex 绘制
+struct GeometryRange
+{
+    GLint baseVertex;
+    unsigned int vertexCount;
+    unsigned int firstIndex;
+    unsigned int indexCount;
+};
+
+// 多个mesh（可以跨多个模型）共用一个VAO、一个顶点缓冲和一个索引缓冲，
+// 每个mesh只占其中的一段，绘制时不需要切换VAO。
+// 释放的顶点段和索引段进入按偏移排序的空闲表，相邻的空闲段合并；
+// 分配先在空闲表里找第一个放得下的段（first fit），没有时追加到末尾
+class GeometryPool
+{
+public:
+    typedef void (*AttributeSetup)();
+
+    // stride 为每个顶点的字节数，setup 在VAO绑定状态下设置顶点属性指针，
+    // indexType 为 GL_UNSIGNED_INT 或 GL_UNSIGNED_SHORT
+    GeometryPool(size_t vertexStride, AttributeSetup setup, GLenum indexType = GL_UNSIGNED_INT);
+
+    // GL线程：追加顶点和索引数据，容量不足时成倍扩容。indices 的类型与 IndexType() 一致
+    GeometryRange Allocate(const void *vertices, size_t vertexCount, const void *indices, size_t indexCount);
+    // 把 range 占用的顶点段和索引段还给空闲表，之后的 Allocate 可以复用
+    void Release(const GeometryRange &range);
+    // GL线程：删除VAO和缓冲，回到空的状态。池通常是静态对象，要在GL上下文销毁前调用
+    void Reset();
+
+    void Bind() const;
+    void Draw(const GeometryRange &range) const;
+
+    // 缓冲里用到的顶点/索引范围，包括中间的空闲段
+    size_t VertexCount() const;
+    size_t IndexCount() const;
+    GLenum IndexType() const;
+
+private:
+    // 缓冲里的一段，单位是顶点或索引
+    struct Span
+    {
+        size_t offset;
+        size_t count;
+    };
+
+    void reserve(size_t vertexCapacity, size_t indexCapacity);
+    // 从空闲表取一段；没有合适的段时返回 false
+    static bool takeFree(std::vector<Span> &free, size_t count, size_t &offset);
+    // 把一段还给空闲表并和相邻段合并，紧挨着末尾的段直接缩短 used
+    static void addFree(std::vector<Span> &free, size_t offset, size_t count, size_t &used);
+
+private:
+    GLVertexArray _VAO;
+    GLBuffer _VBO;
+    GLBuffer _EBO;
+    AttributeSetup _setup;
+    size_t _vertexStride;
+    GLenum _indexType;
+    size_t _indexSize;
+    size_t _vertexCount;
+    size_t _vertexCapacity;
+    size_t _indexCount;
+    size_t _indexCapacity;
+    std::vector<Span> _freeVertices;
+    std::vector<Span> _freeIndices;
+};
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef GL_OBJECTS_H
+#define GL_OBJECTS_H
+
+#include <glad/glad.h>
+
+// GL 对象的 RAII 包装：只能移动不能拷贝，析构时删除对应的GL对象，
+// 避免 Mesh 之类持有句柄的对象被拷贝后重复删除或泄漏
+template <class Traits>
+class GLObject
+{
+public:
+    GLObject() : _id(0) {}
+    ~GLObject() { Reset(); }
+
+    GLObject(GLObject &&other) noexcept : _id(other._id) { other._id = 0; }
+    GLObject &operator=(GLObject &&other) noexcept
+    {
+        if (this != &other)
+        {
+            Reset();
+            _id = other._id;
+            other._id = 0;
+        }
+        return *this;
+    }
+
+    GLObject(const GLObject &) = delete;
+    GLObject &operator=(const GLObject &) = delete;
+
+    // 需要在GL线程调用
+    void Create()
+    {
+        Reset();
+        _id = Traits::Create();
+    }
+
+    void Reset()
+    {
+        if (_id != 0)
+        {
+            Traits::Destroy(_id);
+            _id = 0;
+        }
+    }
+
+    GLuint Id() const { return _id; }
+    bool IsValid() const { return _id != 0; }
+
+private:
+    GLuint _id;
+};
+
+struct GLBufferTraits
+{
+    static GLuint Create() { GLuint id = 0; glGenBuffers(1, &id); return id; }
+    static void Destroy(GLuint id) { glDeleteBuffers(1, &id); }
+};
+
+struct GLTextureTraits
+{
+    static GLuint Create() { GLuint id = 0; glGenTextures(1, &id); return id; }
+    static void Destroy(GLuint id) { glDeleteTextures(1, &id); }
+};
+
+struct GLVertexArrayTraits
+{
+    static GLuint Create() { GLuint id = 0; glGenVertexArrays(1, &id); return id; }
+    static void Destroy(GLuint id) { glDeleteVertexArrays(1, &id); }
+};
+
+struct GLFramebufferTraits
+{
+    static GLuint Create() { GLuint id = 0; glGenFramebuffers(1, &id); return id; }
+    static void Destroy(GLuint id) { glDeleteFramebuffers(1, &id); }
+};
+
+typedef GLObject<GLBufferTraits> GLBuffer;
+typedef GLObject<GLTextureTraits> GLTexture;
+typedef GLObject<GLVertexArrayTraits> GLVertexArray;
+typedef GLObject<GLFramebufferTraits> GLFramebuffer;
+
+#endif
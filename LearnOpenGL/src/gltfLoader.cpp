@@ -0,0 +1,722 @@
+#include "gltfLoader.h"
+#include "assetPack.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/quaternion.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdint.h>
+
+namespace
+{
+    const uint32_t GLB_MAGIC = 0x46546C67;      // "glTF"
+    const uint32_t GLB_CHUNK_JSON = 0x4E4F534A; // "JSON"
+    const uint32_t GLB_CHUNK_BIN = 0x004E4942;  // "BIN\0"
+    const int GLTF_MODE_TRIANGLES = 4;
+
+    uint32_t readU32(const unsigned char *data)
+    {
+        uint32_t value;
+        memcpy(&value, data, sizeof(value)); // GLB 是小端，文件里的偏移不保证对齐
+        return value;
+    }
+
+    // 只够解析 glTF 的 JSON：数组和对象按顺序保存子节点
+    struct JsonValue
+    {
+        enum Type { JSON_NULL, JSON_BOOL, JSON_NUMBER, JSON_STRING, JSON_ARRAY, JSON_OBJECT };
+
+        Type type;
+        bool boolean;
+        double number;
+        std::string string;
+        std::vector<JsonValue> items;  // 数组元素或对象的值
+        std::vector<std::string> keys; // 对象的键，与 items 一一对应
+
+        JsonValue() : type(JSON_NULL), boolean(false), number(0.0) {}
+
+        const JsonValue *Get(const char *key) const
+        {
+            if (type != JSON_OBJECT)
+                return nullptr;
+            for (size_t i = 0; i < keys.size(); i++)
+            {
+                if (keys[i] == key)
+                    return &items[i];
+            }
+            return nullptr;
+        }
+
+        size_t Size() const
+        {
+            return type == JSON_ARRAY ? items.size() : 0;
+        }
+
+        double Number(const char *key, double fallback) const
+        {
+            const JsonValue *value = Get(key);
+            return value && value->type == JSON_NUMBER ? value->number : fallback;
+        }
+
+        int Int(const char *key, int fallback) const
+        {
+            return (int)Number(key, fallback);
+        }
+
+        bool Bool(const char *key, bool fallback) const
+        {
+            const JsonValue *value = Get(key);
+            return value && value->type == JSON_BOOL ? value->boolean : fallback;
+        }
+
+        std::string String(const char *key) const
+        {
+            const JsonValue *value = Get(key);
+            return value && value->type == JSON_STRING ? value->string : std::string();
+        }
+    };
+
+    class JsonParser
+    {
+    public:
+        // text 需要以 '\0' 结尾
+        explicit JsonParser(const char *text) : _p(text) {}
+
+        bool Parse(JsonValue &value)
+        {
+            if (!parseValue(value, 0))
+                return false;
+            skipSpaces();
+            return *_p == '\0';
+        }
+
+    private:
+        static const int MAX_DEPTH = 64;
+
+        void skipSpaces()
+        {
+            while (*_p == ' ' || *_p == '\t' || *_p == '\r' || *_p == '\n')
+                _p++;
+        }
+
+        bool literal(const char *text)
+        {
+            size_t length = strlen(text);
+            if (strncmp(_p, text, length) != 0)
+                return false;
+            _p += length;
+            return true;
+        }
+
+        bool parseValue(JsonValue &value, int depth)
+        {
+            skipSpaces();
+            if (depth > MAX_DEPTH)
+                return false;
+            switch (*_p)
+            {
+            case '{':
+                return parseObject(value, depth);
+            case '[':
+                return parseArray(value, depth);
+            case '"':
+                value.type = JsonValue::JSON_STRING;
+                return parseString(value.string);
+            case 't':
+                value.type = JsonValue::JSON_BOOL;
+                value.boolean = true;
+                return literal("true");
+            case 'f':
+                value.type = JsonValue::JSON_BOOL;
+                value.boolean = false;
+                return literal("false");
+            case 'n':
+                value.type = JsonValue::JSON_NULL;
+                return literal("null");
+            default:
+                return parseNumber(value);
+            }
+        }
+
+        bool parseNumber(JsonValue &value)
+        {
+            char *end = nullptr;
+            value.type = JsonValue::JSON_NUMBER;
+            value.number = strtod(_p, &end);
+            if (end == _p)
+                return false;
+            _p = end;
+            return true;
+        }
+
+        static void appendUtf8(std::string &out, unsigned int code)
+        {
+            if (code < 0x80)
+                out += (char)code;
+            else if (code < 0x800)
+            {
+                out += (char)(0xC0 | (code >> 6));
+                out += (char)(0x80 | (code & 0x3F));
+            }
+            else if (code < 0x10000)
+            {
+                out += (char)(0xE0 | (code >> 12));
+                out += (char)(0x80 | ((code >> 6) & 0x3F));
+                out += (char)(0x80 | (code & 0x3F));
+            }
+            else
+            {
+                out += (char)(0xF0 | (code >> 18));
+                out += (char)(0x80 | ((code >> 12) & 0x3F));
+                out += (char)(0x80 | ((code >> 6) & 0x3F));
+                out += (char)(0x80 | (code & 0x3F));
+            }
+        }
+
+        bool parseHex4(unsigned int &code)
+        {
+            code = 0;
+            for (int i = 0; i < 4; i++, _p++)
+            {
+                char c = *_p;
+                unsigned int digit;
+                if (c >= '0' && c <= '9')
+                    digit = c - '0';
+                else if (c >= 'a' && c <= 'f')
+                    digit = c - 'a' + 10;
+                else if (c >= 'A' && c <= 'F')
+                    digit = c - 'A' + 10;
+                else
+                    return false;
+                code = code * 16 + digit;
+            }
+            return true;
+        }
+
+        bool parseString(std::string &out)
+        {
+            _p++; // '"'
+            out.clear();
+            while (*_p != '"')
+            {
+                if (*_p == '\0')
+                    return false;
+                if (*_p != '\\')
+                {
+                    out += *_p++;
+                    continue;
+                }
+                _p++;
+                char escape = *_p++;
+                switch (escape)
+                {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u':
+                {
+                    unsigned int code;
+                    if (!parseHex4(code))
+                        return false;
+                    // UTF-16 代理对
+                    unsigned int low;
+                    if (code >= 0xD800 && code < 0xDC00 && _p[0] == '\\' && _p[1] == 'u')
+                    {
+                        _p += 2;
+                        if (!parseHex4(low) || low < 0xDC00 || low >= 0xE000)
+                            return false;
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendUtf8(out, code);
+                    break;
+                }
+                default:
+                    return false;
+                }
+            }
+            _p++;
+            return true;
+        }
+
+        bool parseArray(JsonValue &value, int depth)
+        {
+            value.type = JsonValue::JSON_ARRAY;
+            _p++; // '['
+            skipSpaces();
+            if (*_p == ']')
+            {
+                _p++;
+                return true;
+            }
+            while (true)
+            {
+                value.items.push_back(JsonValue());
+                if (!parseValue(value.items.back(), depth + 1))
+                    return false;
+                skipSpaces();
+                if (*_p == ']')
+                {
+                    _p++;
+                    return true;
+                }
+                if (*_p++ != ',')
+                    return false;
+            }
+        }
+
+        bool parseObject(JsonValue &value, int depth)
+        {
+            value.type = JsonValue::JSON_OBJECT;
+            _p++; // '{'
+            skipSpaces();
+            if (*_p == '}')
+            {
+                _p++;
+                return true;
+            }
+            while (true)
+            {
+                skipSpaces();
+                value.keys.push_back(std::string());
+                if (*_p != '"' || !parseString(value.keys.back()))
+                    return false;
+                skipSpaces();
+                if (*_p++ != ':')
+                    return false;
+                value.items.push_back(JsonValue());
+                if (!parseValue(value.items.back(), depth + 1))
+                    return false;
+                skipSpaces();
+                if (*_p == '}')
+                {
+                    _p++;
+                    return true;
+                }
+                if (*_p++ != ',')
+                    return false;
+            }
+        }
+
+    private:
+        const char *_p;
+    };
+
+    size_t componentSize(GLenum type)
+    {
+        switch (type)
+        {
+        case GL_BYTE:
+        case GL_UNSIGNED_BYTE:
+            return 1;
+        case GL_SHORT:
+        case GL_UNSIGNED_SHORT:
+            return 2;
+        case GL_UNSIGNED_INT:
+        case GL_FLOAT:
+            return 4;
+        default:
+            return 0;
+        }
+    }
+
+    GLint componentCount(const std::string &type)
+    {
+        if (type == "SCALAR")
+            return 1;
+        if (type == "VEC2")
+            return 2;
+        if (type == "VEC3")
+            return 3;
+        if (type == "VEC4")
+            return 4;
+        return 0; // 矩阵类型不会用作顶点属性
+    }
+
+    bool readVec3(const JsonValue *array, glm::vec3 &value)
+    {
+        if (!array || array->Size() < 3)
+            return false;
+        for (int i = 0; i < 3; i++)
+            value[i] = (float)array->items[i].number;
+        return true;
+    }
+
+    // 节点的局部变换：有 matrix（列主序）时直接使用，否则为 T * R * S，rotation 是 xyzw 四元数
+    glm::mat4 nodeTransform(const JsonValue &node)
+    {
+        const JsonValue *matrix = node.Get("matrix");
+        glm::mat4 transform(1.0f);
+        if (matrix && matrix->Size() == 16)
+        {
+            for (int i = 0; i < 16; i++)
+                transform[i / 4][i % 4] = (float)matrix->items[i].number;
+            return transform;
+        }
+        glm::vec3 translation(0.0f), scale(1.0f);
+        readVec3(node.Get("translation"), translation);
+        readVec3(node.Get("scale"), scale);
+        glm::quat rotation(1.0f, 0.0f, 0.0f, 0.0f);
+        const JsonValue *value = node.Get("rotation");
+        if (value && value->Size() == 4)
+        {
+            rotation = glm::quat((float)value->items[3].number, (float)value->items[0].number,
+                                 (float)value->items[1].number, (float)value->items[2].number);
+        }
+        transform = glm::translate(transform, translation) * glm::mat4_cast(rotation);
+        return glm::scale(transform, scale);
+    }
+
+    unsigned int maxIndex(const unsigned char *data, GLenum type, unsigned int count)
+    {
+        unsigned int result = 0;
+        for (unsigned int i = 0; i < count; i++)
+        {
+            unsigned int index;
+            if (type == GL_UNSIGNED_BYTE)
+                index = data[i];
+            else if (type == GL_UNSIGNED_SHORT)
+            {
+                uint16_t value;
+                memcpy(&value, data + i * 2, sizeof(value));
+                index = value;
+            }
+            else
+                memcpy(&index, data + i * 4, sizeof(index));
+            result = std::max(result, index);
+        }
+        return result;
+    }
+
+    void computeBounds(const GltfData &data, GltfAccessor &accessor)
+    {
+        const GltfBufferView &view = data.bufferViews[accessor.bufferView];
+        size_t stride = view.stride ? (size_t)view.stride : sizeof(glm::vec3);
+        const unsigned char *first = data.binary + view.offset + accessor.offset;
+        for (unsigned int i = 0; i < accessor.count; i++)
+        {
+            glm::vec3 position;
+            memcpy(&position, first + i * stride, sizeof(position));
+            accessor.min = i == 0 ? position : glm::min(accessor.min, position);
+            accessor.max = i == 0 ? position : glm::max(accessor.max, position);
+        }
+        accessor.hasBounds = true;
+    }
+
+    // accessor 的类型是否能直接作为这个属性的顶点指针
+    bool accessorMatches(const GltfAccessor &accessor, GLint components, bool allowNormalized)
+    {
+        if (accessor.components != components)
+            return false;
+        if (accessor.componentType == GL_FLOAT)
+            return true;
+        return allowNormalized && accessor.normalized
+            && (accessor.componentType == GL_UNSIGNED_BYTE || accessor.componentType == GL_UNSIGNED_SHORT);
+    }
+}
+
+bool GltfLoader::IsGlb(const std::string &path)
+{
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos)
+        return false;
+    std::string extension = path.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension == "glb";
+}
+
+bool GltfLoader::Load(const std::string &path, GltfData &data)
+{
+    const unsigned char *bytes = nullptr;
+    size_t size = 0;
+    AssetSpan span;
+    if (AssetPack::Instance().Find(path, span))
+    {
+        bytes = span.data;
+        size = span.size;
+    }
+    else if (data.file.Open(path, true))
+    {
+        bytes = data.file.Data();
+        size = data.file.Size();
+    }
+    else
+    {
+        std::cout << "ERROR::GLTF::CANNOT_OPEN " << path << std::endl;
+        return false;
+    }
+    data.directory = path.substr(0, path.find_last_of('/'));
+    data.bufferViews.clear();
+    data.accessors.clear();
+    data.primitives.clear();
+    data.nodes.clear();
+
+    // 12 字节文件头 + JSON 块（块头 8 字节），之后是可选的 BIN 块
+    if (size < 20 || readU32(bytes) != GLB_MAGIC || readU32(bytes + 4) != 2
+        || readU32(bytes + 8) > size || readU32(bytes + 8) < 20
+        || readU32(bytes + 16) != GLB_CHUNK_JSON || readU32(bytes + 12) > readU32(bytes + 8) - 20)
+    {
+        std::cout << "ERROR::GLTF::INVALID_GLB " << path << std::endl;
+        return false;
+    }
+    size_t length = readU32(bytes + 8);
+    size_t jsonLength = readU32(bytes + 12);
+    std::string json(reinterpret_cast<const char *>(bytes + 20), jsonLength);
+    size_t binOffset = 20 + (jsonLength + 3) / 4 * 4;
+    data.binary = nullptr;
+    data.binarySize = 0;
+    if (binOffset + 8 <= length && readU32(bytes + binOffset + 4) == GLB_CHUNK_BIN
+        && readU32(bytes + binOffset) <= length - binOffset - 8)
+    {
+        data.binary = bytes + binOffset + 8;
+        data.binarySize = readU32(bytes + binOffset);
+    }
+
+    JsonValue root;
+    if (!JsonParser(json.c_str()).Parse(root) || root.type != JsonValue::JSON_OBJECT)
+    {
+        std::cout << "ERROR::GLTF::INVALID_JSON " << path << std::endl;
+        return false;
+    }
+
+    // bufferView：只支持 GLB 的 BIN 块（buffer 0，没有 uri）
+    const JsonValue *buffers = root.Get("buffers");
+    if (buffers && (buffers->Size() > 1 || (buffers->Size() == 1 && buffers->items[0].Get("uri"))))
+    {
+        std::cout << "ERROR::GLTF::EXTERNAL_BUFFER_UNSUPPORTED " << path << std::endl;
+        return false;
+    }
+    const JsonValue *views = root.Get("bufferViews");
+    for (size_t i = 0; views && i < views->Size(); i++)
+    {
+        const JsonValue &view = views->items[i];
+        GltfBufferView bufferView;
+        bufferView.offset = (size_t)view.Number("byteOffset", 0.0);
+        bufferView.length = (size_t)view.Number("byteLength", 0.0);
+        // byteStride 按规范是 4..252 之间 4 的倍数（glVertexAttribPointer 也不接受负数），0 当作没有写
+        double stride = view.Number("byteStride", 0.0);
+        bool validStride = stride >= 0.0 && stride <= 252.0 && stride == (double)(int)stride && (int)stride % 4 == 0;
+        bufferView.stride = validStride ? (GLsizei)stride : 0;
+        if (view.Int("buffer", -1) != 0 || !validStride || bufferView.offset > data.binarySize
+            || bufferView.length > data.binarySize - bufferView.offset)
+        {
+            std::cout << "ERROR::GLTF::INVALID_BUFFER_VIEW " << i << " in " << path << std::endl;
+            return false;
+        }
+        data.bufferViews.push_back(bufferView);
+    }
+
+    // accessor：检查所有元素都落在 bufferView 里，上传之后可以直接交给 glVertexAttribPointer
+    const JsonValue *accessors = root.Get("accessors");
+    for (size_t i = 0; accessors && i < accessors->Size(); i++)
+    {
+        const JsonValue &value = accessors->items[i];
+        GltfAccessor accessor;
+        accessor.bufferView = value.Int("bufferView", -1);
+        accessor.offset = (size_t)value.Number("byteOffset", 0.0);
+        accessor.componentType = (GLenum)value.Int("componentType", 0);
+        accessor.components = componentCount(value.String("type"));
+        accessor.count = (unsigned int)value.Number("count", 0.0);
+        accessor.normalized = value.Bool("normalized", false);
+        accessor.min = accessor.max = glm::vec3(0.0f);
+        accessor.hasBounds = readVec3(value.Get("min"), accessor.min) && readVec3(value.Get("max"), accessor.max);
+        // 没有 bufferView 或带 sparse 的 accessor 需要在CPU上生成数据，这里标记为不可用
+        if (accessor.bufferView >= (int)data.bufferViews.size() || value.Get("sparse"))
+            accessor.bufferView = -1;
+        if (accessor.bufferView >= 0)
+        {
+            const GltfBufferView &view = data.bufferViews[accessor.bufferView];
+            size_t element = componentSize(accessor.componentType) * accessor.components;
+            size_t stride = view.stride ? (size_t)view.stride : element;
+            // 步长小于元素大小时相邻元素会重叠
+            if (element == 0 || accessor.count == 0 || stride < element || accessor.offset > view.length
+                || (accessor.count - 1) * stride + element > view.length - accessor.offset)
+                accessor.bufferView = -1;
+        }
+        data.accessors.push_back(accessor);
+    }
+
+    // baseColorTexture -> 图片文件，作为 texture_diffuse
+    std::vector<std::string> textureFiles;
+    const JsonValue *textures = root.Get("textures");
+    const JsonValue *images = root.Get("images");
+    for (size_t i = 0; textures && i < textures->Size(); i++)
+    {
+        int source = textures->items[i].Int("source", -1);
+        std::string uri;
+        if (images && source >= 0 && (size_t)source < images->Size())
+            uri = images->items[source].String("uri");
+        if (uri.compare(0, 5, "data:") == 0)
+            uri.clear();
+        if (uri.empty())
+            std::cout << "GLTF::EMBEDDED_IMAGE_SKIPPED texture " << i << " in " << path << std::endl;
+        textureFiles.push_back(uri);
+    }
+    std::vector<std::vector<TextureRef> > materialTextures;
+    const JsonValue *materials = root.Get("materials");
+    for (size_t i = 0; materials && i < materials->Size(); i++)
+    {
+        materialTextures.push_back(std::vector<TextureRef>());
+        const JsonValue *pbr = materials->items[i].Get("pbrMetallicRoughness");
+        const JsonValue *baseColor = pbr ? pbr->Get("baseColorTexture") : nullptr;
+        int texture = baseColor ? baseColor->Int("index", -1) : -1;
+        if (texture >= 0 && (size_t)texture < textureFiles.size() && !textureFiles[texture].empty())
+        {
+            TextureRef ref;
+            ref.type = "texture_diffuse";
+            ref.path = textureFiles[texture];
+            materialTextures.back().push_back(ref);
+        }
+    }
+
+    // primitive：属性和索引的格式不能直接绘制的跳过
+    const JsonValue *meshes = root.Get("meshes");
+    std::vector<std::vector<GltfPrimitive> > meshPrimitives(meshes ? meshes->Size() : 0);
+    unsigned int skipped = 0;
+    for (size_t i = 0; meshes && i < meshes->Size(); i++)
+    {
+        const JsonValue *primitives = meshes->items[i].Get("primitives");
+        for (size_t j = 0; primitives && j < primitives->Size(); j++)
+        {
+            const JsonValue &value = primitives->items[j];
+            const JsonValue *attributes = value.Get("attributes");
+            GltfPrimitive primitive;
+            primitive.position = attributes ? attributes->Int("POSITION", -1) : -1;
+            primitive.normal = attributes ? attributes->Int("NORMAL", -1) : -1;
+            primitive.texCoord = attributes ? attributes->Int("TEXCOORD_0", -1) : -1;
+            primitive.indices = value.Int("indices", -1);
+
+            int count = (int)data.accessors.size();
+            bool valid = value.Int("mode", GLTF_MODE_TRIANGLES) == GLTF_MODE_TRIANGLES
+                && primitive.position >= 0 && primitive.position < count
+                && primitive.normal >= 0 && primitive.normal < count
+                && primitive.indices >= 0 && primitive.indices < count
+                && primitive.texCoord < count;
+            if (valid)
+            {
+                const GltfAccessor &position = data.accessors[primitive.position];
+                const GltfAccessor &normal = data.accessors[primitive.normal];
+                const GltfAccessor &indices = data.accessors[primitive.indices];
+                valid = position.bufferView >= 0 && accessorMatches(position, 3, false)
+                    && normal.bufferView >= 0 && accessorMatches(normal, 3, false) && normal.count >= position.count
+                    && indices.bufferView >= 0 && indices.components == 1 && indices.count % 3 == 0
+                    && (indices.componentType == GL_UNSIGNED_BYTE || indices.componentType == GL_UNSIGNED_SHORT
+                        || indices.componentType == GL_UNSIGNED_INT)
+                    && data.bufferViews[indices.bufferView].stride == 0;
+            }
+            // 索引越界会让GPU读到缓冲外面，这里扫描一遍索引（只读，不拷贝）
+            if (valid)
+            {
+                const GltfAccessor &indices = data.accessors[primitive.indices];
+                const unsigned char *first = data.binary + data.bufferViews[indices.bufferView].offset + indices.offset;
+                valid = maxIndex(first, indices.componentType, indices.count) < data.accessors[primitive.position].count;
+            }
+            // 包围盒只在文件没有写 min/max 时才从顶点数据计算
+            if (valid && !data.accessors[primitive.position].hasBounds)
+                computeBounds(data, data.accessors[primitive.position]);
+            if (valid && primitive.texCoord >= 0)
+            {
+                const GltfAccessor &texCoord = data.accessors[primitive.texCoord];
+                if (texCoord.bufferView < 0 || !accessorMatches(texCoord, 2, true) || texCoord.count < data.accessors[primitive.position].count)
+                    primitive.texCoord = -1;
+            }
+            if (!valid)
+            {
+                skipped++;
+                continue;
+            }
+            int material = value.Int("material", -1);
+            if (material >= 0 && (size_t)material < materialTextures.size())
+                primitive.textures = materialTextures[material];
+            meshPrimitives[i].push_back(primitive);
+        }
+    }
+
+    // 节点：从默认场景的根节点（没有 scenes 时是所有不被引用的节点）开始展开成父节点在前的数组，
+    // 每个引用 mesh 的节点输出一份该 mesh 的 primitive，同一个 mesh 被多个节点引用时共用顶点数据
+    const JsonValue *nodes = root.Get("nodes");
+    size_t nodeCount = nodes ? nodes->Size() : 0;
+    std::vector<int> roots;
+    const JsonValue *scenes = root.Get("scenes");
+    int scene = root.Int("scene", 0);
+    const JsonValue *sceneRoots = scenes && scene >= 0 && (size_t)scene < scenes->Size() ? scenes->items[scene].Get("nodes") : nullptr;
+    if (sceneRoots)
+    {
+        for (size_t i = 0; i < sceneRoots->Size(); i++)
+            roots.push_back((int)sceneRoots->items[i].number);
+    }
+    else
+    {
+        std::vector<bool> referenced(nodeCount, false);
+        for (size_t i = 0; i < nodeCount; i++)
+        {
+            const JsonValue *children = nodes->items[i].Get("children");
+            for (size_t c = 0; children && c < children->Size(); c++)
+            {
+                int child = (int)children->items[c].number;
+                if (child >= 0 && (size_t)child < nodeCount)
+                    referenced[child] = true;
+            }
+        }
+        for (size_t i = 0; i < nodeCount; i++)
+        {
+            if (!referenced[i])
+                roots.push_back((int)i);
+        }
+    }
+
+    // 显式栈代替递归；重复引用或成环的节点只展开第一次
+    std::vector<bool> visited(nodeCount, false);
+    std::vector<std::pair<int, int> > stack; // (glTF 节点, 父节点在 data.nodes 里的下标)
+    for (size_t i = roots.size(); i-- > 0;)
+        stack.push_back(std::make_pair(roots[i], -1));
+    while (!stack.empty())
+    {
+        int index = stack.back().first;
+        int parent = stack.back().second;
+        stack.pop_back();
+        if (index < 0 || (size_t)index >= nodeCount || visited[index])
+            continue;
+        visited[index] = true;
+
+        const JsonValue &value = nodes->items[index];
+        NodeData node;
+        node.parent = parent;
+        node.transform = nodeTransform(value);
+        node.name = value.String("name");
+        unsigned int self = (unsigned int)data.nodes.size();
+        data.nodes.push_back(node);
+
+        int mesh = value.Int("mesh", -1);
+        if (mesh >= 0 && (size_t)mesh < meshPrimitives.size())
+        {
+            for (size_t p = 0; p < meshPrimitives[mesh].size(); p++)
+            {
+                data.primitives.push_back(meshPrimitives[mesh][p]);
+                data.primitives.back().node = self;
+            }
+        }
+        const JsonValue *children = value.Get("children");
+        for (size_t c = children ? children->Size() : 0; c-- > 0;)
+            stack.push_back(std::make_pair((int)children->items[c].number, (int)self));
+    }
+    // 没有节点的文件按 meshes 的顺序输出所有 primitive，都挂在根节点上
+    if (nodeCount == 0)
+    {
+        for (size_t i = 0; i < meshPrimitives.size(); i++)
+            data.primitives.insert(data.primitives.end(), meshPrimitives[i].begin(), meshPrimitives[i].end());
+    }
+    if (skipped > 0)
+    {
+        std::cout << "GLTF::PRIMITIVES_SKIPPED " << skipped
+                  << " (need triangles, float POSITION/NORMAL and indices) in " << path << std::endl;
+    }
+    return true;
+}
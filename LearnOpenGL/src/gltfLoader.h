@@ -0,0 +1,72 @@
+#ifndef GLTF_LOADER_H
+#define GLTF_LOADER_H
+
+#include "model.h"
+#include "mappedFile.h"
+
+#include <string>
+#include <vector>
+
+// GLB 二进制块里的一段，偏移相对 BIN 块开头
+struct GltfBufferView
+{
+    size_t offset;
+    size_t length;
+    GLsizei stride; // 0 表示紧密排列
+};
+
+struct GltfAccessor
+{
+    int bufferView;
+    size_t offset;         // 相对 bufferView 开头
+    GLenum componentType;  // glTF 的取值与 GL_FLOAT/GL_UNSIGNED_SHORT 等枚举相同
+    GLint components;      // SCALAR/VEC2/VEC3/VEC4 -> 1..4
+    unsigned int count;
+    bool normalized;
+    bool hasBounds;
+    glm::vec3 min;         // POSITION 的包围盒（glTF 要求写出）
+    glm::vec3 max;
+};
+
+// 一个三角形 primitive，对应一个 Mesh
+struct GltfPrimitive
+{
+    int position;  // accessor 下标
+    int normal;
+    int texCoord;  // -1 表示没有
+    int indices;
+    std::vector<TextureRef> textures;
+    unsigned int node; // 所在节点，GltfData::nodes 的下标
+
+    GltfPrimitive() : position(-1), normal(-1), texCoord(-1), indices(-1), node(0) {}
+};
+
+// GLB 解析结果：只描述布局，顶点和索引数据仍然在映射的文件里，
+// Model 直接把用到的 bufferView 交给 glBufferData，不逐顶点拷贝
+struct GltfData
+{
+    std::string directory;
+    const unsigned char *binary; // BIN 块，资源包或 file 映射的内存
+    size_t binarySize;
+    std::vector<GltfBufferView> bufferViews;
+    std::vector<GltfAccessor> accessors;
+    std::vector<GltfPrimitive> primitives;
+    std::vector<NodeData> nodes; // 默认场景的节点层级，父节点在前；为空表示只有根节点
+    MappedFile file;             // 不在资源包里时持有映射，上传之前不能释放
+
+    GltfData() : binary(nullptr), binarySize(0) {}
+};
+
+// glTF 2.0 二进制格式（.glb）的解析，只支持内嵌在 BIN 块里的 buffer。
+// 每个 primitive 需要 POSITION/NORMAL（float vec3）和索引，TEXCOORD_0 可选；
+// 材质只取 baseColorTexture 作为 texture_diffuse，引用外部图片文件。
+// 默认场景的节点层级和变换（matrix 或 TRS）保存在 nodes 里，每个引用 mesh 的节点输出一份它的 primitive；
+// 不支持动画和蒙皮
+class GltfLoader
+{
+public:
+    static bool Load(const std::string &path, GltfData &data);
+    static bool IsGlb(const std::string &path);
+};
+
+#endif
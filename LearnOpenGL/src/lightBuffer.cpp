@@ -0,0 +1,98 @@
+#include "lightBuffer.h"
+
+#include <cstring>
+
+static_assert(sizeof(PointLight) == 4 * 4 * sizeof(float), "PointLight must be 4 RGBA32F texels");
+
+LightBuffer::LightBuffer() : _uploaded(false)
+{
+}
+
+void LightBuffer::Create()
+{
+    _buffer.Create();
+    _texture.Create();
+    // 空缓冲也先分配一个光源的大小，保证 glTexBuffer 关联的存储有效
+    PointLight empty;
+    glBindBuffer(GL_TEXTURE_BUFFER, _buffer.Id());
+    glBufferData(GL_TEXTURE_BUFFER, sizeof(PointLight), &empty, GL_DYNAMIC_DRAW);
+    glBindTexture(GL_TEXTURE_BUFFER, _texture.Id());
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, _buffer.Id());
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    _lights.clear();
+    _uploaded = false;
+}
+
+void LightBuffer::Upload(const std::vector<PointLight> &lights)
+{
+    if (_uploaded && lights.size() == _lights.size() &&
+        (lights.empty() || memcmp(&lights[0], &_lights[0], lights.size() * sizeof(PointLight)) == 0))
+        return;
+
+    _lights = lights;
+    _uploaded = true;
+    if (lights.empty())
+        return;
+    // 整个数组一次上传；重新分配存储（orphan）避免等待上一帧还在读的数据
+    glBindBuffer(GL_TEXTURE_BUFFER, _buffer.Id());
+    glBufferData(GL_TEXTURE_BUFFER, lights.size() * sizeof(PointLight), &lights[0], GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void LightBuffer::Bind() const
+{
+    glActiveTexture(GL_TEXTURE0 + TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, _texture.Id());
+    glActiveTexture(GL_TEXTURE0);
+}
+
+namespace
+{
+    // 空数组也写入一个元素，保证 texture buffer 关联的存储有效
+    void uploadIndices(GLuint buffer, const std::vector<unsigned int> &values)
+    {
+        static const unsigned int EMPTY[2] = { 0, 0 };
+        glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+        if (values.empty())
+            glBufferData(GL_TEXTURE_BUFFER, sizeof(EMPTY), EMPTY, GL_STREAM_DRAW);
+        else
+            glBufferData(GL_TEXTURE_BUFFER, values.size() * sizeof(unsigned int), &values[0], GL_STREAM_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    void attach(const GLTexture &texture, GLenum format, const GLBuffer &buffer)
+    {
+        glBindTexture(GL_TEXTURE_BUFFER, texture.Id());
+        glTexBuffer(GL_TEXTURE_BUFFER, format, buffer.Id());
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+}
+
+void ClusterLightBuffer::Create()
+{
+    _ranges.Create();
+    _indices.Create();
+    _rangesTexture.Create();
+    _indicesTexture.Create();
+    uploadIndices(_ranges.Id(), std::vector<unsigned int>());
+    uploadIndices(_indices.Id(), std::vector<unsigned int>());
+    attach(_rangesTexture, GL_RG32UI, _ranges);
+    attach(_indicesTexture, GL_R32UI, _indices);
+}
+
+void ClusterLightBuffer::Upload(const LightClusterer &clusterer)
+{
+    // 每帧的数据都不同，重新分配存储，不和上一帧还在读的缓冲同步
+    uploadIndices(_ranges.Id(), clusterer.ClusterRanges());
+    uploadIndices(_indices.Id(), clusterer.LightIndices());
+}
+
+void ClusterLightBuffer::Bind() const
+{
+    glActiveTexture(GL_TEXTURE0 + RANGES_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, _rangesTexture.Id());
+    glActiveTexture(GL_TEXTURE0 + INDICES_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, _indicesTexture.Id());
+    glActiveTexture(GL_TEXTURE0);
+}
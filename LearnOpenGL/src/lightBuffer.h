@@ -0,0 +1,58 @@
+#ifndef LIGHT_BUFFER_H
+#define LIGHT_BUFFER_H
+
+#include "glObjects.h"
+#include "pointLight.h"
+#include "lightClusters.h"
+
+#include <vector>
+
+// 任意数量的点光源，打包后一次 glBufferData 上传到 texture buffer（GL 3.3 没有 SSBO，
+// uniform 数组和 UBO 的大小又有上限）。着色器通过 samplerBuffer pointLightData 读取，
+// 数量由 uniform int pointLightCount 给出，光源数变化不需要重新编译着色器
+class LightBuffer
+{
+public:
+    // 和模型贴图（0..7、数组 8/9）错开的纹理单元
+    static const unsigned int TEXTURE_UNIT = 10;
+
+    LightBuffer();
+
+    // GL线程：创建缓冲和 texture buffer 纹理
+    void Create();
+    // 内容和上一次相同时不上传
+    void Upload(const std::vector<PointLight> &lights);
+    // 绑定到 TEXTURE_UNIT，之后活动纹理单元恢复为 0
+    void Bind() const;
+
+    unsigned int Count() const { return (unsigned int)_lights.size(); }
+
+private:
+    GLBuffer _buffer;
+    GLTexture _texture;
+    std::vector<PointLight> _lights;
+    bool _uploaded;
+};
+
+// LightClusterer 的结果：cluster 的 (offset, count) 是 RG32UI、光源下标是 R32UI 的 texture buffer，
+// 着色器用 usamplerBuffer clusterRanges / clusterLightIndices 读取，每帧整体重新上传
+class ClusterLightBuffer
+{
+public:
+    static const unsigned int RANGES_TEXTURE_UNIT = 11;
+    static const unsigned int INDICES_TEXTURE_UNIT = 12;
+
+    // GL线程：创建缓冲和 texture buffer 纹理
+    void Create();
+    void Upload(const LightClusterer &clusterer);
+    // 绑定到 RANGES_TEXTURE_UNIT / INDICES_TEXTURE_UNIT，之后活动纹理单元恢复为 0
+    void Bind() const;
+
+private:
+    GLBuffer _ranges;
+    GLBuffer _indices;
+    GLTexture _rangesTexture;
+    GLTexture _indicesTexture;
+};
+
+#endif
@@ -0,0 +1,143 @@
+#include "lightClusters.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // 不衰减的光源半径取一个很大的有限值，避免后面的投影计算出现 inf/nan
+    const float MAX_LIGHT_RADIUS = 1e6f;
+}
+
+LightClusterer::LightClusterer(unsigned int tilesX, unsigned int tilesY, unsigned int slices) :
+    _tilesX(std::max(1u, tilesX)), _tilesY(std::max(1u, tilesY)), _slices(std::max(1u, slices)),
+    _fovy(0.0f), _aspect(0.0f), _near(0.0f), _far(0.0f), _sliceScale(0.0f), _scaleX(0.0f), _scaleY(0.0f)
+{
+}
+
+void LightClusterer::SetProjection(float fovyRadians, float aspect, float nearPlane, float farPlane)
+{
+    if (fovyRadians == _fovy && aspect == _aspect && nearPlane == _near && farPlane == _far)
+        return;
+    _fovy = fovyRadians;
+    _aspect = aspect;
+    _near = nearPlane;
+    _far = farPlane;
+    _scaleY = 1.0f / std::tan(fovyRadians * 0.5f);
+    _scaleX = _scaleY / aspect;
+    _sliceScale = _slices / std::log(farPlane / nearPlane);
+
+    // 每个 cluster 是一段截头锥体，取它在视空间的轴对齐包围盒
+    _boundsMin.resize(ClusterCount());
+    _boundsMax.resize(ClusterCount());
+    for (unsigned int k = 0; k < _slices; k++)
+    {
+        float depthNear = nearPlane * std::pow(farPlane / nearPlane, (float)k / _slices);
+        float depthFar = nearPlane * std::pow(farPlane / nearPlane, (float)(k + 1) / _slices);
+        for (unsigned int y = 0; y < _tilesY; y++)
+        {
+            float y0 = -1.0f + 2.0f * y / _tilesY, y1 = -1.0f + 2.0f * (y + 1) / _tilesY;
+            for (unsigned int x = 0; x < _tilesX; x++)
+            {
+                float x0 = -1.0f + 2.0f * x / _tilesX, x1 = -1.0f + 2.0f * (x + 1) / _tilesX;
+                unsigned int cluster = ClusterIndex(x, y, k);
+                _boundsMin[cluster] = glm::vec3(std::min(x0 * depthNear, x0 * depthFar) / _scaleX,
+                                                std::min(y0 * depthNear, y0 * depthFar) / _scaleY, -depthFar);
+                _boundsMax[cluster] = glm::vec3(std::max(x1 * depthNear, x1 * depthFar) / _scaleX,
+                                                std::max(y1 * depthNear, y1 * depthFar) / _scaleY, -depthNear);
+            }
+        }
+    }
+}
+
+unsigned int LightClusterer::Slice(float depth) const
+{
+    if (depth <= _near)
+        return 0;
+    float slice = std::floor(std::log(depth / _near) * _sliceScale);
+    return (unsigned int)std::min(std::max(slice, 0.0f), (float)(_slices - 1));
+}
+
+void LightClusterer::tileRange(float minCoord, float maxCoord, float minDepth, float maxDepth, float scale,
+                               unsigned int tiles, unsigned int &first, unsigned int &last) const
+{
+    // 深度为正时 coord / depth 在盒子的角上取到极值
+    float a = minCoord * scale / minDepth, b = minCoord * scale / maxDepth;
+    float c = maxCoord * scale / minDepth, d = maxCoord * scale / maxDepth;
+    float ndcMin = std::min(std::min(a, b), std::min(c, d));
+    float ndcMax = std::max(std::max(a, b), std::max(c, d));
+    if (ndcMax < -1.0f || ndcMin > 1.0f)
+    {
+        first = 1;
+        last = 0;
+        return;
+    }
+    ndcMin = std::max(ndcMin, -1.0f);
+    ndcMax = std::min(ndcMax, 1.0f);
+    first = (unsigned int)std::min((ndcMin * 0.5f + 0.5f) * tiles, (float)(tiles - 1));
+    last = (unsigned int)std::min((ndcMax * 0.5f + 0.5f) * tiles, (float)(tiles - 1));
+}
+
+size_t LightClusterer::Bin(const glm::mat4 &view, const std::vector<PointLight> &lights)
+{
+    // 1. 每个光源先用包围球在 NDC 和深度上的范围找出候选 cluster，再和 cluster 的包围盒精确相交
+    _pairs.clear();
+    for (size_t i = 0; i < lights.size(); i++)
+    {
+        float radius = std::min(lights[i].Radius(), MAX_LIGHT_RADIUS);
+        if (radius <= 0.0f)
+            continue;
+        glm::vec3 center = glm::vec3(view * glm::vec4(lights[i].position, 1.0f));
+        float depth = -center.z;
+        if (depth + radius < _near || depth - radius > _far)
+            continue;
+
+        float minDepth = std::max(depth - radius, _near);
+        float maxDepth = std::min(depth + radius, _far);
+        unsigned int firstX, lastX, firstY, lastY;
+        tileRange(center.x - radius, center.x + radius, minDepth, maxDepth, _scaleX, _tilesX, firstX, lastX);
+        tileRange(center.y - radius, center.y + radius, minDepth, maxDepth, _scaleY, _tilesY, firstY, lastY);
+        if (firstX > lastX || firstY > lastY)
+            continue;
+        unsigned int firstSlice = Slice(minDepth), lastSlice = Slice(maxDepth);
+        for (unsigned int k = firstSlice; k <= lastSlice; k++)
+        {
+            for (unsigned int y = firstY; y <= lastY; y++)
+            {
+                for (unsigned int x = firstX; x <= lastX; x++)
+                {
+                    unsigned int cluster = ClusterIndex(x, y, k);
+                    if (SphereIntersectsBox(center, radius, _boundsMin[cluster], _boundsMax[cluster]))
+                        _pairs.push_back(std::make_pair(cluster, (unsigned int)i));
+                }
+            }
+        }
+    }
+
+    // 2. 按 cluster 计数排序：先数每个 cluster 的光源数，前缀和得到起始位置，再按光源顺序填入
+    unsigned int clusterCount = ClusterCount();
+    _ranges.assign(clusterCount * 2, 0);
+    for (size_t i = 0; i < _pairs.size(); i++)
+        _ranges[_pairs[i].first * 2 + 1]++;
+    unsigned int offset = 0;
+    for (unsigned int c = 0; c < clusterCount; c++)
+    {
+        _ranges[c * 2] = offset;
+        offset += _ranges[c * 2 + 1];
+        _ranges[c * 2 + 1] = 0;
+    }
+    _indices.resize(_pairs.size());
+    for (size_t i = 0; i < _pairs.size(); i++)
+    {
+        unsigned int *range = &_ranges[_pairs[i].first * 2];
+        _indices[range[0] + range[1]++] = _pairs[i].second;
+    }
+    return _pairs.size();
+}
+
+bool LightClusterer::SphereIntersectsBox(const glm::vec3 &center, float radius, const glm::vec3 &boxMin, const glm::vec3 &boxMax)
+{
+    glm::vec3 closest = glm::clamp(center, boxMin, boxMax);
+    glm::vec3 offset = center - closest;
+    return glm::dot(offset, offset) <= radius * radius;
+}
@@ -0,0 +1,69 @@
+#ifndef LIGHT_CLUSTERS_H
+#define LIGHT_CLUSTERS_H
+
+#include "pointLight.h"
+#include "glm/glm.hpp"
+
+#include <vector>
+
+// 分簇前向渲染的 CPU 光源分配，不依赖 GL，可以单独测试和做基准。
+// 视锥在屏幕上切成 tilesX x tilesY 块，深度方向按对数切成 slices 层（远处的 cluster 更厚），
+// 每个光源按衰减半径只放进和它的包围球相交的 cluster。
+// 结果是紧凑的两个数组：每个 cluster 的 (offset, count)，以及按 cluster 排列的光源下标
+class LightClusterer
+{
+public:
+    LightClusterer(unsigned int tilesX = 16, unsigned int tilesY = 9, unsigned int slices = 24);
+
+    // 透视投影参数，变化时重建每个 cluster 的视空间包围盒
+    void SetProjection(float fovyRadians, float aspect, float nearPlane, float farPlane);
+    // 把光源分到各个 cluster，返回 (cluster, 光源) 对的总数
+    size_t Bin(const glm::mat4 &view, const std::vector<PointLight> &lights);
+
+    unsigned int TilesX() const { return _tilesX; }
+    unsigned int TilesY() const { return _tilesY; }
+    unsigned int Slices() const { return _slices; }
+    unsigned int ClusterCount() const { return _tilesX * _tilesY * _slices; }
+    // x、y 从屏幕左下角开始，和 gl_FragCoord 一致
+    unsigned int ClusterIndex(unsigned int x, unsigned int y, unsigned int slice) const
+    {
+        return (slice * _tilesY + y) * _tilesX + x;
+    }
+    // 视空间深度（正数）所在的层：floor(log(depth / near) * SliceScale())
+    unsigned int Slice(float depth) const;
+    float NearPlane() const { return _near; }
+    float SliceScale() const { return _sliceScale; }
+
+    // 每个 cluster 两个值：在 LightIndices 里的起始位置和光源数
+    const std::vector<unsigned int> &ClusterRanges() const { return _ranges; }
+    const std::vector<unsigned int> &LightIndices() const { return _indices; }
+    const glm::vec3 &ClusterMin(unsigned int cluster) const { return _boundsMin[cluster]; }
+    const glm::vec3 &ClusterMax(unsigned int cluster) const { return _boundsMax[cluster]; }
+
+    // 和包围球相交的判断，供 Bin 和外部校验使用
+    static bool SphereIntersectsBox(const glm::vec3 &center, float radius, const glm::vec3 &boxMin, const glm::vec3 &boxMax);
+
+private:
+    // 包围球在 NDC 上覆盖的 tile 范围（保守）
+    void tileRange(float minCoord, float maxCoord, float minDepth, float maxDepth, float scale, unsigned int tiles,
+                   unsigned int &first, unsigned int &last) const;
+
+private:
+    unsigned int _tilesX;
+    unsigned int _tilesY;
+    unsigned int _slices;
+    float _fovy;
+    float _aspect;
+    float _near;
+    float _far;
+    float _sliceScale;
+    float _scaleX;  // 投影矩阵的 [0][0]
+    float _scaleY;  // 投影矩阵的 [1][1]
+    std::vector<glm::vec3> _boundsMin; // 每个 cluster 的视空间包围盒
+    std::vector<glm::vec3> _boundsMax;
+    std::vector<unsigned int> _ranges;
+    std::vector<unsigned int> _indices;
+    std::vector<std::pair<unsigned int, unsigned int> > _pairs; // (cluster, 光源)，复用避免每帧分配
+};
+
+#endif
@@ -10,6 +10,14 @@
 #include "stb_image.h"
 #include "cameraSystem.hpp"
 #include "model.h"
+#include "textureManager.h"
+#include "renderStats.h"
+#include "fileWatcher.h"
+#include "assetPack.h"
+#include "traceRecorder.h"
+#include "cameraUniforms.h"
+#include "lightBuffer.h"
+#include "deferredRenderer.h"
 
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
@@ -17,17 +25,28 @@
 
 const float screen_width = 800.0f;
 const float screen_height = 600.0f;
+const float near_plane = 0.1f;
+const float far_plane = 100.0f;
 const std::string VERRTEX_COLOR_PATH = (PROJECT_PATH + "/resource/vertexcolor.vex");
 const std::string FRAG_COLOR_PATH = (PROJECT_PATH + "/resource/fragcolor.frag");
 const std::string PURE_COLOR_FRAG_COLOR_PATH = (PROJECT_PATH + "/resource/fragcolor_purecolor.frag");
 const std::string LIGHT_VERRTEX_COLOR_PATH = (PROJECT_PATH + "/resource/lightVertexColor.vex");
 const std::string LIGHT_FRAG_COLOR_PATH = (PROJECT_PATH + "/resource/lightFragColor.frag");
+const std::string MODEL_VERRTEX_COLOR_PATH = (PROJECT_PATH + "/resource/modelVertexColor.vex");
+const std::string MODEL_FRAG_COLOR_PATH = (PROJECT_PATH + "/resource/modelFragColor.frag");
+const std::string MODEL_GBUFFER_FRAG_PATH = (PROJECT_PATH + "/resource/modelGBuffer.frag");
+const std::string DEFERRED_LIGHTING_VERTEX_PATH = (PROJECT_PATH + "/resource/deferredLighting.vex");
+const std::string DEFERRED_LIGHTING_FRAG_PATH = (PROJECT_PATH + "/resource/deferredLighting.frag");
+// 启动和每帧的耗时记录，退出时或按 T 键写出，用 chrome://tracing 或 ui.perfetto.dev 打开
+const std::string TRACE_PATH = (PROJECT_PATH + "/trace.json");
 
 // camera
 glm::vec3 cameraPos = glm::vec3(0.0f, 0.0f,  3.0f);
 CameraSystem camera(cameraPos);
 static float deltaTime = 0.0f;
 static float lastFrame = 0.0f;
+static bool clusteredLighting = true; // 按 C 切换分簇光照和逐光源循环
+static bool deferredShading = false;  // 按 G 切换延迟着色和前向着色
 
 float lastX = screen_width / 2, lastY = screen_height / 2; //记录上一帧的鼠标位置，初始位置屏幕中心
 bool firstMouse = true;
@@ -35,15 +54,19 @@ bool firstMouse = true;
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow *window);
 void draw(GLFWwindow *window);
+void runScene(GLFWwindow *window);
+unsigned int textureId(const TextureHandle &texture);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos); //鼠标移动事件监听
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset); //鼠标滚轮事件监听
-unsigned int loadTexture(const char *path);
+TextureHandle loadTexture(const char *path);
 
 glm::vec3 lightPos(0.6f, 0.5f, 1.0f);
 glm::vec3 lightDir(-0.2f, -1.0f, -0.3f);
 
 int main()
 {
+    TraceRecorder::Instance().SetThreadName("main");
+    uint64_t glfwStart = TraceRecorder::Instance().Now();
     glfwInit(); //初始化GLFW
     
     //配置GLFW
@@ -66,14 +89,33 @@ int main()
     glfwSetCursorPosCallback(window, mouse_callback); // 添加鼠标事件监听
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED); // 鼠标事件设置，隐藏光标，并捕捉它
     glfwSetScrollCallback(window, scroll_callback); //鼠标滚轮事件
+    TraceRecorder::Instance().Record("GLFW init", glfwStart, TraceRecorder::Instance().Now());
     
     //初始化glad
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
     {
-        std::cout << "Failed to initialize GLAD" << std::endl;
-        return -1;
+        TRACE_ZONE("glad load");
+        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+        {
+            std::cout << "Failed to initialize GLAD" << std::endl;
+            return -1;
+        }
     }
 
+    // 持有GL对象的模型、着色器、纹理和缓冲都是 runScene 的局部变量，返回时在上下文销毁前析构
+    runScene(window);
+
+    TraceRecorder::Instance().WriteJson(TRACE_PATH);
+    //正确释放/删除之前的分配的所有资源
+    // 共享几何缓冲是函数内的静态对象，要在上下文销毁前显式释放
+    TextureManager::Instance().FinishPending();
+    Model::ReleaseSharedPools();
+    glfwTerminate();
+    
+    return 0;
+}
+
+void runScene(GLFWwindow *window)
+{
     float cubeVertices[] = {
         // positions          // texture Coords
         -0.5f, -0.5f, -0.5f,  0.0f, 0.0f,
@@ -186,24 +228,110 @@ int main()
     vegetation.push_back(glm::vec3(-0.3f,  0.0f, -2.3f));
     vegetation.push_back(glm::vec3( 0.5f,  0.0f, -0.6f));
 
+    // 有 assetPacker 生成的资源包时只映射这一个文件，着色器、贴图和模型都从包里读取，没有时读松散文件
+    AssetPack::Instance().Mount(PROJECT_PATH + "/resource.pak", PROJECT_PATH + "/resource");
+
     // load textures
     // -------------
-    unsigned int cubeTexture  = loadTexture(std::string(PROJECT_PATH + "/resource/marble.jpg").c_str());
-    unsigned int floorTexture = loadTexture(std::string(PROJECT_PATH + "/resource/metal.png").c_str());
-    unsigned int grassTexture = loadTexture(std::string(PROJECT_PATH + "/resource/grass.png").c_str());
-    unsigned int windowTexture = loadTexture(std::string(PROJECT_PATH + "/resource/blending_transparent_window.png").c_str());
+    uint64_t texturesStart = TraceRecorder::Instance().Now();
+    // 贴图转码为块压缩格式并缓存到磁盘，之后启动直接上传压缩数据
+    TextureManager::Instance().SetCompression(true);
+    TextureHandle cubeTexture  = loadTexture(std::string(PROJECT_PATH + "/resource/marble.jpg").c_str());
+    TextureHandle floorTexture = loadTexture(std::string(PROJECT_PATH + "/resource/metal.png").c_str());
+    TextureHandle grassTexture = loadTexture(std::string(PROJECT_PATH + "/resource/grass.png").c_str());
+    TextureHandle windowTexture = loadTexture(std::string(PROJECT_PATH + "/resource/blending_transparent_window.png").c_str());
+    TraceRecorder::Instance().Record("load textures", texturesStart, TraceRecorder::Instance().Now());
+
+    // load models
+    // -----------
+    glm::vec3 pointLightPositions[] = {
+        glm::vec3( 0.7f,  0.2f,  2.0f),
+        glm::vec3( 2.3f, -3.3f, -4.0f),
+        glm::vec3(-4.0f,  2.0f, -12.0f),
+        glm::vec3( 0.0f,  0.0f, -3.0f)
+    };  // 光源位置
+    // 打包模式：所有mesh共用一个VAO，每帧只绑定一次；量化顶点让显存和顶点带宽减半；
+    // 贴图打包成纹理数组后整个模型不需要切换纹理
+    // 贴图流式加载：模型先用占位色和最小的几级 mip 显示，高精度 mip 在之后的帧里按屏幕尺寸补上
+    TextureManager::Instance().SetStreaming(true);
+    // 缓存失效时用原生 OBJ 解析器多线程导入，不经过 Assimp
+    uint64_t modelStart = TraceRecorder::Instance().Now();
+    Model ourModel(PROJECT_PATH + "/resource/models/nanosuit/nanosuit.obj", MODEL_UPLOAD_PACKED | MODEL_UPLOAD_QUANTIZED | MODEL_UPLOAD_TEXTURE_ARRAYS,
+                   MODEL_LOAD_DEFAULT | MODEL_LOAD_NATIVE_OBJ);
+    TraceRecorder::Instance().Record("load model", modelStart, TraceRecorder::Instance().Now());
+    TextureManager::Instance().PrintStats();
     
     //---------> 5. 创建着色器对象
     Shader ourShader(VERRTEX_COLOR_PATH.c_str(), FRAG_COLOR_PATH.c_str());
     Shader pureColorShader(VERRTEX_COLOR_PATH.c_str(), PURE_COLOR_FRAG_COLOR_PATH.c_str());
+    Shader modelShader(MODEL_VERRTEX_COLOR_PATH.c_str(), MODEL_FRAG_COLOR_PATH.c_str());
+    // 延迟着色：nanosuit 先写进 G-buffer，再用一个全屏光照阶段累加点光源
+    DeferredRenderer deferred(MODEL_VERRTEX_COLOR_PATH, MODEL_GBUFFER_FRAG_PATH,
+                              DEFERRED_LIGHTING_VERTEX_PATH, DEFERRED_LIGHTING_FRAG_PATH);
+    // view/projection/相机位置放在所有程序共用的 Camera 块里，每帧只上传一次
+    CameraUniformBuffer cameraUniforms;
+    cameraUniforms.Create();
+
+    // 热重载：resource 下的着色器、贴图和模型文件保存后，在下一帧开始前原地重建，失败时继续使用旧的
+    FileWatcher watcher;
+    Shader *shaders[] = { &ourShader, &pureColorShader, &modelShader, &deferred.Geometry(), &deferred.Lighting() };
+    watcher.Watch(PROJECT_PATH + "/resource", [&](const std::string &path) {
+        TRACE_ZONE_DETAIL("hot reload", path);
+        AssetPack::Instance().Override(path); // 修改过的文件以后读松散文件
+        for (size_t i = 0; i < sizeof(shaders) / sizeof(shaders[0]); i++)
+        {
+            if (shaders[i]->Uses(path))
+                shaders[i]->Reload();
+        }
+        // 已经加载的贴图在原来的纹理上更新，不用重新导入模型；源文件、.mtl 改了，
+        // 或者改的是之前没能加载的贴图时才重新导入
+        unsigned int reloadedTextures = TextureManager::Instance().Reload(path);
+        if (ourModel.Uses(path) && reloadedTextures == 0)
+            ourModel.Reload();
+    });
     
+    // 每帧都要设置的 uniform 预先取句柄，循环里不再拼接字符串、查找名字；值没变的设置会被跳过
+    ShaderUniform<glm::mat4> ourModelMatrix = ourShader.Uniform<glm::mat4>("model");
+    ShaderUniform<glm::mat4> modelModelMatrix = modelShader.Uniform<glm::mat4>("model");
+    ShaderUniform<float> modelShininess = modelShader.Uniform<float>("material.shininess");
+    ShaderUniform<int> modelLightData = modelShader.Uniform<int>("pointLightData");
+    ShaderUniform<int> modelLightCount = modelShader.Uniform<int>("pointLightCount");
+    ShaderUniform<float> deferredShininess = deferred.Geometry().Uniform<float>("material.shininess");
+
+    // 点光源打包后整体上传到 texture buffer，光源数量不受着色器限制
+    std::vector<PointLight> pointLights(sizeof(pointLightPositions) / sizeof(pointLightPositions[0]));
+    for (size_t i = 0; i < pointLights.size(); i++)
+        pointLights[i].position = pointLightPositions[i];
+    LightBuffer lightBuffer;
+    lightBuffer.Create();
+
+    // 分簇前向渲染：每帧在 CPU 上把光源分到 16x9x24 个 cluster，着色器只循环所在 cluster 的光源
+    LightClusterer clusterer;
+    ClusterLightBuffer clusterBuffer;
+    clusterBuffer.Create();
+    ShaderUniform<bool> modelClustered = modelShader.Uniform<bool>("clusteredLighting");
+    ShaderUniform<int> modelClusterRanges = modelShader.Uniform<int>("clusterRanges");
+    ShaderUniform<int> modelClusterIndices = modelShader.Uniform<int>("clusterLightIndices");
+    ShaderUniform<glm::ivec3> modelClusterGrid = modelShader.Uniform<glm::ivec3>("clusterGrid");
+    ShaderUniform<glm::vec2> modelClusterViewport = modelShader.Uniform<glm::vec2>("clusterViewport");
+    ShaderUniform<glm::vec2> modelClusterDepth = modelShader.Uniform<glm::vec2>("clusterDepth");
+
     //循环渲染
+    TraceRecorder::Instance().Record("startup", 0, TraceRecorder::Instance().Now());
     while(!glfwWindowShouldClose(window))
     {
+        TRACE_ZONE("frame");
         float currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
         
+        {
+            TRACE_ZONE("FileWatcher::Poll");
+            watcher.Poll();
+        }
+        RenderStats::Instance().BeginFrame();
+        RenderStats::Instance().PrintEvery(currentFrame);
+
         //检测输入事件
         processInput(window);
         
@@ -217,18 +345,15 @@ int main()
         glm::mat4 view;
         view = camera.GetViewMatrix();
         glm::mat4 projection;
-        projection = glm::perspective(glm::radians(camera.Zoom), screen_width/screen_height, 0.1f, 100.0f);
+        projection = glm::perspective(glm::radians(camera.Zoom), screen_width/screen_height, near_plane, far_plane);
+        cameraUniforms.Update(view, projection, camera.m_position);
         
         ourShader.use();
-        ourShader.setMat4("view", view);
-        ourShader.setMat4("projection", projection);
 
         // floor
         glBindVertexArray(planeVAO);
-        glBindTexture(GL_TEXTURE_2D, floorTexture);
-        ourShader.setMat4("view", view);
-        ourShader.setMat4("projection", projection);
-        ourShader.setMat4("model", glm::mat4(1.0f));
+        glBindTexture(GL_TEXTURE_2D, textureId(floorTexture));
+        ourShader.Set(ourModelMatrix, glm::mat4(1.0f));
         glDrawArrays(GL_TRIANGLES, 0, 6);
         glBindVertexArray(0);
 
@@ -236,18 +361,75 @@ int main()
         glm::mat4 model = glm::mat4(1.0f);
         glBindVertexArray(cubeVAO);
         glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, cubeTexture); 	
+        glBindTexture(GL_TEXTURE_2D, textureId(cubeTexture)); 	
         model = glm::translate(model, glm::vec3(-1.0f, 0.0f, -1.0f));
-        ourShader.setMat4("model", model);
+        ourShader.Set(ourModelMatrix, model);
         glDrawArrays(GL_TRIANGLES, 0, 36);
         model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(2.0f, 0.0f, 0.0f));
-        ourShader.setMat4("model", model);
+        ourShader.Set(ourModelMatrix, model);
         glDrawArrays(GL_TRIANGLES, 0, 36);
         glBindVertexArray(0);
 
+        // nanosuit
+        model = glm::mat4(1.0f);
+        model = glm::translate(model, glm::vec3(0.0f, -0.5f, -2.5f));
+        model = glm::scale(model, glm::vec3(0.1f, 0.1f, 0.1f));
+
+        // 点光源：内容不变时 Upload 直接返回；分簇结果前向和延迟两条路径共用
+        lightBuffer.Upload(pointLights);
+        lightBuffer.Bind();
+        int framebufferWidth, framebufferHeight;
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        if (clusteredLighting)
+        {
+            TRACE_ZONE("LightClusterer::Bin");
+            clusterer.SetProjection(glm::radians(camera.Zoom), screen_width / screen_height, near_plane, far_plane);
+            clusterer.Bin(view, pointLights);
+            clusterBuffer.Upload(clusterer);
+            clusterBuffer.Bind();
+        }
+        // 远处的 mesh 使用简化过的 LOD，屏幕误差不超过 1 个像素
+        LodView lodView = LodView::Perspective(camera.m_position, glm::radians(camera.Zoom), screen_height);
+        if (deferredShading)
+        {
+            {
+                TRACE_ZONE("GBuffer geometry");
+                deferred.BeginGeometry(framebufferWidth, framebufferHeight);
+                deferred.Geometry().Set(deferredShininess, 32.0f);
+                ourModel.Draw(deferred.Geometry(), model, lodView);
+                deferred.EndGeometry();
+            }
+            {
+                TRACE_ZONE("Deferred lighting");
+                deferred.Shade(projection * view, lightBuffer.Count(), clusteredLighting ? &clusterer : nullptr);
+            }
+        }
+        else
+        {
+            modelShader.use();
+            modelShader.Set(modelModelMatrix, model);
+            modelShader.Set(modelShininess, 32.0f);
+            modelShader.Set(modelLightData, (int)LightBuffer::TEXTURE_UNIT);
+            modelShader.Set(modelLightCount, (int)lightBuffer.Count());
+            modelShader.Set(modelClustered, clusteredLighting);
+            if (clusteredLighting)
+            {
+                modelShader.Set(modelClusterRanges, (int)ClusterLightBuffer::RANGES_TEXTURE_UNIT);
+                modelShader.Set(modelClusterIndices, (int)ClusterLightBuffer::INDICES_TEXTURE_UNIT);
+                modelShader.Set(modelClusterGrid, glm::ivec3(clusterer.TilesX(), clusterer.TilesY(), clusterer.Slices()));
+                modelShader.Set(modelClusterViewport, glm::vec2(framebufferWidth, framebufferHeight));
+                modelShader.Set(modelClusterDepth, glm::vec2(clusterer.NearPlane(), clusterer.SliceScale()));
+            }
+            TRACE_ZONE("Model::Draw");
+            ourModel.Draw(modelShader, model, lodView);
+        }
+
+        // windows
+        ourShader.use();
+        glActiveTexture(GL_TEXTURE0);
         glBindVertexArray(transparentVAO);
-        glBindTexture(GL_TEXTURE_2D, windowTexture);  
+        glBindTexture(GL_TEXTURE_2D, textureId(windowTexture));  
 
         std::map<float, glm::vec3> sorted;
         for (unsigned int i = 0; i < vegetation.size(); i++) // windows contains all window positions
@@ -260,19 +442,26 @@ int main()
         {
             model = glm::mat4();
             model = glm::translate(model, it->second);
-            ourShader.setMat4("model", model);
+            ourShader.Set(ourModelMatrix, model);
             glDrawArrays(GL_TRIANGLES, 0, 6);
         }  
         glBindVertexArray(0);
 
-        glfwSwapBuffers(window);
+        TextureManager::Instance().UpdateStreaming();
+
+        {
+            TRACE_ZONE("glfwSwapBuffers");
+            glfwSwapBuffers(window);
+        }
         glfwPollEvents();
     }
-    
-    //正确释放/删除之前的分配的所有资源
-    glfwTerminate();
-    
-    return 0;
+
+    glDeleteVertexArrays(1, &cubeVAO);
+    glDeleteVertexArrays(1, &planeVAO);
+    glDeleteVertexArrays(1, &transparentVAO);
+    glDeleteBuffers(1, &cubeVBO);
+    glDeleteBuffers(1, &planeVBO);
+    glDeleteBuffers(1, &transparentVBO);
 }
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
@@ -293,6 +482,33 @@ void processInput(GLFWwindow *window)
         camera.ProcessKeyboard(LEFT, deltaTime);
     if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
         camera.ProcessKeyboard(RIGHT, deltaTime);
+
+    // 按下 C 的那一帧切换光照模式
+    static bool clusterKeyDown = false;
+    bool clusterKey = glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS;
+    if (clusterKey && !clusterKeyDown)
+    {
+        clusteredLighting = !clusteredLighting;
+        std::cout << "LIGHTING::" << (clusteredLighting ? "CLUSTERED" : "ALL_LIGHTS") << std::endl;
+    }
+    clusterKeyDown = clusterKey;
+
+    // 按下 G 的那一帧切换延迟/前向着色
+    static bool deferredKeyDown = false;
+    bool deferredKey = glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS;
+    if (deferredKey && !deferredKeyDown)
+    {
+        deferredShading = !deferredShading;
+        std::cout << "SHADING::" << (deferredShading ? "DEFERRED" : "FORWARD") << std::endl;
+    }
+    deferredKeyDown = deferredKey;
+
+    // 按下 T 的那一帧写出一次到目前为止的记录
+    static bool traceKeyDown = false;
+    bool traceKey = glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS;
+    if (traceKey && !traceKeyDown)
+        TraceRecorder::Instance().WriteJson(TRACE_PATH);
+    traceKeyDown = traceKey;
 }
 
 void draw(GLFWwindow *window)
@@ -324,40 +540,15 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 }
 
 // utility function for loading a 2D texture from file
+// 经由纹理管理器加载，重复的路径直接返回已上传的纹理
 // ---------------------------------------------------
-unsigned int loadTexture(char const *path)
+TextureHandle loadTexture(char const *path)
 {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char *data = stbi_load(path, &width, &height, &nrComponents, 0);
-    if (data)
-    {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
-    else
-    {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
+    return TextureManager::Instance().Load(path, 0, GL_CLAMP_TO_EDGE);
+}
 
-    return textureID;
+// 加载失败时句柄为空（TextureManager 已经报错），绑定 0 号纹理继续绘制
+unsigned int textureId(const TextureHandle &texture)
+{
+    return texture ? texture->id : 0;
 }
@@ -0,0 +1,110 @@
+#include "mappedFile.h"
+
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <cstdio>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+bool MappedFile::Stat(const std::string &path, uint64_t &size, int64_t &mtime)
+{
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0)
+        return false;
+    size = (uint64_t)info.st_size;
+    mtime = (int64_t)info.st_mtime;
+    return true;
+}
+
+MappedFile::MappedFile() : _data(nullptr), _size(0)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::Open(const std::string &path, bool prefetch)
+{
+    Close();
+#ifdef _WIN32
+    (void)prefetch;
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    _buffer.resize(size > 0 ? (size_t)size : 0);
+    size_t read = _buffer.empty() ? 0 : fread(&_buffer[0], 1, _buffer.size(), file);
+    fclose(file);
+    if (read != _buffer.size())
+    {
+        _buffer.clear();
+        return false;
+    }
+    _data = _buffer.empty() ? nullptr : &_buffer[0];
+    _size = _buffer.size();
+    return true;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    void *mapped = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // 映射建立后文件描述符就可以关闭了
+    if (mapped == MAP_FAILED)
+        return false;
+
+    if (prefetch)
+        madvise(mapped, (size_t)info.st_size, MADV_WILLNEED);
+
+    _data = static_cast<const unsigned char *>(mapped);
+    _size = (size_t)info.st_size;
+    return true;
+#endif
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+    _buffer.clear();
+#else
+    if (_data)
+        munmap(const_cast<unsigned char *>(_data), _size);
+#endif
+    _data = nullptr;
+    _size = 0;
+}
+
+bool MappedFile::IsOpen() const
+{
+    return _data != nullptr;
+}
+
+const unsigned char *MappedFile::Data() const
+{
+    return _data;
+}
+
+const char *MappedFile::Chars() const
+{
+    return reinterpret_cast<const char *>(_data);
+}
+
+size_t MappedFile::Size() const
+{
+    return _size;
+}
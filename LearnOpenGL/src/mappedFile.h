@@ -0,0 +1,41 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// 只读的内存映射文件，析构时自动解除映射。
+// 读取着色器源码、解码图片等场景直接使用映射的字节，省掉 stdio/ifstream 的缓冲拷贝
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    // 读取文件大小和修改时间，供各种磁盘缓存判断源文件是否变化
+    static bool Stat(const std::string &path, uint64_t &size, int64_t &mtime);
+
+    // prefetch 为 true 时提示内核马上会完整读一遍（madvise WILLNEED），冷缓存时提前发起预读
+    bool Open(const std::string &path, bool prefetch = false);
+    void Close();
+
+    bool IsOpen() const;
+    const unsigned char *Data() const;
+    const char *Chars() const; // 文本文件用，注意映射的内容没有结尾的 '\0'
+    size_t Size() const;
+
+private:
+    MappedFile(const MappedFile &);
+    MappedFile &operator=(const MappedFile &);
+
+private:
+    const unsigned char *_data;
+    size_t _size;
+#ifdef _WIN32
+    std::vector<unsigned char> _buffer; // 没有mmap的平台上退化为整体读入
+#endif
+};
+
+#endif
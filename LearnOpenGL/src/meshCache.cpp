@@ -0,0 +1,444 @@
+#include "meshCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+    const char MESH_CACHE_MAGIC[8] = { 'L', 'O', 'G', 'L', 'M', 'S', 'H', '\0' };
+
+    uint64_t alignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    void writePadding(FILE *file, uint64_t &offset, uint64_t alignment)
+    {
+        static const char zeros[16] = { 0 };
+        uint64_t aligned = alignUp(offset, alignment);
+        fwrite(zeros, 1, (size_t)(aligned - offset), file);
+        offset = aligned;
+    }
+
+    // [offset, offset + count * recordSize) 是否落在 end 之内，先除再比较避免溢出
+    bool fits(uint64_t offset, uint64_t count, uint64_t recordSize, uint64_t end)
+    {
+        return offset <= end && count <= (end - offset) / recordSize;
+    }
+
+    bool fitsString(uint32_t offset, uint32_t length, uint64_t stringSize)
+    {
+        return (uint64_t)offset + length <= stringSize;
+    }
+}
+
+std::string MeshCache::PathFor(const std::string &sourcePath)
+{
+    return sourcePath + ".meshcache";
+}
+
+void MeshCache::RecordDependency(ModelData &data, const std::string &path)
+{
+    for (size_t i = 0; i < data.dependencies.size(); i++)
+    {
+        if (data.dependencies[i].path == path)
+            return;
+    }
+    ModelDependency dependency;
+    dependency.path = path;
+    dependency.size = 0;
+    dependency.mtime = 0;
+    dependency.exists = AssetPack::Instance().Stamp(data.directory + "/" + path, dependency.size, dependency.mtime);
+    data.dependencies.push_back(dependency);
+}
+
+bool MeshCache::Write(const std::string &sourcePath, const std::vector<MeshData> &meshes, const std::vector<NodeData> &nodes,
+                      const std::vector<ModelDependency> &dependencies, uint32_t buildFlags, uint64_t sourceSize, int64_t sourceMtime)
+{
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.vertexSize = sizeof(Vertex);
+    header.buildFlags = buildFlags;
+    header.sourceSize = sourceSize;
+    header.sourceMtime = sourceMtime;
+
+    // 先在内存里排好 mesh 表、贴图表和字符串表
+    std::vector<MeshRecord> meshTable;
+    std::vector<TextureRecord> textureTable;
+    std::vector<MeshLod> lodTable;
+    std::string strings;
+    uint32_t vertexCount = 0, indexCount = 0;
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        const MeshData &mesh = meshes[i];
+        MeshRecord record;
+        record.firstVertex = vertexCount;
+        record.vertexCount = (uint32_t)mesh.vertices.size();
+        record.firstIndex = indexCount;
+        record.indexCount = (uint32_t)mesh.indices.size();
+        record.firstTexture = (uint32_t)textureTable.size();
+        record.textureCount = (uint32_t)mesh.textures.size();
+        record.firstLod = (uint32_t)lodTable.size();
+        record.lodCount = (uint32_t)mesh.lods.size();
+        record.node = mesh.node;
+        record.reserved = 0;
+        meshTable.push_back(record);
+        lodTable.insert(lodTable.end(), mesh.lods.begin(), mesh.lods.end());
+        vertexCount += record.vertexCount;
+        indexCount += record.indexCount;
+
+        for (size_t t = 0; t < mesh.textures.size(); t++)
+        {
+            TextureRecord texture;
+            texture.typeOffset = (uint32_t)strings.size();
+            texture.typeLength = (uint32_t)mesh.textures[t].type.size();
+            strings += mesh.textures[t].type;
+            texture.pathOffset = (uint32_t)strings.size();
+            texture.pathLength = (uint32_t)mesh.textures[t].path.size();
+            strings += mesh.textures[t].path;
+            textureTable.push_back(texture);
+        }
+    }
+
+    std::vector<NodeRecord> nodeTable(nodes.size());
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        NodeRecord &record = nodeTable[i];
+        record.parent = nodes[i].parent;
+        record.nameOffset = (uint32_t)strings.size();
+        record.nameLength = (uint32_t)nodes[i].name.size();
+        record.reserved = 0;
+        memcpy(record.transform, &nodes[i].transform[0][0], sizeof(record.transform));
+        strings += nodes[i].name;
+    }
+
+    std::vector<DependencyRecord> dependencyTable(dependencies.size());
+    for (size_t i = 0; i < dependencies.size(); i++)
+    {
+        DependencyRecord &record = dependencyTable[i];
+        record.pathOffset = (uint32_t)strings.size();
+        record.pathLength = (uint32_t)dependencies[i].path.size();
+        record.exists = dependencies[i].exists ? 1 : 0;
+        record.reserved = 0;
+        record.size = dependencies[i].size;
+        record.mtime = dependencies[i].mtime;
+        strings += dependencies[i].path;
+    }
+
+    header.meshCount = (uint32_t)meshTable.size();
+    header.textureCount = (uint32_t)textureTable.size();
+    header.lodCount = (uint32_t)lodTable.size();
+    header.nodeCount = (uint32_t)nodeTable.size();
+    header.dependencyCount = (uint32_t)dependencyTable.size();
+    header.meshTableOffset = alignUp(sizeof(Header), 16);
+    header.textureTableOffset = alignUp(header.meshTableOffset + meshTable.size() * sizeof(MeshRecord), 16);
+    header.lodTableOffset = alignUp(header.textureTableOffset + textureTable.size() * sizeof(TextureRecord), 16);
+    header.nodeTableOffset = alignUp(header.lodTableOffset + lodTable.size() * sizeof(MeshLod), 16);
+    header.dependencyTableOffset = alignUp(header.nodeTableOffset + nodeTable.size() * sizeof(NodeRecord), 16);
+    header.vertexDataOffset = alignUp(header.dependencyTableOffset + dependencyTable.size() * sizeof(DependencyRecord), 16);
+    header.indexDataOffset = alignUp(header.vertexDataOffset + (uint64_t)vertexCount * sizeof(Vertex), 16);
+    header.stringDataOffset = alignUp(header.indexDataOffset + (uint64_t)indexCount * sizeof(unsigned int), 16);
+    header.fileSize = header.stringDataOffset + strings.size();
+
+    // 写到临时文件再改名，避免另一个进程读到写了一半的缓存
+    std::string cachePath = PathFor(sourcePath);
+    std::string tempPath = cachePath + ".tmp";
+    FILE *file = fopen(tempPath.c_str(), "wb");
+    if (!file)
+    {
+        std::cout << "ERROR::MESH_CACHE::CANNOT_WRITE " << tempPath << std::endl;
+        return false;
+    }
+
+    uint64_t offset = 0;
+    fwrite(&header, sizeof(Header), 1, file);
+    offset += sizeof(Header);
+    writePadding(file, offset, 16);
+    if (!meshTable.empty())
+        fwrite(&meshTable[0], sizeof(MeshRecord), meshTable.size(), file);
+    offset += meshTable.size() * sizeof(MeshRecord);
+    writePadding(file, offset, 16);
+    if (!textureTable.empty())
+        fwrite(&textureTable[0], sizeof(TextureRecord), textureTable.size(), file);
+    offset += textureTable.size() * sizeof(TextureRecord);
+    writePadding(file, offset, 16);
+    if (!lodTable.empty())
+        fwrite(&lodTable[0], sizeof(MeshLod), lodTable.size(), file);
+    offset += lodTable.size() * sizeof(MeshLod);
+    writePadding(file, offset, 16);
+    if (!nodeTable.empty())
+        fwrite(&nodeTable[0], sizeof(NodeRecord), nodeTable.size(), file);
+    offset += nodeTable.size() * sizeof(NodeRecord);
+    writePadding(file, offset, 16);
+    if (!dependencyTable.empty())
+        fwrite(&dependencyTable[0], sizeof(DependencyRecord), dependencyTable.size(), file);
+    offset += dependencyTable.size() * sizeof(DependencyRecord);
+    writePadding(file, offset, 16);
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        if (!meshes[i].vertices.empty())
+            fwrite(&meshes[i].vertices[0], sizeof(Vertex), meshes[i].vertices.size(), file);
+        offset += meshes[i].vertices.size() * sizeof(Vertex);
+    }
+    writePadding(file, offset, 16);
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        if (!meshes[i].indices.empty())
+            fwrite(&meshes[i].indices[0], sizeof(unsigned int), meshes[i].indices.size(), file);
+        offset += meshes[i].indices.size() * sizeof(unsigned int);
+    }
+    writePadding(file, offset, 16);
+    fwrite(strings.data(), 1, strings.size(), file);
+    offset += strings.size();
+
+    bool ok = ferror(file) == 0 && offset == header.fileSize;
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(tempPath.c_str(), cachePath.c_str()) != 0)
+    {
+        std::cout << "ERROR::MESH_CACHE::CANNOT_WRITE " << cachePath << std::endl;
+        remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+MeshCache::MeshCache() :
+    _header(nullptr), _meshes(nullptr), _textures(nullptr), _lods(nullptr), _nodes(nullptr), _dependencies(nullptr),
+    _vertices(nullptr), _indices(nullptr), _strings(nullptr)
+{
+}
+
+bool MeshCache::valid(const AssetSpan &file, const std::string &directory, bool hasSource, uint64_t sourceSize, int64_t sourceMtime,
+                      uint32_t buildFlags)
+{
+    if (file.size < sizeof(Header))
+        return false;
+    const Header *header = reinterpret_cast<const Header *>(file.data);
+    if (memcmp(header->magic, MESH_CACHE_MAGIC, sizeof(header->magic)) != 0
+        || header->version != VERSION
+        || header->vertexSize != sizeof(Vertex)
+        || header->fileSize != file.size
+        || header->buildFlags != buildFlags)
+    {
+        return false;
+    }
+    // 源文件已经修改过
+    if (hasSource && (header->sourceSize != sourceSize || header->sourceMtime != sourceMtime))
+        return false;
+    if (!validTables(file.data, *header))
+    {
+        std::cout << "ERROR::MESH_CACHE::CORRUPT_TABLES" << std::endl;
+        return false;
+    }
+    // 附属文件（.mtl 等）出现、消失或修改过
+    const DependencyRecord *dependencies = reinterpret_cast<const DependencyRecord *>(file.data + header->dependencyTableOffset);
+    const char *strings = reinterpret_cast<const char *>(file.data + header->stringDataOffset);
+    for (uint32_t i = 0; i < header->dependencyCount; i++)
+    {
+        const DependencyRecord &dependency = dependencies[i];
+        uint64_t size = 0;
+        int64_t mtime = 0;
+        std::string path = directory + "/" + std::string(strings + dependency.pathOffset, dependency.pathLength);
+        bool exists = AssetPack::Instance().Stamp(path, size, mtime);
+        if (exists != (dependency.exists != 0) || (exists && (size != dependency.size || mtime != dependency.mtime)))
+            return false;
+    }
+    return true;
+}
+
+bool MeshCache::validTables(const unsigned char *data, const Header &header)
+{
+    // 各段按写入时的顺序排列并 16 字节对齐：表在前，之后依次是顶点、索引和字符串，字符串一直到文件末尾
+    const uint64_t offsets[] = { header.meshTableOffset, header.textureTableOffset, header.lodTableOffset, header.nodeTableOffset,
+                                 header.dependencyTableOffset, header.vertexDataOffset, header.indexDataOffset, header.stringDataOffset };
+    for (size_t i = 0; i < sizeof(offsets) / sizeof(offsets[0]); i++)
+    {
+        if (offsets[i] % 16 != 0 || offsets[i] < sizeof(Header))
+            return false;
+    }
+    if (header.vertexDataOffset > header.indexDataOffset
+        || header.indexDataOffset > header.stringDataOffset
+        || header.stringDataOffset > header.fileSize)
+    {
+        return false;
+    }
+    if (!fits(header.meshTableOffset, header.meshCount, sizeof(MeshRecord), header.vertexDataOffset)
+        || !fits(header.textureTableOffset, header.textureCount, sizeof(TextureRecord), header.vertexDataOffset)
+        || !fits(header.lodTableOffset, header.lodCount, sizeof(MeshLod), header.vertexDataOffset)
+        || !fits(header.nodeTableOffset, header.nodeCount, sizeof(NodeRecord), header.vertexDataOffset)
+        || !fits(header.dependencyTableOffset, header.dependencyCount, sizeof(DependencyRecord), header.vertexDataOffset))
+    {
+        return false;
+    }
+
+    uint64_t vertexTotal = (header.indexDataOffset - header.vertexDataOffset) / sizeof(Vertex);
+    uint64_t indexTotal = (header.stringDataOffset - header.indexDataOffset) / sizeof(unsigned int);
+    uint64_t stringSize = header.fileSize - header.stringDataOffset;
+    const MeshRecord *meshes = reinterpret_cast<const MeshRecord *>(data + header.meshTableOffset);
+    const TextureRecord *textures = reinterpret_cast<const TextureRecord *>(data + header.textureTableOffset);
+    const MeshLod *lods = reinterpret_cast<const MeshLod *>(data + header.lodTableOffset);
+    const NodeRecord *nodes = reinterpret_cast<const NodeRecord *>(data + header.nodeTableOffset);
+    const DependencyRecord *dependencies = reinterpret_cast<const DependencyRecord *>(data + header.dependencyTableOffset);
+
+    for (uint32_t i = 0; i < header.meshCount; i++)
+    {
+        const MeshRecord &mesh = meshes[i];
+        if ((uint64_t)mesh.firstVertex + mesh.vertexCount > vertexTotal
+            || (uint64_t)mesh.firstIndex + mesh.indexCount > indexTotal
+            || (uint64_t)mesh.firstTexture + mesh.textureCount > header.textureCount
+            || (uint64_t)mesh.firstLod + mesh.lodCount > header.lodCount
+            || (mesh.node >= header.nodeCount && mesh.node != 0))
+        {
+            return false;
+        }
+        // LOD 的索引区间相对于mesh自己的索引
+        for (uint32_t l = 0; l < mesh.lodCount; l++)
+        {
+            const MeshLod &lod = lods[mesh.firstLod + l];
+            if ((uint64_t)lod.firstIndex + lod.indexCount > mesh.indexCount)
+                return false;
+        }
+    }
+    for (uint32_t i = 0; i < header.textureCount; i++)
+    {
+        if (!fitsString(textures[i].typeOffset, textures[i].typeLength, stringSize)
+            || !fitsString(textures[i].pathOffset, textures[i].pathLength, stringSize))
+        {
+            return false;
+        }
+    }
+    // 父节点总在子节点之前
+    for (uint32_t i = 0; i < header.nodeCount; i++)
+    {
+        if (nodes[i].parent < -1 || nodes[i].parent >= (int32_t)i
+            || !fitsString(nodes[i].nameOffset, nodes[i].nameLength, stringSize))
+        {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < header.dependencyCount; i++)
+    {
+        if (!fitsString(dependencies[i].pathOffset, dependencies[i].pathLength, stringSize))
+            return false;
+    }
+    return true;
+}
+
+bool MeshCache::Open(const std::string &sourcePath, uint32_t buildFlags)
+{
+    // 资源包里打包了缓存时直接使用包里的映射，和源文件的来源（松散文件存在时是它，否则是包里的）
+    // 比较是否过期，过期的话退回源文件旁边的缓存
+    uint64_t sourceSize;
+    int64_t sourceMtime;
+    bool hasSource = AssetPack::Instance().Stamp(sourcePath, sourceSize, sourceMtime);
+    std::string directory = sourcePath.substr(0, sourcePath.find_last_of('/'));
+
+    AssetSpan file;
+    if (!AssetPack::Instance().Find(PathFor(sourcePath), file) || !valid(file, directory, hasSource, sourceSize, sourceMtime, buildFlags))
+    {
+        if (!hasSource || !_file.Open(PathFor(sourcePath)))
+            return false;
+        file.data = _file.Data();
+        file.size = _file.Size();
+        if (!valid(file, directory, true, sourceSize, sourceMtime, buildFlags))
+        {
+            _file.Close();
+            return false;
+        }
+    }
+
+    const unsigned char *data = file.data;
+    const Header *header = reinterpret_cast<const Header *>(data);
+
+    _header = header;
+    _meshes = reinterpret_cast<const MeshRecord *>(data + header->meshTableOffset);
+    _textures = reinterpret_cast<const TextureRecord *>(data + header->textureTableOffset);
+    _lods = reinterpret_cast<const MeshLod *>(data + header->lodTableOffset);
+    _nodes = reinterpret_cast<const NodeRecord *>(data + header->nodeTableOffset);
+    _dependencies = reinterpret_cast<const DependencyRecord *>(data + header->dependencyTableOffset);
+    _vertices = reinterpret_cast<const Vertex *>(data + header->vertexDataOffset);
+    _indices = reinterpret_cast<const unsigned int *>(data + header->indexDataOffset);
+    _strings = reinterpret_cast<const char *>(data + header->stringDataOffset);
+    return true;
+}
+
+unsigned int MeshCache::MeshCount() const
+{
+    return _header ? _header->meshCount : 0;
+}
+
+const Vertex *MeshCache::Vertices(unsigned int mesh) const
+{
+    return _vertices + _meshes[mesh].firstVertex;
+}
+
+unsigned int MeshCache::VertexCount(unsigned int mesh) const
+{
+    return _meshes[mesh].vertexCount;
+}
+
+const unsigned int *MeshCache::Indices(unsigned int mesh) const
+{
+    return _indices + _meshes[mesh].firstIndex;
+}
+
+unsigned int MeshCache::IndexCount(unsigned int mesh) const
+{
+    return _meshes[mesh].indexCount;
+}
+
+std::vector<TextureRef> MeshCache::Textures(unsigned int mesh) const
+{
+    std::vector<TextureRef> textures;
+    const MeshRecord &record = _meshes[mesh];
+    for (uint32_t i = 0; i < record.textureCount; i++)
+    {
+        const TextureRecord &texture = _textures[record.firstTexture + i];
+        TextureRef entry;
+        entry.type.assign(_strings + texture.typeOffset, texture.typeLength);
+        entry.path.assign(_strings + texture.pathOffset, texture.pathLength);
+        textures.push_back(entry);
+    }
+    return textures;
+}
+
+std::vector<MeshLod> MeshCache::Lods(unsigned int mesh) const
+{
+    const MeshRecord &record = _meshes[mesh];
+    return std::vector<MeshLod>(_lods + record.firstLod, _lods + record.firstLod + record.lodCount);
+}
+
+unsigned int MeshCache::Node(unsigned int mesh) const
+{
+    return _meshes[mesh].node;
+}
+
+std::vector<NodeData> MeshCache::Nodes() const
+{
+    std::vector<NodeData> nodes(_header ? _header->nodeCount : 0);
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        const NodeRecord &record = _nodes[i];
+        nodes[i].parent = record.parent;
+        memcpy(&nodes[i].transform[0][0], record.transform, sizeof(record.transform));
+        nodes[i].name.assign(_strings + record.nameOffset, record.nameLength);
+    }
+    return nodes;
+}
+
+std::vector<ModelDependency> MeshCache::Dependencies() const
+{
+    std::vector<ModelDependency> dependencies(_header ? _header->dependencyCount : 0);
+    for (size_t i = 0; i < dependencies.size(); i++)
+    {
+        const DependencyRecord &record = _dependencies[i];
+        dependencies[i].path.assign(_strings + record.pathOffset, record.pathLength);
+        dependencies[i].exists = record.exists != 0;
+        dependencies[i].size = record.size;
+        dependencies[i].mtime = record.mtime;
+    }
+    return dependencies;
+}
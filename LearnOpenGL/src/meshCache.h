@@ -0,0 +1,132 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include "mappedFile.h"
+#include "assetPack.h"
+#include "model.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// 模型的二进制缓存：第一次通过Assimp导入后，在源文件旁边写一个 .meshcache，
+// 里面是可以直接上传的交错顶点数据、索引数据、mesh表和材质贴图引用。
+// 之后启动时 mmap 这个文件，跳过Assimp的解析。源文件或它引用的 .mtl 等附属文件的大小、修改时间变化后缓存失效；
+// 生成数据时用的 ModelLoadFlags（优化、LOD、导入器）也记在头里，和这次加载要求的不一致时不使用
+class MeshCache
+{
+public:
+    static const uint32_t VERSION = 6; // 2: 数据经过 MeshOptimizer 优化  3: 增加 LOD 表  4: 增加节点层级  5: 记录 buildFlags  6: 附属文件表
+
+    static std::string PathFor(const std::string &sourcePath);
+    // buildFlags 是影响缓存内容的 ModelLoadFlags：MODEL_LOAD_OPTIMIZE、MODEL_LOAD_LODS，
+    // 以及数据实际由 ObjLoader 导入时的 MODEL_LOAD_NATIVE_OBJ
+    // sourceSize/sourceMtime 是导入之前用 AssetPack::Stamp 取得的，记录的是实际读到的源文件
+    static bool Write(const std::string &sourcePath, const std::vector<MeshData> &meshes, const std::vector<NodeData> &nodes,
+                      const std::vector<ModelDependency> &dependencies, uint32_t buildFlags, uint64_t sourceSize, int64_t sourceMtime);
+    // 导入器读取附属文件之前调用：记下 data.directory 下 path 现在的大小和修改时间，同一个文件只记一次
+    static void RecordDependency(ModelData &data, const std::string &path);
+
+    MeshCache();
+
+    // 映射缓存文件并校验版本、源文件和附属文件的信息、buildFlags 和各个表的范围，
+    // 缓存不存在、已过期、生成方式不同或已损坏时返回 false
+    bool Open(const std::string &sourcePath, uint32_t buildFlags);
+
+    unsigned int MeshCount() const;
+    const Vertex *Vertices(unsigned int mesh) const;
+    unsigned int VertexCount(unsigned int mesh) const;
+    const unsigned int *Indices(unsigned int mesh) const;
+    unsigned int IndexCount(unsigned int mesh) const;
+    std::vector<TextureRef> Textures(unsigned int mesh) const;
+    std::vector<MeshLod> Lods(unsigned int mesh) const;
+    unsigned int Node(unsigned int mesh) const;
+    std::vector<NodeData> Nodes() const;
+    std::vector<ModelDependency> Dependencies() const;
+
+public:
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t vertexSize;  // sizeof(Vertex)，布局变化时缓存自动失效
+        uint64_t sourceSize;
+        int64_t sourceMtime;
+        uint32_t meshCount;
+        uint32_t textureCount;
+        uint32_t lodCount;
+        uint32_t nodeCount;
+        uint32_t buildFlags;
+        uint32_t dependencyCount;
+        uint64_t meshTableOffset;
+        uint64_t textureTableOffset;
+        uint64_t lodTableOffset;
+        uint64_t nodeTableOffset;
+        uint64_t dependencyTableOffset;
+        uint64_t vertexDataOffset;
+        uint64_t indexDataOffset;
+        uint64_t stringDataOffset;
+        uint64_t fileSize;
+    };
+
+    struct MeshRecord
+    {
+        uint32_t firstVertex;
+        uint32_t vertexCount;
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        uint32_t firstTexture;
+        uint32_t textureCount;
+        uint32_t firstLod;
+        uint32_t lodCount;
+        uint32_t node;
+        uint32_t reserved;
+    };
+
+    struct NodeRecord
+    {
+        int32_t parent;
+        uint32_t nameOffset;
+        uint32_t nameLength;
+        uint32_t reserved;
+        float transform[16]; // 列主序，与 glm::mat4 相同
+    };
+
+    struct TextureRecord
+    {
+        uint32_t typeOffset;
+        uint32_t typeLength;
+        uint32_t pathOffset;
+        uint32_t pathLength;
+    };
+
+    struct DependencyRecord
+    {
+        uint32_t pathOffset;
+        uint32_t pathLength;
+        uint32_t exists;
+        uint32_t reserved;
+        uint64_t size;
+        int64_t mtime;
+    };
+
+private:
+    static bool valid(const AssetSpan &file, const std::string &directory, bool hasSource, uint64_t sourceSize, int64_t sourceMtime,
+                      uint32_t buildFlags);
+    // 所有表、数据段和每条记录引用的区间都在文件范围内
+    static bool validTables(const unsigned char *data, const Header &header);
+
+private:
+    MappedFile _file;
+    const Header *_header;
+    const MeshRecord *_meshes;
+    const TextureRecord *_textures;
+    const MeshLod *_lods;
+    const NodeRecord *_nodes;
+    const DependencyRecord *_dependencies;
+    const Vertex *_vertices;
+    const unsigned int *_indices;
+    const char *_strings;
+};
+
+#endif
@@ -0,0 +1,276 @@
+#include "meshOptimizer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+namespace
+{
+    struct VertexHash
+    {
+        size_t operator()(const Vertex &vertex) const
+        {
+            // FNV-1a，Vertex 是 8 个紧密排列的 float，没有填充字节
+            const unsigned char *bytes = reinterpret_cast<const unsigned char *>(&vertex);
+            size_t hash = 2166136261u;
+            for (size_t i = 0; i < sizeof(Vertex); i++)
+                hash = (hash ^ bytes[i]) * 16777619u;
+            return hash;
+        }
+    };
+
+    struct VertexEqual
+    {
+        bool operator()(const Vertex &a, const Vertex &b) const
+        {
+            return memcmp(&a, &b, sizeof(Vertex)) == 0;
+        }
+    };
+
+    // 从死胡同栈或者按顺序扫描找下一个还有未输出三角形的顶点
+    int skipDeadEnd(std::vector<unsigned int> &deadEnds, const std::vector<unsigned int> &liveTriangles, size_t &cursor)
+    {
+        while (!deadEnds.empty())
+        {
+            unsigned int vertex = deadEnds.back();
+            deadEnds.pop_back();
+            if (liveTriangles[vertex] > 0)
+                return (int)vertex;
+        }
+        while (cursor < liveTriangles.size())
+        {
+            if (liveTriangles[cursor] > 0)
+                return (int)cursor++;
+            cursor++;
+        }
+        return -1;
+    }
+}
+
+void MeshOptimizer::Optimize(MeshData &mesh)
+{
+    if (mesh.indices.empty())
+        return;
+
+    DeduplicateVertices(mesh);
+    std::vector<unsigned int> clusters;
+    OptimizeVertexCache(mesh.indices, mesh.vertices.size(), clusters);
+    OptimizeOverdraw(mesh.indices, mesh.vertices, clusters);
+    OptimizeVertexFetch(mesh);
+}
+
+void MeshOptimizer::DeduplicateVertices(MeshData &mesh)
+{
+    std::unordered_map<Vertex, unsigned int, VertexHash, VertexEqual> unique;
+    unique.reserve(mesh.vertices.size());
+
+    std::vector<Vertex> vertices;
+    vertices.reserve(mesh.vertices.size());
+    std::vector<unsigned int> remap(mesh.vertices.size());
+    for (size_t i = 0; i < mesh.vertices.size(); i++)
+    {
+        std::pair<std::unordered_map<Vertex, unsigned int, VertexHash, VertexEqual>::iterator, bool> inserted =
+            unique.insert(std::make_pair(mesh.vertices[i], (unsigned int)vertices.size()));
+        if (inserted.second)
+            vertices.push_back(mesh.vertices[i]);
+        remap[i] = inserted.first->second;
+    }
+
+    for (size_t i = 0; i < mesh.indices.size(); i++)
+        mesh.indices[i] = remap[mesh.indices[i]];
+    mesh.vertices.swap(vertices);
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<unsigned int> &indices, size_t vertexCount, std::vector<unsigned int> &clusters)
+{
+    // Tipsify (Sander, Nehab, Barczak 2007)
+    size_t triangleCount = indices.size() / 3;
+    clusters.clear();
+
+    // 每个顶点相邻的三角形列表（CSR 格式）
+    std::vector<unsigned int> liveTriangles(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; i++)
+        liveTriangles[indices[i]]++;
+    std::vector<unsigned int> adjacencyOffset(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++)
+        adjacencyOffset[v + 1] = adjacencyOffset[v] + liveTriangles[v];
+    std::vector<unsigned int> adjacency(adjacencyOffset[vertexCount]);
+    std::vector<unsigned int> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+    for (size_t t = 0; t < triangleCount; t++)
+        for (int k = 0; k < 3; k++)
+            adjacency[fill[indices[t * 3 + k]]++] = (unsigned int)t;
+
+    std::vector<unsigned int> cacheTime(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<unsigned int> deadEnds;
+    std::vector<unsigned int> candidates;
+    std::vector<unsigned int> output;
+    output.reserve(triangleCount * 3);
+
+    unsigned int timestamp = CACHE_SIZE + 1;
+    size_t cursor = 0;
+    int fanning = skipDeadEnd(deadEnds, liveTriangles, cursor);
+    bool newCluster = true;
+    while (fanning >= 0)
+    {
+        if (newCluster)
+        {
+            clusters.push_back((unsigned int)(output.size() / 3));
+            newCluster = false;
+        }
+
+        candidates.clear();
+        for (unsigned int a = adjacencyOffset[fanning]; a < adjacencyOffset[fanning + 1]; a++)
+        {
+            unsigned int triangle = adjacency[a];
+            if (emitted[triangle])
+                continue;
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned int vertex = indices[triangle * 3 + k];
+                output.push_back(vertex);
+                deadEnds.push_back(vertex);
+                candidates.push_back(vertex);
+                liveTriangles[vertex]--;
+                if (timestamp - cacheTime[vertex] > CACHE_SIZE)
+                    cacheTime[vertex] = timestamp++;
+            }
+            emitted[triangle] = true;
+        }
+
+        // 优先选择仍在缓存中、且剩余三角形不多的候选顶点
+        int next = -1, bestPriority = -1;
+        for (size_t c = 0; c < candidates.size(); c++)
+        {
+            unsigned int vertex = candidates[c];
+            if (liveTriangles[vertex] == 0)
+                continue;
+            int priority = 0;
+            if (timestamp - cacheTime[vertex] + 2 * liveTriangles[vertex] <= CACHE_SIZE)
+                priority = (int)(timestamp - cacheTime[vertex]);
+            if (priority > bestPriority)
+            {
+                bestPriority = priority;
+                next = (int)vertex;
+            }
+        }
+        if (next < 0)
+        {
+            // 走进死胡同，缓存局部性在这里断开，正好作为 overdraw 排序的簇边界
+            next = skipDeadEnd(deadEnds, liveTriangles, cursor);
+            newCluster = true;
+        }
+        fanning = next;
+    }
+
+    // 退化输入（比如索引数不是3的倍数）时保留尾部
+    output.insert(output.end(), indices.begin() + triangleCount * 3, indices.end());
+    indices.swap(output);
+}
+
+void MeshOptimizer::OptimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<Vertex> &vertices, const std::vector<unsigned int> &clusters)
+{
+    size_t triangleCount = indices.size() / 3;
+    if (clusters.size() < 2)
+        return;
+
+    // 整个mesh的面积加权中心
+    glm::vec3 meshCenter(0.0f);
+    float meshArea = 0.0f;
+    std::vector<glm::vec3> clusterCenter(clusters.size(), glm::vec3(0.0f));
+    std::vector<glm::vec3> clusterNormal(clusters.size(), glm::vec3(0.0f));
+    std::vector<float> clusterArea(clusters.size(), 0.0f);
+    for (size_t c = 0; c < clusters.size(); c++)
+    {
+        size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+        for (size_t t = clusters[c]; t < end; t++)
+        {
+            const glm::vec3 &p0 = vertices[indices[t * 3 + 0]].Position;
+            const glm::vec3 &p1 = vertices[indices[t * 3 + 1]].Position;
+            const glm::vec3 &p2 = vertices[indices[t * 3 + 2]].Position;
+            glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            float area = glm::length(normal);
+            clusterCenter[c] += (p0 + p1 + p2) / 3.0f * area;
+            clusterNormal[c] += normal;
+            clusterArea[c] += area;
+        }
+        meshCenter += clusterCenter[c];
+        meshArea += clusterArea[c];
+    }
+    if (meshArea <= 0.0f)
+        return;
+    meshCenter /= meshArea;
+
+    // 朝外程度：簇中心相对模型中心的方向与簇法线的点积，越大越应该先画
+    std::vector<std::pair<float, unsigned int> > order(clusters.size());
+    for (size_t c = 0; c < clusters.size(); c++)
+    {
+        float score = 0.0f;
+        float normalLength = glm::length(clusterNormal[c]);
+        if (clusterArea[c] > 0.0f && normalLength > 0.0f)
+            score = glm::dot(clusterCenter[c] / clusterArea[c] - meshCenter, clusterNormal[c] / normalLength);
+        order[c] = std::make_pair(-score, (unsigned int)c);
+    }
+    std::stable_sort(order.begin(), order.end());
+
+    std::vector<unsigned int> sorted;
+    sorted.reserve(indices.size());
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        unsigned int c = order[i].second;
+        size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+        sorted.insert(sorted.end(), indices.begin() + clusters[c] * 3, indices.begin() + end * 3);
+    }
+    sorted.insert(sorted.end(), indices.begin() + triangleCount * 3, indices.end());
+    indices.swap(sorted);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(MeshData &mesh)
+{
+    const unsigned int UNUSED = ~0u;
+    std::vector<unsigned int> remap(mesh.vertices.size(), UNUSED);
+    std::vector<Vertex> vertices;
+    vertices.reserve(mesh.vertices.size());
+    for (size_t i = 0; i < mesh.indices.size(); i++)
+    {
+        unsigned int &target = remap[mesh.indices[i]];
+        if (target == UNUSED)
+        {
+            target = (unsigned int)vertices.size();
+            vertices.push_back(mesh.vertices[mesh.indices[i]]);
+        }
+        mesh.indices[i] = target;
+    }
+    mesh.vertices.swap(vertices);
+}
+
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const std::vector<unsigned int> &indices, size_t vertexCount, unsigned int cacheSize)
+{
+    VertexCacheStats stats;
+    stats.acmr = 0.0f;
+    stats.atvr = 0.0f;
+    if (indices.size() < 3)
+        return stats;
+
+    // FIFO 缓存：记录每个顶点进入缓存时的序号，序号差不超过缓存大小即命中
+    std::vector<unsigned int> cachedAt(vertexCount, 0);
+    std::vector<bool> referenced(vertexCount, false);
+    unsigned int misses = 0, uniqueVertices = 0;
+    for (size_t i = 0; i < indices.size(); i++)
+    {
+        unsigned int vertex = indices[i];
+        if (!referenced[vertex])
+        {
+            referenced[vertex] = true;
+            uniqueVertices++;
+        }
+        if (cachedAt[vertex] == 0 || misses + 1 - cachedAt[vertex] > cacheSize)
+        {
+            misses++;
+            cachedAt[vertex] = misses;
+        }
+    }
+    stats.acmr = (float)misses / (float)(indices.size() / 3);
+    stats.atvr = uniqueVertices > 0 ? (float)misses / (float)uniqueVertices : 0.0f;
+    return stats;
+}
@@ -0,0 +1,39 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include "model.h"
+
+#include <vector>
+
+// 顶点缓存模拟结果
+struct VertexCacheStats
+{
+    float acmr; // 平均每个三角形的缓存未命中次数（越接近0.5越好，最差3）
+    float atvr; // 平均每个顶点被变换的次数（理想为1）
+};
+
+// 导入后的mesh优化：顶点去重、Tipsify 三角形重排（顶点缓存局部性）、
+// 按簇排序减少 overdraw，最后按首次使用顺序重排顶点提高取数局部性。
+// 全部是纯CPU操作，可以在加载线程上执行
+class MeshOptimizer
+{
+public:
+    static const unsigned int CACHE_SIZE = 16;
+
+    // 依次执行下面所有步骤，要在生成 LOD 之前调用（索引数组里只有 LOD0）
+    static void Optimize(MeshData &mesh);
+
+    // 合并完全相同的顶点并重写索引
+    static void DeduplicateVertices(MeshData &mesh);
+    // Tipsify 重排三角形，clusters 输出每个簇起始三角形的下标（用于 overdraw 排序）
+    static void OptimizeVertexCache(std::vector<unsigned int> &indices, size_t vertexCount, std::vector<unsigned int> &clusters);
+    // 保持簇内顺序不变，按簇的朝外程度排序，让外侧的面先画
+    static void OptimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<Vertex> &vertices, const std::vector<unsigned int> &clusters);
+    // 按索引中首次出现的顺序重排顶点，丢弃未被引用的顶点
+    static void OptimizeVertexFetch(MeshData &mesh);
+
+    // 用 FIFO 缓存模拟统计 ACMR/ATVR，不需要GPU
+    static VertexCacheStats AnalyzeVertexCache(const std::vector<unsigned int> &indices, size_t vertexCount, unsigned int cacheSize = CACHE_SIZE);
+};
+
+#endif
@@ -0,0 +1,287 @@
+#include "meshSimplifier.h"
+#include "meshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdint.h>
+#include <unordered_map>
+
+namespace
+{
+    // 对称 4x4 矩阵的 10 个分量，外加平面面积权重，误差 = p^T Q p / weight
+    struct Quadric
+    {
+        double a2, b2, c2, d2, ab, ac, ad, bc, bd, cd;
+        double weight;
+
+        Quadric() : a2(0), b2(0), c2(0), d2(0), ab(0), ac(0), ad(0), bc(0), bd(0), cd(0), weight(0) {}
+
+        void AddPlane(const glm::vec3 &normal, double d, double w)
+        {
+            double a = normal.x, b = normal.y, c = normal.z;
+            a2 += w * a * a; b2 += w * b * b; c2 += w * c * c; d2 += w * d * d;
+            ab += w * a * b; ac += w * a * c; ad += w * a * d;
+            bc += w * b * c; bd += w * b * d; cd += w * c * d;
+            weight += w;
+        }
+
+        void Add(const Quadric &q)
+        {
+            a2 += q.a2; b2 += q.b2; c2 += q.c2; d2 += q.d2;
+            ab += q.ab; ac += q.ac; ad += q.ad;
+            bc += q.bc; bd += q.bd; cd += q.cd;
+            weight += q.weight;
+        }
+
+        // 到所有平面的加权平均距离平方
+        double Error(const glm::vec3 &p) const
+        {
+            double x = p.x, y = p.y, z = p.z;
+            double e = a2 * x * x + b2 * y * y + c2 * z * z + d2
+                     + 2.0 * (ab * x * y + ac * x * z + bc * y * z + ad * x + bd * y + cd * z);
+            return weight > 0.0 ? std::fabs(e) / weight : 0.0;
+        }
+    };
+
+    struct PositionHash
+    {
+        size_t operator()(const glm::vec3 &p) const
+        {
+            uint32_t bits[3];
+            memcpy(bits, &p, sizeof(bits));
+            return (size_t)(bits[0] * 73856093u ^ bits[1] * 19349663u ^ bits[2] * 83492791u);
+        }
+    };
+
+    struct Collapse
+    {
+        float cost;
+        unsigned int from;
+        unsigned int to;
+
+        bool operator<(const Collapse &other) const { return cost < other.cost; }
+    };
+
+    uint64_t edgeKey(unsigned int a, unsigned int b)
+    {
+        return a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+    }
+
+    // 把 from 移到 to 的位置后，周围的三角形不能翻面或退化成零面积。
+    // 同一轮里已经折叠的顶点按 remap 取当前位置，和这一轮开始时的朝向比较，
+    // 这样一个三角形的几个顶点在同一轮里先后移动，每一步检查的都是累计的结果
+    bool flipsTriangles(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices,
+                        const std::vector<unsigned int> &adjacencyOffset, const std::vector<unsigned int> &adjacency,
+                        const std::vector<unsigned int> &remap, unsigned int from, unsigned int to)
+    {
+        for (unsigned int a = adjacencyOffset[from]; a < adjacencyOffset[from + 1]; a++)
+        {
+            const unsigned int *triangle = &indices[adjacency[a] * 3];
+            unsigned int moved[3];
+            for (int k = 0; k < 3; k++)
+                moved[k] = triangle[k] == from ? to : remap[triangle[k]];
+            if (moved[0] == moved[1] || moved[1] == moved[2] || moved[0] == moved[2])
+                continue; // 这个三角形会被折叠掉
+            glm::vec3 p[3], q[3];
+            for (int k = 0; k < 3; k++)
+            {
+                p[k] = vertices[triangle[k]].Position;
+                q[k] = vertices[moved[k]].Position;
+            }
+            glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+            glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+            if (glm::dot(before, after) <= 0.0f)
+                return true;
+        }
+        return false;
+    }
+}
+
+std::vector<unsigned int> MeshSimplifier::Simplify(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices,
+                                                   size_t targetIndexCount, float targetError, float *resultError)
+{
+    size_t vertexCount = vertices.size();
+    std::vector<unsigned int> result(indices.begin(), indices.begin() + indices.size() / 3 * 3);
+    float maxCost = 0.0f;
+
+    // 位置相同的顶点视为拓扑上的同一个点（纹理接缝处会有多个属性不同的顶点）
+    std::unordered_map<glm::vec3, unsigned int, PositionHash> positions;
+    std::vector<unsigned int> canonical(vertexCount);
+    std::vector<unsigned int> duplicates(vertexCount, 0);
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        unsigned int id = positions.insert(std::make_pair(vertices[v].Position, (unsigned int)v)).first->second;
+        canonical[v] = id;
+        duplicates[id]++;
+    }
+
+    // 只被一个三角形使用的边是开放边界
+    std::unordered_map<uint64_t, unsigned int> edgeUse;
+    for (size_t i = 0; i < result.size(); i += 3)
+        for (int k = 0; k < 3; k++)
+            edgeUse[edgeKey(canonical[result[i + k]], canonical[result[i + (k + 1) % 3]])]++;
+
+    std::vector<bool> locked(vertexCount, false);
+    for (size_t i = 0; i < result.size(); i += 3)
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int a = canonical[result[i + k]], b = canonical[result[i + (k + 1) % 3]];
+            if (edgeUse[edgeKey(a, b)] == 1)
+                locked[a] = locked[b] = true;
+        }
+    for (size_t v = 0; v < vertexCount; v++)
+        locked[v] = locked[canonical[v]] || duplicates[canonical[v]] > 1;
+
+    // 每个顶点的二次误差：相邻三角形平面按面积加权
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t i = 0; i < result.size(); i += 3)
+    {
+        const glm::vec3 &p0 = vertices[result[i + 0]].Position;
+        const glm::vec3 &p1 = vertices[result[i + 1]].Position;
+        const glm::vec3 &p2 = vertices[result[i + 2]].Position;
+        glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+        float area = glm::length(normal);
+        if (area <= 0.0f)
+            continue;
+        normal /= area;
+        Quadric plane;
+        plane.AddPlane(normal, -glm::dot(normal, p0), area);
+        for (int k = 0; k < 3; k++)
+            quadrics[canonical[result[i + k]]].Add(plane);
+    }
+
+    double errorLimit = (double)targetError * targetError;
+    std::vector<Collapse> collapses;
+    std::vector<unsigned int> adjacencyOffset(vertexCount + 1), adjacency, remap(vertexCount);
+    std::vector<bool> touched(vertexCount);
+    while (result.size() > targetIndexCount)
+    {
+        // 收集这一轮所有可以折叠的有向边，按代价从小到大处理
+        collapses.clear();
+        for (size_t i = 0; i < result.size(); i += 3)
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned int a = result[i + k], b = result[i + (k + 1) % 3];
+                Collapse collapse;
+                if (!locked[a])
+                {
+                    collapse.from = a;
+                    collapse.to = b;
+                    collapse.cost = (float)quadrics[canonical[a]].Error(vertices[b].Position);
+                    collapses.push_back(collapse);
+                }
+                if (!locked[b])
+                {
+                    collapse.from = b;
+                    collapse.to = a;
+                    collapse.cost = (float)quadrics[canonical[b]].Error(vertices[a].Position);
+                    collapses.push_back(collapse);
+                }
+            }
+        std::sort(collapses.begin(), collapses.end());
+
+        // 顶点到三角形的邻接表（CSR）
+        std::fill(adjacencyOffset.begin(), adjacencyOffset.end(), 0);
+        for (size_t i = 0; i < result.size(); i++)
+            adjacencyOffset[result[i] + 1]++;
+        for (size_t v = 0; v < vertexCount; v++)
+            adjacencyOffset[v + 1] += adjacencyOffset[v];
+        adjacency.resize(result.size());
+        std::vector<unsigned int> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+        for (size_t i = 0; i < result.size(); i++)
+            adjacency[fill[result[i]]++] = (unsigned int)(i / 3);
+
+        // 每个顶点一轮最多参与一次折叠，邻接信息在这一轮里保持有效
+        for (size_t v = 0; v < vertexCount; v++)
+            remap[v] = (unsigned int)v;
+        std::fill(touched.begin(), touched.end(), false);
+        size_t expectedIndices = result.size();
+        size_t performed = 0;
+        for (size_t c = 0; c < collapses.size() && expectedIndices > targetIndexCount; c++)
+        {
+            const Collapse &collapse = collapses[c];
+            if (collapse.cost > errorLimit)
+                break;
+            if (touched[collapse.from] || touched[collapse.to])
+                continue;
+            if (flipsTriangles(vertices, result, adjacencyOffset, adjacency, remap, collapse.from, collapse.to))
+                continue;
+
+            remap[collapse.from] = collapse.to;
+            quadrics[canonical[collapse.to]].Add(quadrics[canonical[collapse.from]]);
+            touched[collapse.from] = touched[collapse.to] = true;
+            maxCost = std::max(maxCost, collapse.cost);
+            expectedIndices -= 6; // 内部边折叠平均消掉两个三角形
+            performed++;
+        }
+        if (performed == 0)
+            break;
+
+        // 应用这一轮的折叠并丢掉退化三角形
+        size_t write = 0;
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            unsigned int a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+            if (a == b || b == c || a == c)
+                continue;
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize(write);
+    }
+
+    if (resultError)
+        *resultError = std::sqrt(maxCost);
+    return result;
+}
+
+void MeshSimplifier::GenerateLods(MeshData &mesh, unsigned int levels)
+{
+    mesh.lods.clear();
+    if (mesh.indices.size() < 3 || mesh.vertices.empty())
+        return;
+
+    MeshLod base;
+    base.firstIndex = 0;
+    base.indexCount = (unsigned int)mesh.indices.size();
+    base.error = 0.0f;
+    mesh.lods.push_back(base);
+
+    glm::vec3 minimum = mesh.vertices[0].Position, maximum = minimum;
+    for (size_t v = 1; v < mesh.vertices.size(); v++)
+    {
+        minimum = glm::min(minimum, mesh.vertices[v].Position);
+        maximum = glm::max(maximum, mesh.vertices[v].Position);
+    }
+    // 最粗的一级也不允许偏离超过包围盒对角线的 5%
+    float maxError = glm::length(maximum - minimum) * 0.05f;
+
+    std::vector<unsigned int> source(mesh.indices);
+    size_t previousCount = source.size();
+    for (unsigned int level = 1; level < levels; level++)
+    {
+        // 每一级都从原始网格简化，误差不会逐级累加
+        size_t target = source.size() >> level;
+        target -= target % 3;
+        float error = 0.0f;
+        std::vector<unsigned int> lod = Simplify(mesh.vertices, source, target, maxError, &error);
+        if (lod.empty() || lod.size() > previousCount * 3 / 4)
+            break; // 简化不动了，再加一级也没有意义
+
+        std::vector<unsigned int> clusters;
+        MeshOptimizer::OptimizeVertexCache(lod, mesh.vertices.size(), clusters);
+
+        MeshLod record;
+        record.firstIndex = (unsigned int)mesh.indices.size();
+        record.indexCount = (unsigned int)lod.size();
+        record.error = std::max(error, mesh.lods.back().error);
+        mesh.lods.push_back(record);
+        mesh.indices.insert(mesh.indices.end(), lod.begin(), lod.end());
+        previousCount = lod.size();
+    }
+
+    if (mesh.lods.size() == 1)
+        mesh.lods.clear();
+}
@@ -0,0 +1,26 @@
+#ifndef MESH_SIMPLIFIER_H
+#define MESH_SIMPLIFIER_H
+
+#include "model.h"
+
+#include <vector>
+
+// 基于二次误差度量（Garland & Heckbert 1997）的边折叠简化，用来在导入时生成 LOD。
+// 顶点只会折叠到已有的顶点上，不产生新顶点，所以所有 LOD 共用同一份顶点数据，
+// 只是索引不同。开放边界和纹理接缝上的顶点保持不动，避免出现裂缝。纯CPU操作
+class MeshSimplifier
+{
+public:
+    static const unsigned int MAX_LODS = 4;
+
+    // 简化到 targetIndexCount 个索引，或者误差超过 targetError（模型空间距离）为止。
+    // resultError 输出实际产生的最大误差
+    static std::vector<unsigned int> Simplify(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices,
+                                              size_t targetIndexCount, float targetError, float *resultError);
+
+    // 以 mesh.indices 为 LOD0，把三角形数逐级减半的 LOD 追加到同一个索引数组的末尾，
+    // 并填写 mesh.lods。简化效果不明显（比如接缝太多）时会提前停止
+    static void GenerateLods(MeshData &mesh, unsigned int levels = MAX_LODS);
+};
+
+#endif
@@ -0,0 +1,267 @@
+#include "mipmapGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define MIPMAP_SSE2 1
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+// AVX2 版本用 target 属性单独编译，运行时检测 CPU 支持后再调用，不需要全局打开 -mavx2
+#define MIPMAP_AVX2 1
+#include <immintrin.h>
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define MIPMAP_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+    // 8bit 与 16bit 工作格式之间的查找表，反向转换都取高 14 位查表。
+    // 放在函数内的静态对象里，多个解码线程第一次使用时也只会初始化一次
+    struct ConversionTables
+    {
+        uint16_t toLinear[256];            // sRGB -> 线性
+        unsigned char fromLinear[1 << 14]; // 线性 -> sRGB
+        uint16_t toWorking[256];           // 非颜色数据，x * 257
+        unsigned char fromWorking[1 << 14];
+
+        ConversionTables()
+        {
+            for (int i = 0; i < 256; i++)
+                toWorking[i] = (uint16_t)(i * 257);
+            // 与 (v + 128) / 257 的结果只在极少数边界值上差 1
+            for (int i = 0; i < (1 << 14); i++)
+                fromWorking[i] = (unsigned char)(((i << 2) + 2 + 128) / 257);
+            for (int i = 0; i < 256; i++)
+            {
+                double c = i / 255.0;
+                double linear = c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+                toLinear[i] = (uint16_t)std::floor(linear * 65535.0 + 0.5);
+            }
+            for (int i = 0; i < (1 << 14); i++)
+            {
+                double linear = (i + 0.5) / (1 << 14);
+                double c = linear <= 0.0031308 ? linear * 12.92 : 1.055 * std::pow(linear, 1.0 / 2.4) - 0.055;
+                fromLinear[i] = (unsigned char)std::floor(std::min(1.0, c) * 255.0 + 0.5);
+            }
+        }
+    };
+
+    const ConversionTables &conversionTables()
+    {
+        static ConversionTables tables;
+        return tables;
+    }
+
+    inline uint16_t average(uint16_t a, uint16_t b)
+    {
+        return (uint16_t)((a + b + 1) >> 1);
+    }
+
+    // 与 SIMD 版本相同的运算顺序：先上下两行平均，再左右两个像素平均
+    void downsampleRowScalar(const uint16_t *row0, const uint16_t *row1, int width, int begin, int end, uint16_t *dst)
+    {
+        for (int x = begin; x < end; x++)
+        {
+            int x0 = std::min(x * 2, width - 1);
+            int x1 = std::min(x * 2 + 1, width - 1);
+            for (int c = 0; c < 4; c++)
+            {
+                uint16_t left = average(row0[x0 * 4 + c], row1[x0 * 4 + c]);
+                uint16_t right = average(row0[x1 * 4 + c], row1[x1 * 4 + c]);
+                dst[x * 4 + c] = average(left, right);
+            }
+        }
+    }
+
+#ifdef MIPMAP_SSE2
+    // 每次处理 4 个源像素（每行 32 字节），输出 2 个像素
+    int downsampleRowSSE2(const uint16_t *row0, const uint16_t *row1, int outWidth, uint16_t *dst)
+    {
+        int x = 0;
+        for (; x + 2 <= outWidth; x += 2)
+        {
+            const __m128i *a = reinterpret_cast<const __m128i *>(row0 + x * 8);
+            const __m128i *b = reinterpret_cast<const __m128i *>(row1 + x * 8);
+            __m128i p01 = _mm_avg_epu16(_mm_loadu_si128(a), _mm_loadu_si128(b));
+            __m128i p23 = _mm_avg_epu16(_mm_loadu_si128(a + 1), _mm_loadu_si128(b + 1));
+            __m128i even = _mm_unpacklo_epi64(p01, p23); // P0 P2
+            __m128i odd = _mm_unpackhi_epi64(p01, p23);  // P1 P3
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x * 4), _mm_avg_epu16(even, odd));
+        }
+        return x;
+    }
+#endif
+
+#ifdef MIPMAP_AVX2
+    // 每次处理 8 个源像素（每行 64 字节），输出 4 个像素
+    __attribute__((target("avx2")))
+    int downsampleRowAVX2(const uint16_t *row0, const uint16_t *row1, int outWidth, uint16_t *dst)
+    {
+        int x = 0;
+        for (; x + 4 <= outWidth; x += 4)
+        {
+            const __m256i *a = reinterpret_cast<const __m256i *>(row0 + x * 8);
+            const __m256i *b = reinterpret_cast<const __m256i *>(row1 + x * 8);
+            __m256i p0123 = _mm256_avg_epu16(_mm256_loadu_si256(a), _mm256_loadu_si256(b));
+            __m256i p4567 = _mm256_avg_epu16(_mm256_loadu_si256(a + 1), _mm256_loadu_si256(b + 1));
+            // 按 128 位通道：even = [P0 P4 | P2 P6]，odd = [P1 P5 | P3 P7]
+            __m256i even = _mm256_unpacklo_epi64(p0123, p4567);
+            __m256i odd = _mm256_unpackhi_epi64(p0123, p4567);
+            __m256i result = _mm256_avg_epu16(even, odd); // [O0 O2 | O1 O3]
+            result = _mm256_permute4x64_epi64(result, _MM_SHUFFLE(3, 1, 2, 0));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + x * 4), result);
+        }
+        return x;
+    }
+
+    bool hasAVX2()
+    {
+        static const bool supported = __builtin_cpu_supports("avx2") != 0;
+        return supported;
+    }
+#endif
+
+#ifdef MIPMAP_NEON
+    int downsampleRowNEON(const uint16_t *row0, const uint16_t *row1, int outWidth, uint16_t *dst)
+    {
+        int x = 0;
+        for (; x + 2 <= outWidth; x += 2)
+        {
+            uint16x8_t p01 = vrhaddq_u16(vld1q_u16(row0 + x * 8), vld1q_u16(row1 + x * 8));
+            uint16x8_t p23 = vrhaddq_u16(vld1q_u16(row0 + x * 8 + 8), vld1q_u16(row1 + x * 8 + 8));
+            uint16x8_t even = vcombine_u16(vget_low_u16(p01), vget_low_u16(p23));
+            uint16x8_t odd = vcombine_u16(vget_high_u16(p01), vget_high_u16(p23));
+            vst1q_u16(dst + x * 4, vrhaddq_u16(even, odd));
+        }
+        return x;
+    }
+#endif
+
+    // 8bit 任意通道 -> RGBA16 工作格式，每个通道按各自的查找表转换，循环里没有分支
+    std::vector<uint16_t> toWorking(const unsigned char *pixels, int width, int height, int channels, bool srgb)
+    {
+        const ConversionTables &tables = conversionTables();
+        const uint16_t *lut[4];
+        for (int c = 0; c < 4; c++)
+            lut[c] = srgb && c < 3 ? tables.toLinear : tables.toWorking;
+
+        size_t count = (size_t)width * height;
+        std::vector<uint16_t> working(count * 4);
+        uint16_t *dst = &working[0];
+        if (channels == 4)
+        {
+            for (size_t i = 0; i < count; i++, pixels += 4, dst += 4)
+            {
+                dst[0] = lut[0][pixels[0]];
+                dst[1] = lut[1][pixels[1]];
+                dst[2] = lut[2][pixels[2]];
+                dst[3] = lut[3][pixels[3]];
+            }
+            return working;
+        }
+        for (size_t i = 0; i < count; i++, pixels += channels, dst += 4)
+        {
+            dst[0] = dst[1] = dst[2] = 0;
+            dst[3] = 65535;
+            for (int c = 0; c < channels; c++)
+                dst[c] = lut[c][pixels[c]];
+        }
+        return working;
+    }
+
+    // RGBA16 工作格式 -> 8bit 原通道数
+    void fromWorking(const uint16_t *working, int width, int height, int channels, bool srgb, unsigned char *pixels)
+    {
+        const ConversionTables &tables = conversionTables();
+        const unsigned char *lut[4];
+        for (int c = 0; c < 4; c++)
+            lut[c] = srgb && c < 3 ? tables.fromLinear : tables.fromWorking;
+
+        size_t count = (size_t)width * height;
+        for (size_t i = 0; i < count; i++, working += 4, pixels += channels)
+        {
+            for (int c = 0; c < channels; c++)
+                pixels[c] = lut[c][working[c] >> 2];
+        }
+    }
+}
+
+void MipmapGenerator::Downsample(const uint16_t *src, int width, int height, uint16_t *dst, bool simd)
+{
+    int outWidth = std::max(1, width / 2);
+    int outHeight = std::max(1, height / 2);
+    for (int y = 0; y < outHeight; y++)
+    {
+        const uint16_t *row0 = src + (size_t)std::min(y * 2, height - 1) * width * 4;
+        const uint16_t *row1 = src + (size_t)std::min(y * 2 + 1, height - 1) * width * 4;
+        uint16_t *out = dst + (size_t)y * outWidth * 4;
+
+        // 宽度为 1 时没有成对的像素，全部走标量
+        int done = 0;
+        if (simd && width >= 2)
+        {
+#if defined(MIPMAP_AVX2)
+            if (hasAVX2())
+                done = downsampleRowAVX2(row0, row1, outWidth, out);
+#endif
+#if defined(MIPMAP_SSE2)
+            done += downsampleRowSSE2(row0 + done * 8, row1 + done * 8, outWidth - done, out + done * 4);
+#elif defined(MIPMAP_NEON)
+            done = downsampleRowNEON(row0, row1, outWidth, out);
+#endif
+        }
+        downsampleRowScalar(row0, row1, width, done, outWidth, out);
+    }
+}
+
+const char *MipmapGenerator::SimdName()
+{
+#if defined(MIPMAP_AVX2)
+    if (hasAVX2())
+        return "AVX2";
+#endif
+#if defined(MIPMAP_SSE2)
+    return "SSE2";
+#elif defined(MIPMAP_NEON)
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
+
+std::vector<MipLevel> MipmapGenerator::Generate(const unsigned char *pixels, int width, int height, int channels, bool srgb)
+{
+    std::vector<MipLevel> levels;
+    levels.reserve(32);
+    if (!pixels || width <= 0 || height <= 0 || channels <= 0 || channels > 4)
+        return levels;
+
+    // 只有颜色贴图（至少有 RGB 三个通道）才做 sRGB 转换
+    srgb = srgb && channels >= 3;
+
+    // 整条 mip 链都在 16bit 线性工作格式里计算，每一级只在输出时量化回 8bit
+    std::vector<uint16_t> current = toWorking(pixels, width, height, channels, srgb);
+    std::vector<uint16_t> next;
+    while (width > 1 || height > 1)
+    {
+        int nextWidth = std::max(1, width / 2);
+        int nextHeight = std::max(1, height / 2);
+        next.resize((size_t)nextWidth * nextHeight * 4);
+        Downsample(&current[0], width, height, &next[0]);
+
+        levels.push_back(MipLevel());
+        MipLevel &level = levels.back();
+        level.width = nextWidth;
+        level.height = nextHeight;
+        level.data.resize((size_t)nextWidth * nextHeight * channels);
+        fromWorking(&next[0], nextWidth, nextHeight, channels, srgb, &level.data[0]);
+
+        current.swap(next);
+        width = nextWidth;
+        height = nextHeight;
+    }
+    return levels;
+}
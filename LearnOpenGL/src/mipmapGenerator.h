@@ -0,0 +1,33 @@
+#ifndef MIPMAP_GENERATOR_H
+#define MIPMAP_GENERATOR_H
+
+#include <stdint.h>
+#include <vector>
+
+// 一级 mipmap，紧密排列的 8bit 数据
+struct MipLevel
+{
+    int width;
+    int height;
+    std::vector<unsigned char> data;
+};
+
+// CPU 端的 mipmap 生成，代替 GL 线程上同步执行的 glGenerateMipmap。
+// 内部使用 16bit 的 RGBA 工作格式逐级做 2x2 盒式滤波（SSE2/AVX2/NEON 加速），
+// 颜色贴图的 RGB 先从 sRGB 转到线性空间再平均，避免远处的贴图整体变暗。纯CPU操作，可以在解码线程上执行
+class MipmapGenerator
+{
+public:
+    // 生成第 1 级到 1x1 的所有 mip（不包含第 0 级），输出与输入相同的通道数。
+    // srgb 为 true 时前三个通道按 sRGB 编码处理（只对 3/4 通道的图片生效），alpha 始终线性平均
+    static std::vector<MipLevel> Generate(const unsigned char *pixels, int width, int height, int channels, bool srgb);
+
+    // 一级 2x2 降采样：src 为 width x height 的 RGBA16，dst 至少能放下 max(1,width/2) x max(1,height/2) 个像素。
+    // 奇数尺寸时丢弃最后一行/列，尺寸为 1 的方向与自身平均。simd 为 false 时强制使用标量实现（结果逐位相同）
+    static void Downsample(const uint16_t *src, int width, int height, uint16_t *dst, bool simd = true);
+
+    // 当前机器上 Downsample 使用的指令集："AVX2"、"SSE2"、"NEON" 或 "scalar"
+    static const char *SimdName();
+};
+
+#endif
@@ -1,32 +1,277 @@
 #include "model.h"
-#include "stb_image.h"
+#include "meshCache.h"
+#include "meshOptimizer.h"
+#include "meshSimplifier.h"
+#include "renderStats.h"
+#include "assetPack.h"
+#include "mappedFile.h"
+#include "objLoader.h"
+#include "gltfLoader.h"
+#include "traceRecorder.h"
 
 #include <glad/glad.h>
+#include "stb_image.h"
+#include "glm/gtc/type_ptr.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <map>
 #include <sstream>
 
-Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures)
+#include "assimp/DefaultIOSystem.h"
+#include "assimp/MemoryIOWrapper.h"
+
+namespace
 {
-    this->vertices = vertices;
-    this->indices = indices;
-    this->textures = textures;
+    // 让 Assimp 通过资源包读取模型和材质文件：包里有的文件直接包装映射的内存，其它的交给默认实现。
+    // 除源文件之外打开的文件（.mtl、外部 .bin 等）在读取之前记进 data.dependencies
+    class PackIOSystem : public Assimp::DefaultIOSystem
+    {
+    public:
+        PackIOSystem(const std::string &source, ModelData &data) : _source(source), _data(data) {}
+
+        bool Exists(const char *file) const override
+        {
+            AssetSpan span;
+            return AssetPack::Instance().Find(file, span) || Assimp::DefaultIOSystem::Exists(file);
+        }
+
+        Assimp::IOStream *Open(const char *file, const char *mode) override
+        {
+            std::string prefix = _data.directory + "/";
+            if (strchr(mode, 'w') == nullptr && _source != file && strncmp(file, prefix.c_str(), prefix.size()) == 0)
+                MeshCache::RecordDependency(_data, file + prefix.size());
+            AssetSpan span;
+            if (strchr(mode, 'w') == nullptr && AssetPack::Instance().Find(file, span))
+                return new Assimp::MemoryIOStream(span.data, span.size);
+            return Assimp::DefaultIOSystem::Open(file, mode);
+        }
+
+    private:
+        std::string _source;
+        ModelData &_data;
+    };
+
+    // 和 TextureManager 解码时一样先查资源包，再映射松散文件，只解析图片头拿尺寸
+    bool imageInfo(const std::string &path, int &width, int &height, int &components)
+    {
+        AssetSpan span;
+        MappedFile file;
+        if (!AssetPack::Instance().Find(path, span) && file.Open(path))
+        {
+            span.data = file.Data();
+            span.size = file.Size();
+        }
+        return span.data && span.size <= (size_t)INT_MAX
+            && stbi_info_from_memory(span.data, (int)span.size, &width, &height, &components) != 0;
+    }
+
+    size_t indexSize(GLenum type)
+    {
+        return type == GL_UNSIGNED_BYTE ? sizeof(GLubyte) : type == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+    }
+
+    // 统计节点和mesh实例数（同一个 aiMesh 可以被多个节点引用），导入前一次预留好输出数组
+    void countNodes(const aiNode *node, size_t &nodes, size_t &meshes)
+    {
+        nodes++;
+        meshes += node->mNumMeshes;
+        for (unsigned int i = 0; i < node->mNumChildren; i++)
+            countNodes(node->mChildren[i], nodes, meshes);
+    }
 
-    // process vertices
-    setupMesh();
+    // 材质贴图表预计占用的 arena 大小，路径长度按 128 字节估计
+    size_t estimateMaterialBytes(const aiScene *scene)
+    {
+        size_t textures = 0;
+        for (unsigned int i = 0; i < scene->mNumMaterials; i++)
+        {
+            textures += scene->mMaterials[i]->GetTextureCount(aiTextureType_DIFFUSE);
+            textures += scene->mMaterials[i]->GetTextureCount(aiTextureType_SPECULAR);
+        }
+        return scene->mNumMaterials * sizeof(ImportMaterial) + textures * (sizeof(ImportTexture) + 128) + 1024;
+    }
 }
 
-void Mesh::setupMesh()
+LodView LodView::Perspective(const glm::vec3 &cameraPosition, float fovyRadians, float viewportHeight, float maxPixelError)
 {
-    glGenVertexArrays(1, &_VAO);
-    glGenBuffers(1, &_VBO);
-    glGenBuffers(1, &_EBO);
+    LodView view;
+    view.cameraPosition = cameraPosition;
+    view.projectionScale = viewportHeight / (2.0f * std::tan(fovyRadians * 0.5f));
+    view.maxPixelError = maxPixelError;
+    return view;
+}
 
-    glBindVertexArray(_VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, _VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+Mesh::Mesh(MeshData &&data, std::vector<Texture> &&textures) :
+    vertices(std::move(data.vertices)), indices(std::move(data.indices)), textures(std::move(textures)),
+    lods(std::move(data.lods)), node(data.node), _pool(nullptr),
+    _indexType(GL_UNSIGNED_INT), _indexCount((unsigned int)data.IndexCount()), _indexOffset(0),
+    _positionScale(1.0f), _positionOffset(0.0f), _quantized(false),
+    _boundsCenter(0.0f), _boundsRadius(0.0f),
+    _mappedVertices(data.mappedVertices), _mappedIndices(data.mappedIndices), _mappedVertexCount(data.mappedVertexCount)
+{
+    if (!vertices.empty())
+    {
+        _mappedVertices = nullptr;
+        _mappedVertexCount = 0;
+    }
+    if (!indices.empty())
+    {
+        _mappedIndices = nullptr;
+    }
+    const Vertex *source = vertices.empty() ? _mappedVertices : &vertices[0];
+    size_t vertexCount = vertices.empty() ? _mappedVertexCount : vertices.size();
+    if (vertexCount > 0)
+    {
+        glm::vec3 minimum = source[0].Position, maximum = minimum;
+        for (size_t i = 1; i < vertexCount; i++)
+        {
+            minimum = glm::min(minimum, source[i].Position);
+            maximum = glm::max(maximum, source[i].Position);
+        }
+        _boundsCenter = (minimum + maximum) * 0.5f;
+        _boundsRadius = glm::length(maximum - minimum) * 0.5f;
+    }
+}
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+Mesh::Mesh(Mesh &&other) noexcept :
+    vertices(std::move(other.vertices)), indices(std::move(other.indices)), textures(std::move(other.textures)),
+    lods(std::move(other.lods)), node(other.node), _VAO(std::move(other._VAO)), _VBO(std::move(other._VBO)), _EBO(std::move(other._EBO)),
+    _pool(other._pool), _range(other._range), _indexType(other._indexType),
+    _indexCount(other._indexCount), _indexOffset(other._indexOffset),
+    _positionScale(other._positionScale), _positionOffset(other._positionOffset), _quantized(other._quantized),
+    _boundsCenter(other._boundsCenter), _boundsRadius(other._boundsRadius),
+    _mappedVertices(other._mappedVertices), _mappedIndices(other._mappedIndices), _mappedVertexCount(other._mappedVertexCount)
+{
+    other._pool = nullptr;
+}
 
+Mesh &Mesh::operator=(Mesh &&other) noexcept
+{
+    if (this != &other)
+    {
+        if (_pool)
+            _pool->Release(_range);
+        vertices = std::move(other.vertices);
+        indices = std::move(other.indices);
+        textures = std::move(other.textures);
+        lods = std::move(other.lods);
+        node = other.node;
+        _VAO = std::move(other._VAO);
+        _VBO = std::move(other._VBO);
+        _EBO = std::move(other._EBO);
+        _pool = other._pool;
+        _range = other._range;
+        _indexType = other._indexType;
+        _indexCount = other._indexCount;
+        _indexOffset = other._indexOffset;
+        _positionScale = other._positionScale;
+        _positionOffset = other._positionOffset;
+        _quantized = other._quantized;
+        _boundsCenter = other._boundsCenter;
+        _boundsRadius = other._boundsRadius;
+        _mappedVertices = other._mappedVertices;
+        _mappedIndices = other._mappedIndices;
+        _mappedVertexCount = other._mappedVertexCount;
+        other._pool = nullptr;
+    }
+    return *this;
+}
+
+Mesh::~Mesh()
+{
+    if (_pool)
+        _pool->Release(_range);
+}
+
+void Mesh::Upload(GeometryPool *pool, const QuantizedMesh *quantized)
+{
+    TRACE_ZONE("Mesh::Upload");
+    // 根据是否量化选择要上传的顶点、索引数据
+    // 从缓存读取的mesh没有 vertices/indices，直接从映射的文件上传
+    const void *vertexData = vertices.empty() ? (const void *)_mappedVertices : &vertices[0];
+    size_t vertexCount = vertices.empty() ? _mappedVertexCount : vertices.size();
+    size_t vertexBytes = vertexCount * sizeof(Vertex);
+    const void *indexData = indices.empty() ? (const void *)_mappedIndices : &indices[0];
+    size_t indexCount = indices.empty() ? _indexCount : indices.size();
+    _mappedVertices = nullptr;
+    _mappedIndices = nullptr;
+    _mappedVertexCount = 0;
+    _indexType = GL_UNSIGNED_INT;
+    _indexCount = (unsigned int)indexCount;
+    _indexOffset = 0;
+    if (quantized)
+    {
+        _quantized = true;
+        _positionScale = quantized->positionScale;
+        _positionOffset = quantized->positionOffset;
+        vertexData = &quantized->vertices[0];
+        vertexBytes = quantized->vertices.size() * sizeof(PackedVertex);
+        if (quantized->Uses16BitIndices())
+        {
+            indexData = &quantized->indices16[0];
+            _indexType = GL_UNSIGNED_SHORT;
+        }
+    }
+
+    if (pool)
+    {
+        _range = pool->Allocate(vertexData, vertexCount, indexData, indexCount);
+        _pool = pool;
+        return;
+    }
+
+    _VAO.Create();
+    _VBO.Create();
+    _EBO.Create();
+
+    glBindVertexArray(_VAO.Id());
+    glBindBuffer(GL_ARRAY_BUFFER, _VBO.Id());
+    glBufferData(GL_ARRAY_BUFFER, vertexBytes, vertexData, GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _EBO.Id());
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * indexSize(_indexType), indexData, GL_STATIC_DRAW);
+
+    if (quantized)
+        VertexQuantizer::SetupAttributes();
+    else
+        SetupAttributes();
+
+    glBindVertexArray(0);
+}
+
+void Mesh::UploadExternal(const VertexAttributeSource attributes[3], GLuint indexBuffer, GLenum indexType,
+                          size_t indexOffset, unsigned int indexCount, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax)
+{
+    _indexType = indexType;
+    _indexCount = indexCount;
+    _indexOffset = indexOffset;
+    _boundsCenter = (boundsMin + boundsMax) * 0.5f;
+    _boundsRadius = glm::length(boundsMax - boundsMin) * 0.5f;
+
+    _VAO.Create();
+    glBindVertexArray(_VAO.Id());
+    for (GLuint i = 0; i < 3; i++)
+    {
+        const VertexAttributeSource &source = attributes[i];
+        if (source.buffer == 0)
+        {
+            glDisableVertexAttribArray(i);
+            continue;
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, source.buffer);
+        glEnableVertexAttribArray(i);
+        glVertexAttribPointer(i, source.components, source.type, source.normalized, source.stride, (GLvoid*)source.offset);
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Mesh::SetupAttributes()
+{
     // 设置顶点坐标指针
     glEnableVertexAttribArray(0); 
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid*)0);
@@ -38,92 +283,800 @@ void Mesh::setupMesh()
     // 设置顶点的纹理坐标
     glEnableVertexAttribArray(2); 
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid*)offsetof(Vertex, TexCoords));
+}
+
+unsigned int Mesh::LodCount() const
+{
+    return lods.empty() ? 1 : (unsigned int)lods.size();
+}
+
+bool Mesh::project(const glm::mat4 &modelMatrix, const LodView &view, float &pixelsPerUnit) const
+{
+    // 模型矩阵里最大的缩放，把模型空间的长度换算到世界空间
+    float scale = std::max(glm::length(glm::vec3(modelMatrix[0])),
+                           std::max(glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2]))));
+    glm::vec3 center = glm::vec3(modelMatrix * glm::vec4(_boundsCenter, 1.0f));
+    float distance = glm::length(center - view.cameraPosition) - _boundsRadius * scale;
+    if (distance <= 0.0f)
+    {
+        return false; // 相机在包围球里面
+    }
+    pixelsPerUnit = view.projectionScale * scale / distance;
+    return true;
+}
+
+unsigned int Mesh::SelectLod(const glm::mat4 &modelMatrix, const LodView &view) const
+{
+    float pixelsPerUnit;
+    if (lods.size() < 2 || !project(modelMatrix, view, pixelsPerUnit))
+    {
+        return 0;
+    }
+
+    // 从最粗的一级往回找，第一个投影误差不超过阈值的就是要用的
+    for (unsigned int lod = (unsigned int)lods.size() - 1; lod > 0; lod--)
+    {
+        if (lods[lod].error * pixelsPerUnit <= view.maxPixelError)
+        {
+            return lod;
+        }
+    }
+    return 0;
+}
+
+float Mesh::ScreenSize(const glm::mat4 &modelMatrix, const LodView &view) const
+{
+    float pixelsPerUnit;
+    if (!project(modelMatrix, view, pixelsPerUnit))
+    {
+        return FLT_MAX;
+    }
+    return 2.0f * _boundsRadius * pixelsPerUnit;
+}
+
+MeshUniforms::MeshUniforms(Shader &shader)
+{
+    model = shader.Uniform<glm::mat4>("model");
+    normalMatrix = shader.Uniform<glm::mat3>("normalMatrix");
+    positionScale = shader.Uniform<glm::vec3>("positionScale");
+    positionOffset = shader.Uniform<glm::vec3>("positionOffset");
+    octahedralNormal = shader.Uniform<bool>("octahedralNormal");
+    diffuseArray = shader.Uniform<int>("material.diffuseArray");
+    specularArray = shader.Uniform<int>("material.specularArray");
+    diffuseLayer = shader.Uniform<float>("material.diffuseLayer");
+    specularLayer = shader.Uniform<float>("material.specularLayer");
+    for (unsigned int i = 0; i < MAX_TEXTURES; i++)
+    {
+        std::stringstream number;
+        number << i + 1;
+        diffuse[i] = shader.Uniform<int>("material.texture_diffuse" + number.str());
+        specular[i] = shader.Uniform<int>("material.texture_specular" + number.str());
+    }
+}
+
+void Mesh::Draw(Shader &shader, const MeshUniforms &uniforms, unsigned int lod)
+{
+    bindTextures(shader, uniforms);
+
+    // 反量化参数，非量化的mesh也要设置，保证同一个shader可以混合绘制两种格式
+    shader.Set(uniforms.positionScale, _positionScale);
+    shader.Set(uniforms.positionOffset, _positionOffset);
+    shader.Set(uniforms.octahedralNormal, _quantized);
+
+    // LOD 是同一个索引缓冲里的一段
+    unsigned int firstIndex = 0, indexCount = _indexCount;
+    if (lod < lods.size())
+    {
+        firstIndex = lods[lod].firstIndex;
+        indexCount = lods[lod].indexCount;
+    }
 
+    if (_pool)
+    {
+        GeometryRange range = _range;
+        range.firstIndex += firstIndex;
+        range.indexCount = indexCount;
+        _pool->Draw(range);
+        return;
+    }
+
+    glBindVertexArray(_VAO.Id());
+    glDrawElements(GL_TRIANGLES, indexCount, _indexType, (GLvoid*)(_indexOffset + firstIndex * indexSize(_indexType)));
     glBindVertexArray(0);
+    RenderStats::Instance().vaoBinds++;
+    RenderStats::Instance().drawCalls++;
+    RenderStats::Instance().triangles += indexCount / 3;
 }
 
-void Mesh::Draw(Shader &shader)
+void Mesh::bindTextures(Shader &shader, const MeshUniforms &uniforms)
 {
-    unsigned int diffuseNr = 1;
-    unsigned int specularNr = 1;
+    unsigned int diffuseNr = 0;
+    unsigned int specularNr = 0;
+    float diffuseLayer = -1.0f;
+    float specularLayer = -1.0f;
 
     for (unsigned int i = 0; i < textures.size(); i++)
     {
+        const std::string &type = this->textures[i].type;
+        if (textures[i].layer >= 0)
+        {
+            // 纹理数组由 Model::draw 统一绑定，这里只需要告诉shader用哪一层
+            if (type == "texture_diffuse")
+                diffuseLayer = (float)textures[i].layer;
+            else if (type == "texture_specular")
+                specularLayer = (float)textures[i].layer;
+            continue;
+        }
+
+        // 按类型的序号 N 对应 material.texture_diffuseN / texture_specularN，超出句柄数的贴图着色器用不到
+        ShaderUniform<int> sampler;
+        if (type == "texture_diffuse" && diffuseNr < MeshUniforms::MAX_TEXTURES)
+            sampler = uniforms.diffuse[diffuseNr++];
+        else if (type == "texture_specular" && specularNr < MeshUniforms::MAX_TEXTURES)
+            sampler = uniforms.specular[specularNr++];
+        else
+            continue;
+
         glActiveTexture(GL_TEXTURE0 + i); // 在绑定纹理前需要激活适当的纹理单元
-        // 检索纹理序列号 (N in diffuse_textureN)
-        std::stringstream ss;
-        std::string type = this->textures[i].type;
-        if (type == "texture_diffuse")
+        shader.Set(sampler, (int)i);
+        glBindTexture(GL_TEXTURE_2D, textures[i].id);
+        RenderStats::Instance().textureBinds++;
+    }
+
+    // 数组采样器必须和普通采样器使用不同的纹理单元，否则绘制时会报 GL_INVALID_OPERATION
+    shader.Set(uniforms.diffuseArray, (int)DIFFUSE_ARRAY_UNIT);
+    shader.Set(uniforms.specularArray, (int)SPECULAR_ARRAY_UNIT);
+    shader.Set(uniforms.diffuseLayer, diffuseLayer);
+    shader.Set(uniforms.specularLayer, specularLayer);
+}
+
+Model::Model(const std::string &path, unsigned int uploadFlags, unsigned int loadFlags) :
+    _path(path), _uploadFlags(uploadFlags), _loadFlags(loadFlags)
+{
+    if (GltfLoader::IsGlb(path))
+    {
+        loadGlb(path, uploadFlags);
+        return;
+    }
+    ModelData data;
+    if (LoadData(path, data, loadFlags))
+    {
+        upload(std::move(data), uploadFlags);
+    }
+}
+
+Model::Model(ModelData &&data, unsigned int uploadFlags) : _uploadFlags(uploadFlags), _loadFlags(MODEL_LOAD_DEFAULT)
+{
+    upload(std::move(data), uploadFlags);
+}
+
+GeometryPool &Model::SharedPool()
+{
+    static GeometryPool pool(sizeof(Vertex), &Mesh::SetupAttributes);
+    return pool;
+}
+
+GeometryPool &Model::SharedQuantizedPool()
+{
+    static GeometryPool pool(sizeof(PackedVertex), &VertexQuantizer::SetupAttributes, GL_UNSIGNED_SHORT);
+    return pool;
+}
+
+void Model::ReleaseSharedPools()
+{
+    SharedPool().Reset();
+    SharedQuantizedPool().Reset();
+}
+
+bool Model::Reload()
+{
+    bool reloaded = false;
+    if (!_path.empty() && GltfLoader::IsGlb(_path))
+    {
+        reloaded = loadGlb(_path, _uploadFlags);
+    }
+    else if (!_path.empty())
+    {
+        // 新数据导入成功后先释放旧的mesh，共享缓冲里的区间还给空闲表，新数据上传时复用；
+        // 旧贴图的引用保留到上传结束，没有变化的贴图直接命中缓存，不重新解码
+        ModelData data;
+        reloaded = LoadData(_path, data, _loadFlags) && !data.meshes.empty();
+        if (reloaded)
         {
-            ss << diffuseNr++;
+            std::vector<TextureHandle> previousTextures;
+            for (unsigned int i = 0; i < meshes.size(); i++)
+            {
+                for (unsigned int t = 0; t < meshes[i].textures.size(); t++)
+                    previousTextures.push_back(meshes[i].textures[t].handle);
+            }
+            meshes.clear();
+            upload(std::move(data), _uploadFlags);
         }
-        else if (type == "texture_specular")
+    }
+    if (!reloaded)
+    {
+        std::cout << "ERROR::MODEL::RELOAD_FAILED keep previous meshes: " << _path << std::endl;
+        return false;
+    }
+    std::cout << "MODEL::RELOAD " << _path << " meshes: " << meshes.size() << std::endl;
+    return true;
+}
+
+bool Model::Uses(const std::string &path) const
+{
+    if (_path.empty())
+        return false;
+    return path == _path || std::find(_dependencies.begin(), _dependencies.end(), path) != _dependencies.end();
+}
+
+void Model::recordDependencies(const ModelData &data)
+{
+    _dependencies.clear();
+    for (size_t i = 0; i < data.dependencies.size(); i++)
+        _dependencies.push_back(data.directory + "/" + data.dependencies[i].path);
+    for (size_t i = 0; i < data.meshes.size(); i++)
+    {
+        for (size_t t = 0; t < data.meshes[i].textures.size(); t++)
         {
-            ss << specularNr++;
+            std::string path = data.directory + "/" + data.meshes[i].textures[t].path;
+            if (std::find(_dependencies.begin(), _dependencies.end(), path) == _dependencies.end())
+                _dependencies.push_back(path);
         }
-        std::string number;
-        number = ss.str(); // 转换整数为字符串
-        shader.setInt("material." + type + number, i);
-        // shader.setInt(type + number, i);
-        glBindTexture(GL_TEXTURE_2D, textures[i].id);
     }
+}
 
-    // shader.setFloat("material.shininess", 32.0f);
+void Model::Draw(Shader &shader)
+{
+    draw(shader, nullptr, nullptr);
+}
 
-    glBindVertexArray(_VAO);
-    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+void Model::Draw(Shader &shader, const glm::mat4 &modelMatrix, const LodView &view)
+{
+    draw(shader, &modelMatrix, &view);
 }
 
-Model::Model(const std::string &path)
+const MeshUniforms &Model::uniformsFor(Shader &shader)
 {
-    loadModel(path);
+    for (size_t i = 0; i < _uniforms.size(); i++)
+    {
+        if (_uniforms[i].first == &shader)
+            return _uniforms[i].second;
+    }
+    _uniforms.push_back(std::make_pair(&shader, MeshUniforms(shader)));
+    return _uniforms.back().second;
 }
 
-void Model::Draw(Shader &shader)
+void Model::draw(Shader &shader, const glm::mat4 *modelMatrix, const LodView *view)
 {
+    // 打包模式：连续的同一个共享缓冲里的mesh只绑定一次VAO，各mesh按 baseVertex 偏移绘制；
+    // 单独持有VAO的mesh（比如顶点数超过 16 位索引范围的量化mesh）绘制后会解绑VAO
+    // 纹理数组只在和上一个mesh不同时才重新绑定
+    GeometryPool *bound = nullptr;
+    unsigned int boundArrays[2] = { 0, 0 };
+    // 节点的世界矩阵只在层级有变化时重新计算；连续的mesh在同一个节点上时不重复设置 model
+    _scene.Update();
+    const MeshUniforms &uniforms = uniformsFor(shader);
+    glm::mat4 parent = modelMatrix ? *modelMatrix : glm::mat4(1.0f);
+    glm::mat4 meshMatrix;
+    int currentNode = -1;
     for (unsigned int i = 0; i < meshes.size(); i++)
     {
-        meshes[i].Draw(shader);
+        if ((int)meshes[i].node != currentNode)
+        {
+            currentNode = (int)meshes[i].node;
+            meshMatrix = parent * _scene.World(currentNode);
+            shader.Set(uniforms.model, meshMatrix);
+            shader.Set(uniforms.normalMatrix, glm::transpose(glm::inverse(glm::mat3(meshMatrix))));
+        }
+        GeometryPool *pool = meshes[i].Pool();
+        if (pool && pool != bound)
+        {
+            pool->Bind();
+        }
+        bound = pool;
+        // 把mesh的屏幕尺寸上报给用到的纹理，流式加载据此决定先补哪张纹理的高精度 mip
+        float screenSize = view ? meshes[i].ScreenSize(meshMatrix, *view) : 0.0f;
+        for (unsigned int t = 0; t < meshes[i].textures.size(); t++)
+        {
+            const Texture &texture = meshes[i].textures[t];
+            if (view && texture.handle)
+            {
+                texture.handle->RequestScreenSize(screenSize);
+            }
+            if (texture.layer < 0)
+            {
+                continue;
+            }
+            int slot = texture.type == "texture_diffuse" ? 0 : 1;
+            if (boundArrays[slot] != texture.id)
+            {
+                glActiveTexture(GL_TEXTURE0 + (slot == 0 ? Mesh::DIFFUSE_ARRAY_UNIT : Mesh::SPECULAR_ARRAY_UNIT));
+                glBindTexture(GL_TEXTURE_2D_ARRAY, texture.id);
+                boundArrays[slot] = texture.id;
+                RenderStats::Instance().textureBinds++;
+            }
+        }
+        unsigned int lod = view ? meshes[i].SelectLod(meshMatrix, *view) : 0;
+        meshes[i].Draw(shader, uniforms, lod);
+    }
+    if (bound)
+    {
+        glBindVertexArray(0);
+    }
+}
+
+bool Model::LoadData(const std::string& path, ModelData &data, unsigned int flags)
+{
+    TRACE_ZONE_DETAIL("Model::LoadData", path);
+    data.directory = path.substr(0, path.find_last_of('/'));
+
+    // 优先使用二进制缓存，命中时完全跳过Assimp。缓存只在优化、LOD 和导入器都和这次要求的一致时使用
+    bool nativeObj = (flags & MODEL_LOAD_NATIVE_OBJ) && ObjLoader::IsObj(path);
+    unsigned int buildFlags = (flags & (MODEL_LOAD_OPTIMIZE | MODEL_LOAD_LODS)) | (nativeObj ? MODEL_LOAD_NATIVE_OBJ : 0);
+    if ((flags & MODEL_LOAD_USE_CACHE) && loadFromCache(path, data, buildFlags))
+    {
+        return true;
+    }
+
+    // 导入前记下源文件的来源，缓存记录的是这次实际读到的内容
+    uint64_t sourceSize = 0;
+    int64_t sourceMtime = 0;
+    bool hasSource = AssetPack::Instance().Stamp(path, sourceSize, sourceMtime);
+    bool loaded = false;
+    if (nativeObj)
+    {
+        loaded = ObjLoader::Load(path, data);
+        if (!loaded)
+        {
+            std::cout << "ERROR::MODEL::NATIVE_OBJ_FAILED fall back to Assimp: " << path << std::endl;
+            buildFlags &= ~MODEL_LOAD_NATIVE_OBJ; // 缓存里记录实际使用的导入器
+        }
+    }
+    if (!loaded && !loadWithAssimp(path, data))
+    {
+        return false;
     }
+
+    if (flags & MODEL_LOAD_OPTIMIZE)
+    {
+        TRACE_ZONE("Model::optimizeMeshes");
+        optimizeMeshes(data);
+    }
+    if (flags & MODEL_LOAD_LODS)
+    {
+        TRACE_ZONE("Model::generateLods");
+        generateLods(data);
+    }
+    if ((flags & MODEL_LOAD_USE_CACHE) && hasSource)
+    {
+        TRACE_ZONE("MeshCache::Write");
+        MeshCache::Write(path, data.meshes, data.nodes, data.dependencies, buildFlags, sourceSize, sourceMtime);
+    }
+    return true;
 }
 
-void Model::loadModel(const std::string& path)
+bool Model::loadWithAssimp(const std::string &path, ModelData &data)
 {
+    size_t peakBefore = PeakResidentBytes();
     Assimp::Importer import;
-    const aiScene* scene = import.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs); 
+    data.dependencies.clear();
+    import.SetIOHandler(new PackIOSystem(path, data));
+    const aiScene* scene;
+    {
+        TRACE_ZONE_DETAIL("Assimp::ReadFile", path);
+        scene = import.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
+    }
 
     if(!scene || scene->mFlags == AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) 
     {
         std::cout << "ERROR::ASSIMP::" << import.GetErrorString() << std::endl;
+        return false;
+    }
+
+    // 这次导入的临时数据都从 arena 分配，函数返回时整块释放；
+    // 输出的顶点和索引会交给 Mesh 和 .meshcache，不放进 arena，而是按 mNumVertices/mNumFaces 一次预留
+    MonotonicArena arena(estimateMaterialBytes(scene));
+    const ImportMaterial *materials = loadMaterials(scene, arena);
+
+    size_t nodeCount = 0, meshCount = 0;
+    countNodes(scene->mRootNode, nodeCount, meshCount);
+    data.meshes.clear();
+    data.nodes.clear();
+    data.meshes.reserve(meshCount);
+    data.nodes.reserve(nodeCount);
+    processNode(scene->mRootNode, scene, materials, data, -1);
+
+    size_t vertices = 0;
+    for (size_t i = 0; i < data.meshes.size(); i++)
+        vertices += data.meshes[i].vertices.size();
+    size_t peakAfter = PeakResidentBytes();
+    std::cout << "MODEL::IMPORT " << data.meshes.size() << " meshes, " << vertices << " vertices, arena "
+              << arena.Allocations() << " allocations / " << arena.BytesUsed() << " bytes in "
+              << arena.Blocks() << " blocks, peak RSS " << peakAfter / (1024.0 * 1024.0) << " MB (+"
+              << (peakAfter - std::min(peakBefore, peakAfter)) / (1024.0 * 1024.0) << " MB)" << std::endl;
+    return true;
+}
+
+void Model::optimizeMeshes(ModelData &data)
+{
+    size_t verticesBefore = 0, verticesAfter = 0, triangles = 0;
+    float missesBefore = 0.0f, missesAfter = 0.0f;
+    for (unsigned int i = 0; i < data.meshes.size(); i++)
+    {
+        MeshData &mesh = data.meshes[i];
+        size_t meshTriangles = mesh.indices.size() / 3;
+        VertexCacheStats before = MeshOptimizer::AnalyzeVertexCache(mesh.indices, mesh.vertices.size());
+        verticesBefore += mesh.vertices.size();
+
+        MeshOptimizer::Optimize(mesh);
+
+        VertexCacheStats after = MeshOptimizer::AnalyzeVertexCache(mesh.indices, mesh.vertices.size());
+        verticesAfter += mesh.vertices.size();
+        missesBefore += before.acmr * meshTriangles;
+        missesAfter += after.acmr * meshTriangles;
+        triangles += meshTriangles;
+    }
+    if (triangles == 0)
+    {
         return;
     }
-    this->directory = path.substr(0, path.find_last_of('/'));
 
-    this->processNode(scene->mRootNode, scene);
+    std::cout << "MODEL::OPTIMIZE vertices " << verticesBefore << " -> " << verticesAfter
+              << ", ACMR " << missesBefore / triangles << " -> " << missesAfter / triangles
+              << ", ATVR " << (verticesAfter ? missesBefore / verticesAfter : 0.0f)
+              << " -> " << (verticesAfter ? missesAfter / verticesAfter : 0.0f) << std::endl;
 }
 
-void Model::processNode(aiNode* node, const aiScene* scene)
+void Model::generateLods(ModelData &data)
 {
+    std::vector<size_t> lodTriangles(MeshSimplifier::MAX_LODS, 0);
+    for (unsigned int i = 0; i < data.meshes.size(); i++)
+    {
+        MeshData &mesh = data.meshes[i];
+        MeshSimplifier::GenerateLods(mesh);
+        // 级数不够的mesh在更粗的级别上继续使用它最粗的一级
+        for (unsigned int lod = 0; lod < lodTriangles.size(); lod++)
+        {
+            if (mesh.lods.empty())
+                lodTriangles[lod] += mesh.indices.size() / 3;
+            else
+                lodTriangles[lod] += mesh.lods[std::min<size_t>(lod, mesh.lods.size() - 1)].indexCount / 3;
+        }
+    }
+
+    std::cout << "MODEL::LOD triangles";
+    for (unsigned int lod = 0; lod < lodTriangles.size(); lod++)
+    {
+        std::cout << (lod ? " / " : " ") << lodTriangles[lod];
+    }
+    std::cout << std::endl;
+}
+
+bool Model::loadFromCache(const std::string &path, ModelData &data, unsigned int buildFlags)
+{
+    TRACE_ZONE("Model::loadFromCache");
+    std::shared_ptr<MeshCache> cache = std::make_shared<MeshCache>();
+    if (!cache->Open(path, buildFlags))
+    {
+        return false;
+    }
+
+    // 顶点和索引不复制，mesh 直接引用映射，上传时从映射写进GL缓冲
+    data.meshes.resize(cache->MeshCount());
+    for (unsigned int i = 0; i < cache->MeshCount(); i++)
+    {
+        MeshData &mesh = data.meshes[i];
+        mesh.mappedVertices = cache->Vertices(i);
+        mesh.mappedVertexCount = cache->VertexCount(i);
+        mesh.mappedIndices = cache->Indices(i);
+        mesh.mappedIndexCount = cache->IndexCount(i);
+        mesh.textures = cache->Textures(i);
+        mesh.lods = cache->Lods(i);
+        mesh.node = cache->Node(i);
+    }
+    data.nodes = cache->Nodes();
+    data.dependencies = cache->Dependencies();
+    data.cache = cache;
+    return true;
+}
+
+void Model::buildScene(const std::vector<NodeData> &nodes)
+{
+    _scene.Clear();
+    for (unsigned int i = 0; i < nodes.size(); i++)
+    {
+        _scene.AddNode(nodes[i].parent, nodes[i].transform, nodes[i].name);
+    }
+    if (_scene.NodeCount() == 0)
+    {
+        _scene.AddNode(-1, glm::mat4(1.0f), "root");
+    }
+    for (unsigned int i = 0; i < meshes.size(); i++)
+    {
+        if (meshes[i].node >= _scene.NodeCount())
+        {
+            meshes[i].node = 0;
+        }
+    }
+    _scene.Update();
+}
+
+void Model::upload(ModelData &&data, unsigned int uploadFlags)
+{
+    TRACE_ZONE("Model::upload");
+    this->directory = data.directory;
+    bool packed = (uploadFlags & MODEL_UPLOAD_PACKED) != 0;
+    bool quantize = (uploadFlags & MODEL_UPLOAD_QUANTIZED) != 0;
+
+    recordDependencies(data);
+
+    // 先把所有贴图提交给后台线程解码，解码期间在GL线程上传顶点数据
+    std::vector<std::vector<Texture> > textures = (uploadFlags & MODEL_UPLOAD_TEXTURE_ARRAYS)
+        ? loadTextureArrays(data) : loadTextures(data);
+
+    size_t bytesBefore = 0, bytesAfter = 0;
+    float maxPositionError = 0.0f, maxNormalError = 0.0f, maxTexCoordError = 0.0f;
+    this->meshes.reserve(data.meshes.size());
+    for (unsigned int i = 0; i < data.meshes.size(); i++)
+    {
+        if (!quantize)
+        {
+            this->meshes.push_back(Mesh(std::move(data.meshes[i]), std::move(textures[i])));
+            this->meshes.back().Upload(packed ? &SharedPool() : nullptr);
+            continue;
+        }
+
+        QuantizedMesh quantized = VertexQuantizer::Quantize(data.meshes[i]);
+        bytesBefore += data.meshes[i].VertexCount() * sizeof(Vertex) + data.meshes[i].IndexCount() * sizeof(unsigned int);
+        bytesAfter += quantized.Bytes();
+        maxPositionError = std::max(maxPositionError, quantized.maxPositionError);
+        maxNormalError = std::max(maxNormalError, quantized.maxNormalError);
+        maxTexCoordError = std::max(maxTexCoordError, quantized.maxTexCoordError);
+
+        // 共享的量化缓冲只接受 16 位索引，超出范围的mesh单独创建VAO
+        GeometryPool *pool = packed && quantized.Uses16BitIndices() ? &SharedQuantizedPool() : nullptr;
+        this->meshes.push_back(Mesh(std::move(data.meshes[i]), std::move(textures[i])));
+        this->meshes.back().Upload(pool, &quantized);
+    }
+
+    if (quantize && bytesBefore > 0)
+    {
+        std::cout << "MODEL::QUANTIZE bytes " << bytesBefore << " -> " << bytesAfter
+                  << ", max error position " << maxPositionError
+                  << " normal " << maxNormalError << " deg"
+                  << " uv " << maxTexCoordError << std::endl;
+    }
+
+    buildScene(data.nodes);
+
+    // 等待后台线程解码完成后统一上传贴图
+    TextureManager::Instance().FinishPending();
+}
+
+bool Model::loadGlb(const std::string &path, unsigned int uploadFlags)
+{
+    TRACE_ZONE_DETAIL("Model::loadGlb", path);
+    GltfData gltf;
+    if (!GltfLoader::Load(path, gltf) || gltf.primitives.empty())
+    {
+        return false;
+    }
+    this->directory = gltf.directory;
+
+    // 贴图沿用 ModelData 的加载流程（包括纹理数组），只需要每个mesh的贴图引用
+    ModelData data;
+    data.directory = gltf.directory;
+    data.meshes.resize(gltf.primitives.size());
+    for (unsigned int i = 0; i < gltf.primitives.size(); i++)
+    {
+        data.meshes[i].textures = gltf.primitives[i].textures;
+    }
+    std::vector<std::vector<Texture> > textures = (uploadFlags & MODEL_UPLOAD_TEXTURE_ARRAYS)
+        ? loadTextureArrays(data) : loadTextures(data);
+
+    // 用到的 bufferView 各自从映射的文件直接上传一次，多个 primitive 共享；
+    // 顶点属性按 accessor 的类型、偏移和 bufferView 的步长设置，不做任何逐顶点的处理
+    std::vector<GLBuffer> buffers(gltf.bufferViews.size());
+    std::vector<Mesh> loaded;
+    loaded.reserve(gltf.primitives.size());
+    size_t bytes = 0;
+    unsigned int bufferCount = 0;
+    for (unsigned int i = 0; i < gltf.primitives.size(); i++)
+    {
+        const GltfPrimitive &primitive = gltf.primitives[i];
+        const int accessors[4] = { primitive.position, primitive.normal, primitive.texCoord, primitive.indices };
+        GLuint ids[4] = { 0, 0, 0, 0 };
+        for (int a = 0; a < 4; a++)
+        {
+            if (accessors[a] < 0)
+            {
+                continue;
+            }
+            int view = gltf.accessors[accessors[a]].bufferView;
+            if (!buffers[view].IsValid())
+            {
+                const GltfBufferView &range = gltf.bufferViews[view];
+                buffers[view].Create();
+                glBindBuffer(GL_ARRAY_BUFFER, buffers[view].Id());
+                glBufferData(GL_ARRAY_BUFFER, range.length, gltf.binary + range.offset, GL_STATIC_DRAW);
+                bytes += range.length;
+                bufferCount++;
+            }
+            ids[a] = buffers[view].Id();
+        }
+
+        VertexAttributeSource attributes[3];
+        for (int a = 0; a < 3; a++)
+        {
+            VertexAttributeSource &source = attributes[a];
+            memset(&source, 0, sizeof(source));
+            if (accessors[a] < 0)
+            {
+                continue;
+            }
+            const GltfAccessor &accessor = gltf.accessors[accessors[a]];
+            source.buffer = ids[a];
+            source.components = accessor.components;
+            source.type = accessor.componentType;
+            source.normalized = accessor.normalized ? GL_TRUE : GL_FALSE;
+            source.stride = gltf.bufferViews[accessor.bufferView].stride;
+            source.offset = accessor.offset;
+        }
+        const GltfAccessor &position = gltf.accessors[primitive.position];
+        const GltfAccessor &indices = gltf.accessors[primitive.indices];
+        MeshData placement;
+        placement.node = primitive.node;
+        loaded.push_back(Mesh(std::move(placement), std::move(textures[i])));
+        loaded.back().UploadExternal(attributes, ids[3], indices.componentType, indices.offset, indices.count,
+                                     position.min, position.max);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    TextureManager::Instance().FinishPending();
+
+    // 全部上传完成后才替换，旧的mesh和缓冲在函数返回时释放
+    meshes.swap(loaded);
+    _buffers.swap(buffers);
+    recordDependencies(data);
+    buildScene(gltf.nodes);
+    std::cout << "MODEL::GLB " << path << " meshes: " << meshes.size() << " buffers: " << bufferCount
+              << " bytes: " << bytes << std::endl;
+    return true;
+}
+
+std::vector<std::vector<Texture> > Model::loadTextures(const ModelData &data)
+{
+    std::vector<std::vector<Texture> > textures(data.meshes.size());
+    for (unsigned int i = 0; i < data.meshes.size(); i++)
+    {
+        const std::vector<TextureRef> &refs = data.meshes[i].textures;
+        for (unsigned int t = 0; t < refs.size(); t++)
+        {
+            Texture texture;
+            // 只有漫反射贴图是颜色数据，高光贴图按线性数据生成 mipmap
+            texture.handle = TextureFromFile(refs[t].path.c_str(), this->directory, refs[t].type == "texture_diffuse");
+            if (!texture.handle)
+            {
+                continue; // 缺失或解码失败的贴图由 TextureManager 报错，mesh 不使用它
+            }
+            texture.id = texture.handle->id;
+            texture.type = refs[t].type;
+            texture.path = refs[t].path;
+            textures[i].push_back(texture);
+        }
+    }
+    return textures;
+}
+
+std::vector<std::vector<Texture> > Model::loadTextureArrays(const ModelData &data)
+{
+    // 按 (类型, 宽, 高) 分组，只读图片头拿尺寸；同一张图片在组内只占一层
+    typedef std::pair<std::string, std::pair<int, int> > GroupKey;
+    std::map<GroupKey, std::vector<std::string> > groups;
+    std::map<std::pair<std::string, std::string>, std::pair<GroupKey, int> > layers;
+    for (unsigned int i = 0; i < data.meshes.size(); i++)
+    {
+        const std::vector<TextureRef> &refs = data.meshes[i].textures;
+        for (unsigned int t = 0; t < refs.size(); t++)
+        {
+            std::pair<std::string, std::string> id(refs[t].type, refs[t].path);
+            if (layers.count(id))
+            {
+                continue;
+            }
+            int width = 0, height = 0, components = 0;
+            if (!imageInfo(this->directory + '/' + refs[t].path, width, height, components))
+            {
+                continue; // 读不到尺寸的贴图退回普通纹理，由 TextureManager 报错
+            }
+            GroupKey key(refs[t].type, std::make_pair(width, height));
+            layers[id] = std::make_pair(key, (int)groups[key].size());
+            groups[key].push_back(refs[t].path);
+        }
+    }
+
+    std::map<GroupKey, TextureHandle> arrays;
+    for (std::map<GroupKey, std::vector<std::string> >::iterator it = groups.begin(); it != groups.end(); ++it)
+    {
+        std::vector<std::string> paths;
+        for (unsigned int p = 0; p < it->second.size(); p++)
+        {
+            paths.push_back(this->directory + '/' + it->second[p]);
+        }
+        arrays[it->first] = TextureManager::Instance().LoadArray(paths, GL_RGB, GL_REPEAT, it->first.first == "texture_diffuse");
+    }
+
+    std::vector<std::vector<Texture> > textures(data.meshes.size());
+    unsigned int arrayLayers = 0, fallbacks = 0;
+    for (unsigned int i = 0; i < data.meshes.size(); i++)
+    {
+        const std::vector<TextureRef> &refs = data.meshes[i].textures;
+        for (unsigned int t = 0; t < refs.size(); t++)
+        {
+            Texture texture;
+            texture.type = refs[t].type;
+            texture.path = refs[t].path;
+            std::map<std::pair<std::string, std::string>, std::pair<GroupKey, int> >::iterator layer =
+                layers.find(std::make_pair(refs[t].type, refs[t].path));
+            if (layer != layers.end() && arrays[layer->second.first])
+            {
+                texture.handle = arrays[layer->second.first];
+                texture.layer = layer->second.second;
+                arrayLayers++;
+            }
+            else
+            {
+                texture.handle = TextureFromFile(refs[t].path.c_str(), this->directory, refs[t].type == "texture_diffuse");
+                fallbacks++;
+            }
+            if (!texture.handle)
+            {
+                continue;
+            }
+            texture.id = texture.handle->id;
+            textures[i].push_back(texture);
+        }
+    }
+
+    std::cout << "MODEL::TEXTURE_ARRAYS " << arrays.size() << " arrays for " << arrayLayers
+              << " mesh textures, " << fallbacks << " separate textures" << std::endl;
+    return textures;
+}
+
+void Model::processNode(aiNode* node, const aiScene* scene, const ImportMaterial *materials, ModelData &data, int parent)
+{
+    // 先序遍历记录节点，父节点总在子节点前面；aiMatrix4x4 是行主序，glm 是列主序
+    NodeData nodeData;
+    nodeData.parent = parent;
+    nodeData.transform = glm::transpose(glm::make_mat4(&node->mTransformation.a1));
+    nodeData.name = node->mName.C_Str();
+    unsigned int index = (unsigned int)data.nodes.size();
+    data.nodes.push_back(nodeData);
+
     // 添加当前节点中的所有Mesh
     for(unsigned int i = 0; i < node->mNumMeshes; i++)
     {
         aiMesh* mesh = scene->mMeshes[node->mMeshes[i]]; 
-        this->meshes.push_back(this->processMesh(mesh, scene)); 
+        data.meshes.push_back(processMesh(mesh, scene, materials));
+        data.meshes.back().node = index;
     }
     // 递归处理该节点的子孙节点
     for(unsigned int i = 0; i < node->mNumChildren; i++)
     {
-        this->processNode(node->mChildren[i], scene);
+        processNode(node->mChildren[i], scene, materials, data, (int)index);
     }
 }
 
-Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene)
+MeshData Model::processMesh(aiMesh* mesh, const aiScene* scene, const ImportMaterial *materials)
 {
+    TRACE_ZONE_DETAIL("Model::processMesh", mesh->mName.C_Str());
     // 要提取的数据
-    std::vector<Vertex> vertices;
-    std::vector<GLuint> indices;
-    std::vector<Texture> textures;
+    MeshData data;
+    std::vector<Vertex> &vertices = data.vertices;
+    std::vector<GLuint> &indices = data.indices;
+    std::vector<TextureRef> &textures = data.textures;
+    // 开 aiProcess_Triangulate 后每个面最多 3 个索引，按上限一次预留，避免 push_back 反复扩容
+    vertices.reserve(mesh->mNumVertices);
+    indices.reserve((size_t)mesh->mNumFaces * 3);
 
     // 遍历每个mesh的顶点数据
     for(unsigned int i = 0; i < mesh->mNumVertices; i++)
@@ -159,75 +1112,76 @@ Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene)
     // 下面，提取顶点的索引数据
     for(unsigned int i = 0; i < mesh->mNumFaces; i++)
     {
-        aiFace face = mesh->mFaces[i];
+        const aiFace &face = mesh->mFaces[i]; // aiFace 的拷贝会重新分配索引数组
         for(unsigned int j = 0; j < face.mNumIndices; j++)
         {
             indices.push_back(face.mIndices[j]);
         }
     }
 
-    // 提取材质信息 materials
-    if(mesh->mMaterialIndex >= 0)
+    // 提取材质信息 materials，贴图引用在 loadMaterials 里按材质准备好了
+    if(mesh->mMaterialIndex < scene->mNumMaterials)
     {
-        aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
+        const ImportMaterial &material = materials[mesh->mMaterialIndex];
+        textures.resize(material.count);
+        for (unsigned int i = 0; i < material.count; i++)
+        {
+            textures[i].type = material.textures[i].type;
+            textures[i].path = material.textures[i].path;
+        }
+    }
+    
+    // 返回纯CPU的 mesh 数据，GL缓存在 Model::upload 中创建
+    return data;
+}
+
+const ImportMaterial *Model::loadMaterials(const aiScene *scene, MonotonicArena &arena)
+{
+    ImportMaterial *materials = arena.AllocateArray<ImportMaterial>(scene->mNumMaterials);
+    for (unsigned int m = 0; m < scene->mNumMaterials; m++)
+    {
+        aiMaterial *material = scene->mMaterials[m];
         // We assume a convention for sampler names in the shaders. Each diffuse texture should be named
         // as 'texture_diffuseN' where N is a sequential number ranging from 1 to MAX_SAMPLER_NUMBER. 
         // Same applies to other texture as the following list summarizes:
         // Diffuse: texture_diffuseN
         // Specular: texture_specularN
         // Normal: texture_normalN
-
+        // 先数出贴图数，在 arena 里分配一个和导入同生命周期的数组直接填写
+        unsigned int count = material->GetTextureCount(aiTextureType_DIFFUSE) + material->GetTextureCount(aiTextureType_SPECULAR);
+        ImportTexture *textures = count > 0 ? arena.AllocateArray<ImportTexture>(count) : nullptr;
+        unsigned int filled = 0;
         // 1. Diffuse maps
-        std::vector<Texture> diffuseMaps = this->loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
-        textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
+        filled += loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse", arena, textures + filled);
         // 2. Specular maps
-        std::vector<Texture> specularMaps = this->loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
-        textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+        filled += loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular", arena, textures + filled);
+
+        materials[m].textures = textures;
+        materials[m].count = filled;
     }
-    
-    // 返回一个 Mesh 实例
-    return Mesh(vertices, indices, textures);
+    return materials;
 }
 
-// 加载纹理资源
-std::vector<Texture> Model::loadMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName)
+// 记录纹理资源的路径，真正的加载在GL线程进行
+unsigned int Model::loadMaterialTextures(aiMaterial* mat, aiTextureType type, const char *typeName, MonotonicArena &arena,
+                                         ImportTexture *textures)
 {
-    std::vector<Texture> textures;
-    for(unsigned int i = 0; i < mat->GetTextureCount(type); i++)
+    unsigned int count = mat->GetTextureCount(type);
+    for(unsigned int i = 0; i < count; i++)
     {
         aiString str;
         mat->GetTexture(type, i, &str);
-        Texture texture;
-        texture.id = TextureFromFile(str.C_Str(), this->directory);
-        texture.type = typeName;
-        // texture.path = str;
-        textures.push_back(texture);
+        textures[i].type = typeName;
+        textures[i].path = arena.CopyString(str.C_Str(), str.length);
     }
-    return textures;
+    return count;
 }
 
-unsigned int Model::TextureFromFile(const char* path, const std::string &directory)
+TextureHandle Model::TextureFromFile(const char* path, const std::string &directory, bool srgb)
 {
-    // 生成 texture ID 并加载纹理数据
+    // 多个mesh共用同一张贴图时，纹理管理器只会解码、上传一次；
+    // 解码在后台线程进行，Model::upload 结束前统一上传
     std::string filename = std::string(path);
     filename = directory + '/' + filename;
-    GLuint textureID;
-    glGenTextures(1, &textureID);
-    int width, height, nrChannels;
-    unsigned char* image = stbi_load(filename.c_str(), &width, &height, &nrChannels, 0);
-    // Assign texture to ID
-    glBindTexture(GL_TEXTURE_2D, textureID);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-    glGenerateMipmap(GL_TEXTURE_2D);	
-
-    // Parameters
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glBindTexture(GL_TEXTURE_2D, 0);
-    stbi_image_free(image);
-    return textureID;
+    return TextureManager::Instance().LoadAsync(filename, GL_RGB, GL_REPEAT, srgb);
 }
-
-
@@ -3,6 +3,14 @@
 
 #include "glm/glm.hpp"
 #include "shader.hpp"
+#include "glObjects.h"
+#include "geometryPool.h"
+#include "textureManager.h"
+#include "vertexQuantizer.h"
+#include "sceneGraph.h"
+#include "monotonicArena.h"
+#include <stdint.h>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -10,6 +18,8 @@
 #include "assimp/scene.h"
 #include "assimp/postprocess.h"
 
+class MeshCache;
+
 struct Vertex
 {
     glm::vec3 Position;
@@ -21,48 +31,291 @@ struct Texture
 {
     unsigned int id;
     std::string type; // 储存纹理的id和它的类型，比如diffuse纹理或者specular纹理。
+    std::string path;
+    TextureHandle handle; // 持有共享纹理的引用，保证纹理在Mesh存活期间不会被删除
+    int layer;            // 打包进纹理数组时为所在的层，id 是数组纹理；普通纹理为 -1
+
+    Texture() : id(0), layer(-1) {}
+};
+
+// 材质贴图的引用，CPU 阶段只记录路径，到GL线程上传时才真正加载
+struct TextureRef
+{
+    std::string type; // texture_diffuse / texture_specular ...
+    std::string path; // 相对于模型目录的路径
+};
+
+// Assimp 导入时每个材质的贴图，字符串和数组都放在这次导入的 arena 里，导入结束后一起释放
+struct ImportTexture
+{
+    const char *type;
+    const char *path;
+};
+
+struct ImportMaterial
+{
+    const ImportTexture *textures;
+    unsigned int count;
+};
+
+// 一级 LOD 在索引数组中的范围，所有 LOD 共用同一份顶点
+struct MeshLod
+{
+    unsigned int firstIndex;
+    unsigned int indexCount;
+    float error; // 相对原始网格的几何误差（模型空间距离）
+};
+
+// 纯CPU的mesh数据，不涉及任何GL调用，可以在任意线程构建
+struct MeshData
+{
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices; // 所有 LOD 的索引依次排列
+    std::vector<TextureRef> textures;
+    std::vector<MeshLod> lods;         // 为空表示只有一级，使用全部索引
+    unsigned int node;                 // 所在的场景节点，ModelData::nodes 的下标
+    // 从 .meshcache 读取时 vertices/indices 为空，顶点和索引直接指向映射的文件（只读），
+    // 映射由 ModelData::cache 持有到上传结束；读取时用下面的 VertexData()/IndexData() 兼顾两种来源
+    const Vertex *mappedVertices;
+    const unsigned int *mappedIndices;
+    unsigned int mappedVertexCount;
+    unsigned int mappedIndexCount;
+
+    MeshData() : node(0), mappedVertices(nullptr), mappedIndices(nullptr), mappedVertexCount(0), mappedIndexCount(0) {}
+
+    const Vertex *VertexData() const { return vertices.empty() ? mappedVertices : &vertices[0]; }
+    size_t VertexCount() const { return vertices.empty() ? mappedVertexCount : vertices.size(); }
+    const unsigned int *IndexData() const { return indices.empty() ? mappedIndices : &indices[0]; }
+    size_t IndexCount() const { return indices.empty() ? mappedIndexCount : indices.size(); }
+};
+
+// 选择 LOD 需要的相机信息
+struct LodView
+{
+    glm::vec3 cameraPosition;
+    float projectionScale; // 距离为 1 处每单位长度对应的像素数：视口高度 / (2 * tan(fovy / 2))
+    float maxPixelError;   // 允许的屏幕空间误差（像素）
+
+    static LodView Perspective(const glm::vec3 &cameraPosition, float fovyRadians, float viewportHeight, float maxPixelError = 1.0f);
+};
+
+// 直接指向已上传GPU缓冲的一个顶点属性，比如 GLB 里 accessor 引用的 bufferView
+struct VertexAttributeSource
+{
+    GLuint buffer;        // 0 表示没有这个属性
+    GLint components;
+    GLenum type;
+    GLboolean normalized;
+    GLsizei stride;       // 0 表示紧密排列
+    size_t offset;        // 在 buffer 里的字节偏移
+};
+
+// Model::LoadData 的选项
+enum ModelLoadFlags
+{
+    MODEL_LOAD_USE_CACHE = 1 << 0, // 读写 .meshcache 二进制缓存
+    MODEL_LOAD_OPTIMIZE  = 1 << 1, // 导入后做顶点去重、顶点缓存/overdraw/取数优化
+    MODEL_LOAD_LODS      = 1 << 2, // 用二次误差简化生成 LOD 链
+    MODEL_LOAD_NATIVE_OBJ = 1 << 3, // .obj 文件用 ObjLoader 多线程解析，失败时退回 Assimp
+    MODEL_LOAD_DEFAULT   = MODEL_LOAD_USE_CACHE | MODEL_LOAD_OPTIMIZE | MODEL_LOAD_LODS
+};
+
+// Model 上传到GPU时的选项
+enum ModelUploadFlags
+{
+    MODEL_UPLOAD_PACKED    = 1 << 0, // 所有mesh放进共享的 GeometryPool，整个模型只绑定一次VAO
+    MODEL_UPLOAD_QUANTIZED = 1 << 1, // 使用 16 字节的 PackedVertex，顶点数小于 65536 时使用 16 位索引
+    MODEL_UPLOAD_TEXTURE_ARRAYS = 1 << 2 // 同类型、同尺寸的材质贴图打包成 GL_TEXTURE_2D_ARRAY，mesh 只记录层号
+};
+
+// 模型层级里的一个节点（对应 aiNode），parent 总是小于自身的下标
+struct NodeData
+{
+    int parent;          // -1 表示根节点
+    glm::mat4 transform; // 相对父节点的变换
+    std::string name;
+};
+
+// 导入时除源文件之外读到的文件（比如 .obj 引用的 .mtl），大小和修改时间在读取之前取得，
+// 缓存据此判断它们是否改过；当时不存在的文件 exists 为 false，之后出现了同样让缓存失效
+struct ModelDependency
+{
+    std::string path; // 相对于模型目录的路径
+    bool exists;
+    uint64_t size;
+    int64_t mtime;
 };
 
+// 一个模型文件导入后的全部CPU数据
+struct ModelData
+{
+    std::string directory;
+    std::vector<MeshData> meshes;
+    std::vector<NodeData> nodes; // 为空表示只有一个单位变换的根节点
+    std::vector<ModelDependency> dependencies;
+    std::shared_ptr<const MeshCache> cache; // 从缓存读取时持有文件映射，meshes 的 mapped* 指向其中
+};
+
+// 绘制mesh用到的 uniform 句柄，每个着色器只按名字解析一次（Model 按着色器缓存），
+// 之后每帧每个mesh的设置不再拼接名字、查表
+struct MeshUniforms
+{
+    // 每种类型最多的普通纹理数：material.texture_diffuse1..4 / texture_specular1..4
+    static const unsigned int MAX_TEXTURES = 4;
+
+    ShaderUniform<glm::mat4> model;
+    ShaderUniform<glm::mat3> normalMatrix;
+    ShaderUniform<glm::vec3> positionScale;
+    ShaderUniform<glm::vec3> positionOffset;
+    ShaderUniform<bool> octahedralNormal;
+    ShaderUniform<int> diffuseArray;
+    ShaderUniform<int> specularArray;
+    ShaderUniform<float> diffuseLayer;
+    ShaderUniform<float> specularLayer;
+    ShaderUniform<int> diffuse[MAX_TEXTURES];
+    ShaderUniform<int> specular[MAX_TEXTURES];
+
+    MeshUniforms() {}
+    explicit MeshUniforms(Shader &shader);
+};
+
+// 只能移动不能拷贝：VAO/VBO/EBO 由 GLObject 持有
 class Mesh
 {
 public:
-    Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures);
-    void Draw(Shader &shader);
+    Mesh(MeshData &&data, std::vector<Texture> &&textures);
+    Mesh(Mesh &&other) noexcept;
+    Mesh &operator=(Mesh &&other) noexcept;
+    ~Mesh();
+
+    // 纹理数组固定绑定的纹理单元，避开普通纹理按序号使用的单元
+    static const unsigned int DIFFUSE_ARRAY_UNIT = 8;
+    static const unsigned int SPECULAR_ARRAY_UNIT = 9;
+
+    // 在当前绑定的VAO上设置 Vertex 的顶点属性指针
+    static void SetupAttributes();
+
+    // GL线程：创建缓冲并上传顶点/索引数据。
+    // pool 不为空时把数据追加到共享缓冲里，不再单独创建VAO；
+    // quantized 不为空时上传量化后的数据，pool 的顶点格式和索引类型要与之匹配
+    void Upload(GeometryPool *pool = nullptr, const QuantizedMesh *quantized = nullptr);
+    // GL线程：不经过 vertices/indices，属性 0/1/2（位置、法线、纹理坐标）直接指向已经上传的缓冲，
+    // 索引从 indexBuffer 的 indexOffset 字节处开始。缓冲由调用方持有，boundsMin/boundsMax 为模型空间包围盒
+    void UploadExternal(const VertexAttributeSource attributes[3], GLuint indexBuffer, GLenum indexType,
+                        size_t indexOffset, unsigned int indexCount, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax);
+    // 打包模式下调用方需要先绑定 Pool() 的VAO。uniforms 是从 shader 解析出的句柄
+    void Draw(Shader &shader, const MeshUniforms &uniforms, unsigned int lod = 0);
+
+    GeometryPool *Pool() const { return _pool; }
+    unsigned int LodCount() const;
+    // 根据投影到屏幕上的误差选择最粗的合格 LOD，modelMatrix 为绘制时使用的模型矩阵
+    unsigned int SelectLod(const glm::mat4 &modelMatrix, const LodView &view) const;
+    // 包围球投影到屏幕上的直径（像素），相机在包围球里面时返回 FLT_MAX
+    float ScreenSize(const glm::mat4 &modelMatrix, const LodView &view) const;
 
 public:
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
     std::vector<Texture> textures;
+    std::vector<MeshLod> lods;
+    unsigned int node; // 所在的场景节点，绘制时使用这个节点的世界矩阵
 
 private:
-    void setupMesh();
-    
+    void bindTextures(Shader &shader, const MeshUniforms &uniforms);
+    // 计算包围球中心所在距离上每单位长度对应的像素数，相机在包围球里面时返回 false
+    bool project(const glm::mat4 &modelMatrix, const LodView &view, float &pixelsPerUnit) const;
+
 private:
-    unsigned int _VAO;
-    unsigned int _VBO;
-    unsigned int _EBO;
+    GLVertexArray _VAO;
+    GLBuffer _VBO;
+    GLBuffer _EBO;
+    GeometryPool *_pool;
+    GeometryRange _range;
+    GLenum _indexType;
+    unsigned int _indexCount; // 外部缓冲的mesh没有 indices，绘制时用这里的数量和偏移
+    size_t _indexOffset;
+    // 量化顶点的反量化参数：position = offset + scale * q，非量化时为单位变换
+    glm::vec3 _positionScale;
+    glm::vec3 _positionOffset;
+    bool _quantized;
+    // 模型空间的包围球，用来估计到相机的距离
+    glm::vec3 _boundsCenter;
+    float _boundsRadius;
+    // vertices/indices 为空时 Upload 从这里读取 .meshcache 的映射，只在 Model::upload 期间有效，上传后清空
+    const Vertex *_mappedVertices;
+    const unsigned int *_mappedIndices;
+    size_t _mappedVertexCount;
 };
 
 class Model
 {
 public:
-    Model(const std::string &path);
+    // uploadFlags 为 ModelUploadFlags 的组合，loadFlags 为 ModelLoadFlags 的组合。
+    // .glb 文件由 GltfLoader 解析后直接上传 bufferView，只有 MODEL_UPLOAD_TEXTURE_ARRAYS 起作用
+    Model(const std::string &path, unsigned int uploadFlags = 0, unsigned int loadFlags = MODEL_LOAD_DEFAULT);
+    // GL线程：用已经构建好的CPU数据创建模型
+    explicit Model(ModelData &&data, unsigned int uploadFlags = 0);
+
+    // 所有打包模式的模型共用的顶点/索引缓冲
+    static GeometryPool &SharedPool();
+    // 量化顶点 + 16 位索引的共享缓冲
+    static GeometryPool &SharedQuantizedPool();
+    // GL线程：释放两个共享缓冲的GL对象，在 glfwTerminate 之前、所有 Model 析构之后调用
+    static void ReleaseSharedPools();
 
+    // 纯CPU阶段（缓存读取、原生 OBJ 解析或Assimp导入），可以放到后台线程执行
+    static bool LoadData(const std::string &path, ModelData &data, unsigned int flags = MODEL_LOAD_DEFAULT);
+
+    // 全部使用最高精度的 LOD0，shader 的 model 设置为各mesh所在节点的世界矩阵
     void Draw(Shader &shader);
+    // 每个mesh按投影误差选择 LOD，shader 的 model 设置为 modelMatrix * 节点的世界矩阵
+    void Draw(Shader &shader, const glm::mat4 &modelMatrix, const LodView &view);
+
+    // 导入时保留的节点层级，修改节点的局部矩阵后下一次 Draw 只重新计算变化的子树
+    SceneGraph &Scene() { return _scene; }
+    const SceneGraph &Scene() const { return _scene; }
+
+    // 重新导入模型文件并替换所有mesh，导入失败时保留原来的mesh。只对从文件构造的模型有效
+    bool Reload();
+    // path 是否是这个模型的源文件，或者导入时读到的 .mtl 等附属文件、引用的贴图
+    bool Uses(const std::string &path) const;
 private:
-    void loadModel(const std::string &path);
-    void processNode(aiNode *node, const aiScene *scene);
-    Mesh processMesh(aiMesh *mesh, const aiScene *scene);
-    std::vector<Texture> loadMaterialTextures(aiMaterial *mat, aiTextureType type, std::string typeName);
-    unsigned int TextureFromFile(const char* path, const std::string &directory);
-    
+    void draw(Shader &shader, const glm::mat4 *modelMatrix, const LodView *view);
+    // 第一次用某个着色器绘制时解析句柄，之后直接返回缓存的；着色器需要比模型先创建、后销毁之前不再用它绘制
+    const MeshUniforms &uniformsFor(Shader &shader);
+    void upload(ModelData &&data, unsigned int uploadFlags);
+    // 用导入的节点重建场景层级，没有节点时只有一个根节点
+    void buildScene(const std::vector<NodeData> &nodes);
+    // 记下这次导入读到的附属文件和引用的贴图，热重载时 Uses 据此判断
+    void recordDependencies(const ModelData &data);
+    std::vector<std::vector<Texture> > loadTextures(const ModelData &data);
+    std::vector<std::vector<Texture> > loadTextureArrays(const ModelData &data);
+    static bool loadFromCache(const std::string &path, ModelData &data, unsigned int buildFlags);
+    static bool loadWithAssimp(const std::string &path, ModelData &data);
+    // .glb 不经过 ModelData：bufferView 直接从映射的文件上传，失败时保留原来的mesh
+    bool loadGlb(const std::string &path, unsigned int uploadFlags);
+    static void optimizeMeshes(ModelData &data);
+    static void generateLods(ModelData &data);
+    // 每个材质只查询一次贴图，多个mesh共用同一个材质时直接复制引用
+    static const ImportMaterial *loadMaterials(const aiScene *scene, MonotonicArena &arena);
+    static void processNode(aiNode *node, const aiScene *scene, const ImportMaterial *materials, ModelData &data, int parent);
+    static MeshData processMesh(aiMesh *mesh, const aiScene *scene, const ImportMaterial *materials);
+    // 把这种类型的贴图写进 textures（空间由调用方按 GetTextureCount 分配），返回写入的数量
+    static unsigned int loadMaterialTextures(aiMaterial *mat, aiTextureType type, const char *typeName, MonotonicArena &arena,
+                                             ImportTexture *textures);
+    TextureHandle TextureFromFile(const char* path, const std::string &directory, bool srgb);
+
 private:
     std::vector<Mesh> meshes;
     std::string directory;
+    std::string _path;
+    unsigned int _uploadFlags;
+    unsigned int _loadFlags;
+    std::vector<GLBuffer> _buffers; // GLB 的 bufferView，mesh 的VAO直接引用
+    std::vector<std::string> _dependencies; // 源文件之外的 .mtl 和贴图，完整路径
+    SceneGraph _scene;
+    std::vector<std::pair<const Shader *, MeshUniforms> > _uniforms; // 按着色器缓存的句柄，通常只有一两个
 
 };
 
 #endif
-
-
-
@@ -0,0 +1,89 @@
+#include "monotonicArena.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+MonotonicArena::MonotonicArena(size_t initialCapacity) :
+    _head(nullptr), _cursor(nullptr), _end(nullptr), _nextBlockSize(std::max<size_t>(initialCapacity, 256)),
+    _allocations(0), _bytesUsed(0), _capacity(0), _blocks(0)
+{
+}
+
+MonotonicArena::~MonotonicArena()
+{
+    while (_head)
+    {
+        Block *next = _head->next;
+        free(_head);
+        _head = next;
+    }
+}
+
+void MonotonicArena::grow(size_t bytes, size_t alignment)
+{
+    // 块头之后留出对齐的余量，保证这次请求一定放得下
+    size_t size = std::max(_nextBlockSize, sizeof(Block) + bytes + alignment);
+    Block *block = static_cast<Block *>(malloc(size));
+    if (!block)
+        throw std::bad_alloc();
+    block->next = _head;
+    block->size = size;
+    _head = block;
+    _cursor = reinterpret_cast<char *>(block + 1);
+    _end = reinterpret_cast<char *>(block) + size;
+    _capacity += size;
+    _blocks++;
+    _nextBlockSize = size * 2;
+}
+
+void *MonotonicArena::Allocate(size_t bytes, size_t alignment)
+{
+    uintptr_t address = reinterpret_cast<uintptr_t>(_cursor);
+    uintptr_t aligned = (address + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    if (!_cursor || aligned + bytes > reinterpret_cast<uintptr_t>(_end))
+    {
+        grow(bytes, alignment);
+        address = reinterpret_cast<uintptr_t>(_cursor);
+        aligned = (address + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    }
+    _cursor = reinterpret_cast<char *>(aligned + bytes);
+    _allocations++;
+    _bytesUsed += bytes;
+    return reinterpret_cast<void *>(aligned);
+}
+
+const char *MonotonicArena::CopyString(const char *text, size_t length)
+{
+    char *copy = static_cast<char *>(Allocate(length + 1, 1));
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+size_t PeakResidentBytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.PeakWorkingSetSize;
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#ifdef __APPLE__
+    return (size_t)usage.ru_maxrss;        // macOS 的单位是字节
+#else
+    return (size_t)usage.ru_maxrss * 1024; // Linux 的单位是 KB
+#endif
+#endif
+}
@@ -0,0 +1,57 @@
+#ifndef MONOTONIC_ARENA_H
+#define MONOTONIC_ARENA_H
+
+#include <cstddef>
+#include <new>
+
+// 只增不减的内存区：分配就是移动指针，单个释放是空操作，析构时整块归还。
+// 用于一次导入之类生命周期明确的临时数据，预先按估计的大小申请一块，
+// 用完再按上一块的两倍追加（相当于 std::pmr::monotonic_buffer_resource）
+class MonotonicArena
+{
+public:
+    explicit MonotonicArena(size_t initialCapacity = 64 * 1024);
+    ~MonotonicArena();
+
+    void *Allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+    template <class T>
+    T *AllocateArray(size_t count)
+    {
+        return static_cast<T *>(Allocate(count * sizeof(T), alignof(T)));
+    }
+    // 拷贝一份以 '\0' 结尾的字符串
+    const char *CopyString(const char *text, size_t length);
+
+    size_t Allocations() const { return _allocations; }
+    size_t BytesUsed() const { return _bytesUsed; }
+    size_t Capacity() const { return _capacity; }
+    // 向系统申请的次数，预估准确时只有 1 次
+    size_t Blocks() const { return _blocks; }
+
+private:
+    MonotonicArena(const MonotonicArena &);
+    MonotonicArena &operator=(const MonotonicArena &);
+
+    struct Block
+    {
+        Block *next;
+        size_t size;
+    };
+
+    void grow(size_t bytes, size_t alignment);
+
+private:
+    Block *_head;
+    char *_cursor;
+    char *_end;
+    size_t _nextBlockSize;
+    size_t _allocations;
+    size_t _bytesUsed;
+    size_t _capacity;
+    size_t _blocks;
+};
+
+// 进程到目前为止的峰值常驻内存（字节），取不到时返回 0
+size_t PeakResidentBytes();
+
+#endif
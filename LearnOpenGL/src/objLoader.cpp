@@ -0,0 +1,704 @@
+#include "objLoader.h"
+#include "assetPack.h"
+#include "meshCache.h"
+#include "threadPool.h"
+#include "traceRecorder.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+    // 每块至少 256KB，块太小时任务调度的开销会超过解析本身
+    const size_t MIN_CHUNK_BYTES = 256 * 1024;
+    // 每个线程分几块，行的长短不均匀时负载更平衡
+    const size_t CHUNKS_PER_THREAD = 4;
+
+    const double POWERS_OF_TEN[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    // 源文件：资源包里有就直接使用包里映射的内存，否则映射松散文件
+    struct SourceFile
+    {
+        MappedFile file;
+        const char *begin;
+        const char *end;
+
+        SourceFile() : begin(nullptr), end(nullptr) {}
+
+        bool Open(const std::string &path)
+        {
+            AssetSpan span;
+            if (AssetPack::Instance().Find(path, span))
+            {
+                begin = span.Chars();
+                end = begin + span.size;
+                return true;
+            }
+            if (!file.Open(path, true))
+                return false;
+            begin = file.Chars();
+            end = begin + file.Size();
+            return true;
+        }
+    };
+
+    enum CornerFlags
+    {
+        CORNER_TEXCOORD = 1 << 0,
+        CORNER_NORMAL = 1 << 1,
+        // 负数索引：值是相对本块开头的下标（可能小于 0），合并时加上之前各块的数量
+        CORNER_RELATIVE_POSITION = 1 << 2,
+        CORNER_RELATIVE_TEXCOORD = 1 << 3,
+        CORNER_RELATIVE_NORMAL = 1 << 4
+    };
+
+    // 面的一个角。解析时是本块内的下标，合并之后换算成全局下标，没有的属性为 -1
+    struct Corner
+    {
+        int position;
+        int texCoord;
+        int normal;
+        int flags;
+    };
+
+    // 切换对象或材质的语句，firstCorner 之后的面属于新的分组
+    struct GroupEvent
+    {
+        size_t firstCorner;
+        bool object; // o/g 为 true，usemtl 为 false
+        std::string name;
+    };
+
+    struct ObjChunk
+    {
+        const char *begin;
+        const char *end;
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec2> texCoords;
+        std::vector<glm::vec3> normals;
+        std::vector<Corner> corners; // 三角化之后每 3 个一组
+        std::vector<GroupEvent> groups;
+        std::vector<std::string> materialLibraries;
+        size_t positionBase; // 之前各块的属性数量
+        size_t texCoordBase;
+        size_t normalBase;
+        std::string error;   // 第一个无法解析的行
+    };
+
+    // 一个 mesh 在某一块里连续的一段面
+    struct ObjSegment
+    {
+        size_t chunk;
+        size_t begin;
+        size_t end;
+    };
+
+    struct ObjMesh
+    {
+        std::string material;
+        std::vector<ObjSegment> segments;
+    };
+
+    // 合并之后的全局属性数组
+    struct ObjAttributes
+    {
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec2> texCoords;
+        std::vector<glm::vec3> normals;
+    };
+
+    inline bool isSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    inline bool isDigit(char c)
+    {
+        return (unsigned char)(c - '0') <= 9;
+    }
+
+    inline const char *skipSpaces(const char *p, const char *end)
+    {
+        while (p < end && isSpace(*p))
+            p++;
+        return p;
+    }
+
+    // 行尾的 '\n'，最后一行没有换行时返回 end
+    inline const char *lineEnd(const char *p, const char *end)
+    {
+        const char *newline = static_cast<const char *>(memchr(p, '\n', end - p));
+        return newline ? newline : end;
+    }
+
+    // p 处是 name 这个关键字（后面是空白或行尾）时返回关键字之后的位置，否则返回 nullptr
+    inline const char *keyword(const char *p, const char *line, const char *name)
+    {
+        size_t length = strlen(name);
+        if ((size_t)(line - p) < length || memcmp(p, name, length) != 0)
+            return nullptr;
+        p += length;
+        return p == line || isSpace(*p) ? p : nullptr;
+    }
+
+    // 去掉首尾空白的剩余部分，用于对象名、材质名和文件名
+    std::string restOfLine(const char *p, const char *line)
+    {
+        p = skipSpaces(p, line);
+        while (line > p && isSpace(line[-1]))
+            line--;
+        return std::string(p, line);
+    }
+
+    // 行里最后一个词，贴图语句前面可能带 -bm 之类的选项
+    std::string lastToken(const char *p, const char *line)
+    {
+        std::string rest = restOfLine(p, line);
+        size_t space = rest.find_last_of(" \t");
+        return space == std::string::npos ? rest : rest.substr(space + 1);
+    }
+
+    inline float readFloat(const char *&p, const char *line)
+    {
+        p = skipSpaces(p, line);
+        return p < line ? ObjLoader::ParseFloat(p, line) : 0.0f;
+    }
+
+    inline bool parseInt(const char *&p, const char *end, int &value)
+    {
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+'))
+        {
+            negative = *p == '-';
+            p++;
+        }
+        if (p >= end || !isDigit(*p))
+            return false;
+        int result = 0;
+        while (p < end && isDigit(*p))
+        {
+            result = result * 10 + (*p - '0');
+            p++;
+        }
+        value = negative ? -result : result;
+        return true;
+    }
+
+    // 文件里的索引（从 1 开始，负数相对当前已经定义的数量）-> 本块内的下标
+    inline bool parseIndex(const char *&p, const char *end, size_t count, int relativeFlag, int &index, int &flags)
+    {
+        int value;
+        if (!parseInt(p, end, value) || value == 0)
+            return false;
+        if (value > 0)
+        {
+            index = value - 1;
+            return true;
+        }
+        index = (int)count + value;
+        flags |= relativeFlag;
+        return true;
+    }
+
+    // v、v/vt、v//vn、v/vt/vn 四种写法
+    bool parseCorner(const char *&p, const char *line, const ObjChunk &chunk, Corner &corner)
+    {
+        corner.texCoord = -1;
+        corner.normal = -1;
+        corner.flags = 0;
+        if (!parseIndex(p, line, chunk.positions.size(), CORNER_RELATIVE_POSITION, corner.position, corner.flags))
+            return false;
+        if (p < line && *p == '/')
+        {
+            p++;
+            if (p < line && *p != '/' && !isSpace(*p))
+            {
+                if (!parseIndex(p, line, chunk.texCoords.size(), CORNER_RELATIVE_TEXCOORD, corner.texCoord, corner.flags))
+                    return false;
+                corner.flags |= CORNER_TEXCOORD;
+            }
+            if (p < line && *p == '/')
+            {
+                p++;
+                if (!parseIndex(p, line, chunk.normals.size(), CORNER_RELATIVE_NORMAL, corner.normal, corner.flags))
+                    return false;
+                corner.flags |= CORNER_NORMAL;
+            }
+        }
+        return p == line || isSpace(*p);
+    }
+
+    void parseChunk(ObjChunk &chunk)
+    {
+        std::vector<Corner> polygon;
+        const char *p = chunk.begin;
+        while (p < chunk.end)
+        {
+            const char *line = lineEnd(p, chunk.end);
+            const char *start = skipSpaces(p, line);
+            const char *q;
+            if (start == line || *start == '#')
+            {
+                // 空行和注释
+            }
+            else if ((q = keyword(start, line, "v")))
+            {
+                glm::vec3 position;
+                position.x = readFloat(q, line);
+                position.y = readFloat(q, line);
+                position.z = readFloat(q, line);
+                chunk.positions.push_back(position);
+            }
+            else if ((q = keyword(start, line, "vt")))
+            {
+                glm::vec2 texCoord;
+                texCoord.x = readFloat(q, line);
+                texCoord.y = 1.0f - readFloat(q, line); // 与 aiProcess_FlipUVs 一致
+                chunk.texCoords.push_back(texCoord);
+            }
+            else if ((q = keyword(start, line, "vn")))
+            {
+                glm::vec3 normal;
+                normal.x = readFloat(q, line);
+                normal.y = readFloat(q, line);
+                normal.z = readFloat(q, line);
+                chunk.normals.push_back(normal);
+            }
+            else if ((q = keyword(start, line, "f")))
+            {
+                polygon.clear();
+                bool valid = true;
+                for (q = skipSpaces(q, line); q < line && valid; q = skipSpaces(q, line))
+                {
+                    Corner corner;
+                    valid = parseCorner(q, line, chunk, corner);
+                    polygon.push_back(corner);
+                }
+                if (!valid || polygon.size() < 3)
+                {
+                    if (chunk.error.empty())
+                        chunk.error = std::string(start, line);
+                }
+                else
+                {
+                    // 扇形三角化，与 aiProcess_Triangulate 对凸多边形的结果相同
+                    for (size_t i = 2; i < polygon.size(); i++)
+                    {
+                        chunk.corners.push_back(polygon[0]);
+                        chunk.corners.push_back(polygon[i - 1]);
+                        chunk.corners.push_back(polygon[i]);
+                    }
+                }
+            }
+            else if ((q = keyword(start, line, "o")) || (q = keyword(start, line, "g")))
+            {
+                GroupEvent event = { chunk.corners.size(), true, restOfLine(q, line) };
+                chunk.groups.push_back(event);
+            }
+            else if ((q = keyword(start, line, "usemtl")))
+            {
+                GroupEvent event = { chunk.corners.size(), false, restOfLine(q, line) };
+                chunk.groups.push_back(event);
+            }
+            else if ((q = keyword(start, line, "mtllib")))
+            {
+                chunk.materialLibraries.push_back(restOfLine(q, line));
+            }
+            // s、l、p 等其它语句忽略
+            p = line + 1;
+        }
+    }
+
+    // 把本块的下标换算成全局下标，返回 false 表示有越界的索引
+    bool resolveChunk(ObjChunk &chunk, const ObjAttributes &attributes)
+    {
+        int positionCount = (int)attributes.positions.size();
+        int texCoordCount = (int)attributes.texCoords.size();
+        int normalCount = (int)attributes.normals.size();
+        for (size_t i = 0; i < chunk.corners.size(); i++)
+        {
+            Corner &corner = chunk.corners[i];
+            if (corner.flags & CORNER_RELATIVE_POSITION)
+                corner.position += (int)chunk.positionBase;
+            if (corner.flags & CORNER_RELATIVE_TEXCOORD)
+                corner.texCoord += (int)chunk.texCoordBase;
+            if (corner.flags & CORNER_RELATIVE_NORMAL)
+                corner.normal += (int)chunk.normalBase;
+            if (corner.position < 0 || corner.position >= positionCount
+                || ((corner.flags & CORNER_TEXCOORD) && (corner.texCoord < 0 || corner.texCoord >= texCoordCount))
+                || ((corner.flags & CORNER_NORMAL) && (corner.normal < 0 || corner.normal >= normalCount)))
+                return false;
+        }
+        return true;
+    }
+
+    inline uint32_t hashCorner(int position, int texCoord, int normal)
+    {
+        uint32_t hash = (uint32_t)position * 0x9E3779B1u;
+        hash ^= (uint32_t)texCoord * 0x85EBCA77u;
+        hash ^= (uint32_t)normal * 0xC2B2AE3Du;
+        return hash ^ (hash >> 15);
+    }
+
+    // 一段面直接生成 Vertex/索引：用开放寻址表合并相同的 v/vt/vn 组合。
+    // 没有法线的角使用面法线，按所在三角形区分，不会和其它面合并
+    void buildSegment(const Corner *corners, size_t count, const ObjAttributes &attributes, MeshData &mesh)
+    {
+        std::vector<Corner> keys;
+        mesh.vertices.reserve(count / 3);
+        mesh.indices.resize(count);
+        size_t capacity = 64;
+        while (capacity < count / 2)
+            capacity *= 2;
+        std::vector<unsigned int> table(capacity, UINT_MAX);
+
+        for (size_t i = 0; i < count; i += 3)
+        {
+            const Corner *triangle = corners + i;
+            glm::vec3 faceNormal(0.0f);
+            if (!(triangle[0].flags & triangle[1].flags & triangle[2].flags & CORNER_NORMAL))
+            {
+                const glm::vec3 &p0 = attributes.positions[triangle[0].position];
+                glm::vec3 normal = glm::cross(attributes.positions[triangle[1].position] - p0, attributes.positions[triangle[2].position] - p0);
+                float length = glm::length(normal);
+                faceNormal = length > 0.0f ? normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+            }
+            for (int j = 0; j < 3; j++)
+            {
+                Corner key = triangle[j];
+                if (key.normal < 0)
+                    key.normal = -2 - (int)(i / 3);
+
+                uint32_t mask = (uint32_t)(capacity - 1);
+                uint32_t slot = hashCorner(key.position, key.texCoord, key.normal) & mask;
+                while (table[slot] != UINT_MAX)
+                {
+                    const Corner &other = keys[table[slot]];
+                    if (other.position == key.position && other.texCoord == key.texCoord && other.normal == key.normal)
+                        break;
+                    slot = (slot + 1) & mask;
+                }
+                if (table[slot] == UINT_MAX)
+                {
+                    table[slot] = (unsigned int)mesh.vertices.size();
+                    keys.push_back(key);
+                    Vertex vertex;
+                    vertex.Position = attributes.positions[key.position];
+                    vertex.Normal = key.normal >= 0 ? attributes.normals[key.normal] : faceNormal;
+                    vertex.TexCoords = key.texCoord >= 0 ? attributes.texCoords[key.texCoord] : glm::vec2(0.0f);
+                    mesh.vertices.push_back(vertex);
+                }
+                mesh.indices[i + j] = table[slot];
+
+                // 负载超过一半时扩容重新插入
+                if (keys.size() * 2 > capacity)
+                {
+                    capacity *= 2;
+                    mask = (uint32_t)(capacity - 1);
+                    table.assign(capacity, UINT_MAX);
+                    for (size_t k = 0; k < keys.size(); k++)
+                    {
+                        uint32_t s = hashCorner(keys[k].position, keys[k].texCoord, keys[k].normal) & mask;
+                        while (table[s] != UINT_MAX)
+                            s = (s + 1) & mask;
+                        table[s] = (unsigned int)k;
+                    }
+                }
+            }
+        }
+    }
+
+    // 在线程池里执行 job(0) ... job(count - 1) 并等待全部完成
+    template <class F>
+    void parallelFor(ThreadPool &pool, size_t count, F job)
+    {
+        std::vector<std::future<void> > results;
+        results.reserve(count);
+        for (size_t i = 0; i < count; i++)
+            results.push_back(pool.Submit([&job, i]() { job(i); }));
+        for (size_t i = 0; i < results.size(); i++)
+            results[i].get();
+    }
+}
+
+float ObjLoader::ParseFloat(const char *&cursor, const char *end)
+{
+    const char *p = cursor;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        p++;
+    }
+
+    // 最多取 19 位有效数字放进 64 位整数，再乘/除一次 10 的幂
+    uint64_t mantissa = 0;
+    int digits = 0, exponent = 0;
+    bool any = false;
+    for (; p < end && isDigit(*p); p++, any = true)
+    {
+        if (digits < 19)
+        {
+            mantissa = mantissa * 10 + (*p - '0');
+            digits += mantissa != 0 ? 1 : 0;
+        }
+        else
+            exponent++;
+    }
+    if (p < end && *p == '.')
+    {
+        for (p++; p < end && isDigit(*p); p++, any = true)
+        {
+            if (digits < 19)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                digits += mantissa != 0 ? 1 : 0;
+                exponent--;
+            }
+        }
+    }
+    if (!any)
+    {
+        // nan、inf 之类的写法不支持，跳过这个词
+        while (p < end && !isSpace(*p) && *p != '\n')
+            p++;
+        cursor = p;
+        return 0.0f;
+    }
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        const char *q = p + 1;
+        int value;
+        if (parseInt(q, end, value))
+        {
+            exponent += value;
+            p = q;
+        }
+    }
+    cursor = p;
+
+    double value = (double)mantissa;
+    if (exponent < 0)
+        value = -exponent <= 22 ? value / POWERS_OF_TEN[-exponent] : value * std::pow(10.0, exponent);
+    else if (exponent > 0)
+        value = exponent <= 22 ? value * POWERS_OF_TEN[exponent] : value * std::pow(10.0, exponent);
+    return (float)(negative ? -value : value);
+}
+
+bool ObjLoader::IsObj(const std::string &path)
+{
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos)
+        return false;
+    std::string extension = path.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension == "obj";
+}
+
+bool ObjLoader::LoadMaterials(const std::string &path, std::map<std::string, std::vector<TextureRef> > &materials)
+{
+    SourceFile source;
+    if (!source.Open(path))
+    {
+        std::cout << "ERROR::OBJ_LOADER::CANNOT_OPEN_MTL " << path << std::endl;
+        return false;
+    }
+
+    // 与 processMesh 的顺序一致：diffuse 贴图在前，specular 在后
+    std::map<std::string, std::vector<TextureRef> > diffuse, specular;
+    std::string current;
+    for (const char *p = source.begin; p < source.end;)
+    {
+        const char *line = lineEnd(p, source.end);
+        const char *start = skipSpaces(p, line);
+        const char *q;
+        if ((q = keyword(start, line, "newmtl")))
+        {
+            current = restOfLine(q, line);
+            diffuse[current];
+        }
+        else if ((q = keyword(start, line, "map_Kd")) || (q = keyword(start, line, "map_Ks")))
+        {
+            TextureRef texture;
+            texture.type = start[5] == 'd' ? "texture_diffuse" : "texture_specular";
+            texture.path = lastToken(q, line);
+            (start[5] == 'd' ? diffuse : specular)[current].push_back(texture);
+        }
+        p = line + 1;
+    }
+
+    for (std::map<std::string, std::vector<TextureRef> >::iterator it = diffuse.begin(); it != diffuse.end(); ++it)
+    {
+        std::vector<TextureRef> &textures = materials[it->first];
+        textures = it->second;
+        const std::vector<TextureRef> &maps = specular[it->first];
+        textures.insert(textures.end(), maps.begin(), maps.end());
+    }
+    return true;
+}
+
+bool ObjLoader::Load(const std::string &path, ModelData &data, unsigned int threadCount)
+{
+    TRACE_ZONE_DETAIL("ObjLoader::Load", path);
+    SourceFile source;
+    if (!source.Open(path))
+    {
+        std::cout << "ERROR::OBJ_LOADER::CANNOT_OPEN " << path << std::endl;
+        return false;
+    }
+    data.directory = path.substr(0, path.find_last_of('/'));
+    data.meshes.clear();
+    data.dependencies.clear();
+
+    // 1. 按行边界切块，并行解析
+    ThreadPool pool(threadCount);
+    size_t size = source.end - source.begin;
+    size_t chunkCount = std::max<size_t>(1, std::min<size_t>(pool.Size() * CHUNKS_PER_THREAD, size / MIN_CHUNK_BYTES));
+    std::vector<ObjChunk> chunks(chunkCount);
+    const char *cursor = source.begin;
+    for (size_t i = 0; i < chunkCount; i++)
+    {
+        chunks[i].begin = cursor;
+        if (i + 1 == chunkCount)
+            cursor = source.end;
+        else
+        {
+            const char *target = std::max(cursor, source.begin + size * (i + 1) / chunkCount);
+            cursor = std::min(source.end, lineEnd(target, source.end) + 1);
+        }
+        chunks[i].end = cursor;
+    }
+    parallelFor(pool, chunkCount, [&chunks](size_t i) {
+        TRACE_ZONE("ObjLoader::parseChunk");
+        parseChunk(chunks[i]);
+    });
+
+    // 2. 合并属性数组，负数索引换算成全局下标
+    ObjAttributes attributes;
+    size_t positionCount = 0, texCoordCount = 0, normalCount = 0;
+    for (size_t i = 0; i < chunkCount; i++)
+    {
+        ObjChunk &chunk = chunks[i];
+        if (!chunk.error.empty())
+        {
+            std::cout << "ERROR::OBJ_LOADER::INVALID_FACE \"" << chunk.error << "\" in " << path << std::endl;
+            return false;
+        }
+        chunk.positionBase = positionCount;
+        chunk.texCoordBase = texCoordCount;
+        chunk.normalBase = normalCount;
+        positionCount += chunk.positions.size();
+        texCoordCount += chunk.texCoords.size();
+        normalCount += chunk.normals.size();
+    }
+    if (positionCount >= (size_t)INT_MAX || texCoordCount >= (size_t)INT_MAX || normalCount >= (size_t)INT_MAX)
+    {
+        std::cout << "ERROR::OBJ_LOADER::TOO_LARGE " << path << std::endl;
+        return false;
+    }
+    attributes.positions.resize(positionCount);
+    attributes.texCoords.resize(texCoordCount);
+    attributes.normals.resize(normalCount);
+    std::vector<char> resolved(chunkCount, 0);
+    parallelFor(pool, chunkCount, [&](size_t i) {
+        ObjChunk &chunk = chunks[i];
+        std::copy(chunk.positions.begin(), chunk.positions.end(), attributes.positions.begin() + chunk.positionBase);
+        std::copy(chunk.texCoords.begin(), chunk.texCoords.end(), attributes.texCoords.begin() + chunk.texCoordBase);
+        std::copy(chunk.normals.begin(), chunk.normals.end(), attributes.normals.begin() + chunk.normalBase);
+        std::vector<glm::vec3>().swap(chunk.positions);
+        std::vector<glm::vec2>().swap(chunk.texCoords);
+        std::vector<glm::vec3>().swap(chunk.normals);
+    });
+    parallelFor(pool, chunkCount, [&](size_t i) { resolved[i] = resolveChunk(chunks[i], attributes) ? 1 : 0; });
+    if (std::find(resolved.begin(), resolved.end(), 0) != resolved.end())
+    {
+        std::cout << "ERROR::OBJ_LOADER::INDEX_OUT_OF_RANGE " << path << std::endl;
+        return false;
+    }
+
+    // 3. 按 o/g/usemtl 把各块的面分到 (对象, 材质) 对应的 mesh，按第一次出现的顺序排列
+    std::vector<ObjMesh> meshes;
+    std::map<std::string, size_t> meshIndex;
+    std::map<std::string, std::vector<TextureRef> > materials;
+    std::string object, material;
+    for (size_t i = 0; i < chunkCount; i++)
+    {
+        const ObjChunk &chunk = chunks[i];
+        for (size_t j = 0; j < chunk.materialLibraries.size(); j++)
+        {
+            // 读之前记下 .mtl 的来源，缓存据此判断材质是否改过
+            MeshCache::RecordDependency(data, chunk.materialLibraries[j]);
+            LoadMaterials(data.directory + "/" + chunk.materialLibraries[j], materials);
+        }
+
+        size_t begin = 0;
+        for (size_t j = 0; j <= chunk.groups.size(); j++)
+        {
+            size_t end = j < chunk.groups.size() ? chunk.groups[j].firstCorner : chunk.corners.size();
+            if (end > begin)
+            {
+                std::string key = object + '\n' + material;
+                std::map<std::string, size_t>::iterator found = meshIndex.find(key);
+                if (found == meshIndex.end())
+                {
+                    found = meshIndex.insert(std::make_pair(key, meshes.size())).first;
+                    meshes.push_back(ObjMesh());
+                    meshes.back().material = material;
+                }
+                ObjSegment segment = { i, begin, end };
+                meshes[found->second].segments.push_back(segment);
+            }
+            if (j < chunk.groups.size())
+                (chunk.groups[j].object ? object : material) = chunk.groups[j].name;
+            begin = end;
+        }
+    }
+
+    // 4. 每一段并行生成顶点和索引，再按 mesh 拼接
+    std::vector<std::pair<size_t, size_t> > tasks; // (mesh, segment)
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        for (size_t j = 0; j < meshes[i].segments.size(); j++)
+            tasks.push_back(std::make_pair(i, j));
+    }
+    std::vector<MeshData> parts(tasks.size());
+    parallelFor(pool, tasks.size(), [&](size_t i) {
+        const ObjSegment &segment = meshes[tasks[i].first].segments[tasks[i].second];
+        const ObjChunk &chunk = chunks[segment.chunk];
+        TRACE_ZONE("ObjLoader::buildSegment");
+        buildSegment(&chunk.corners[segment.begin], segment.end - segment.begin, attributes, parts[i]);
+    });
+
+    data.meshes.resize(meshes.size());
+    for (size_t i = 0; i < tasks.size(); i++)
+    {
+        MeshData &mesh = data.meshes[tasks[i].first];
+        MeshData &part = parts[i];
+        if (mesh.vertices.empty())
+        {
+            mesh.vertices.swap(part.vertices);
+            mesh.indices.swap(part.indices);
+            continue;
+        }
+        unsigned int offset = (unsigned int)mesh.vertices.size();
+        mesh.vertices.insert(mesh.vertices.end(), part.vertices.begin(), part.vertices.end());
+        size_t first = mesh.indices.size();
+        mesh.indices.insert(mesh.indices.end(), part.indices.begin(), part.indices.end());
+        for (size_t j = first; j < mesh.indices.size(); j++)
+            mesh.indices[j] += offset;
+        std::vector<Vertex>().swap(part.vertices);
+    }
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        std::map<std::string, std::vector<TextureRef> >::const_iterator found = materials.find(meshes[i].material);
+        if (found != materials.end())
+            data.meshes[i].textures = found->second;
+    }
+    return true;
+}
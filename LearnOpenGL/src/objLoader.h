@@ -0,0 +1,29 @@
+#ifndef OBJ_LOADER_H
+#define OBJ_LOADER_H
+
+#include "model.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+// 原生 OBJ/MTL 导入，作为 Assimp 之外的另一个后端（Model::LoadData 加 MODEL_LOAD_NATIVE_OBJ 选择）。
+// 文件整体映射（优先从资源包读取），按行边界切成若干块在线程池里并行解析，结果直接写进 Vertex/索引数组。
+// 输出与 aiProcess_Triangulate | aiProcess_FlipUVs 的 Assimp 导入对应：每个 (对象, 材质) 一个 mesh，
+// 多边形按扇形三角化，纹理坐标 v 翻转；不同的是每个解析块内相同的 v/vt/vn 组合已经合并成一个顶点
+class ObjLoader
+{
+public:
+    // threadCount 为 0 时使用硬件线程数。解析失败（比如索引越界）时返回 false，调用方可以退回 Assimp
+    static bool Load(const std::string &path, ModelData &data, unsigned int threadCount = 0);
+
+    // 材质名 -> 贴图，map_Kd 为 texture_diffuse，map_Ks 为 texture_specular，路径相对于模型目录
+    static bool LoadMaterials(const std::string &path, std::map<std::string, std::vector<TextureRef> > &materials);
+
+    static bool IsObj(const std::string &path);
+
+    // 不依赖 locale 的浮点数解析，cursor 移到数字之后；不是数字时跳过这个词并返回 0
+    static float ParseFloat(const char *&cursor, const char *end);
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef POINT_LIGHT_H
+#define POINT_LIGHT_H
+
+#include "glm/glm.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// 一个点光源在缓冲里的布局：4 个 RGBA32F 纹素，着色器用 texelFetch(pointLightData, i * 4 + k) 读取
+struct PointLight
+{
+    glm::vec3 position;
+    float constant;
+    glm::vec3 ambient;
+    float linear;
+    glm::vec3 diffuse;
+    float quadratic;
+    glm::vec3 specular;
+    float padding;
+
+    // 默认是覆盖约 40 个单位距离的白光
+    PointLight() :
+        position(0.0f), constant(1.0f), ambient(0.05f), linear(0.09f), diffuse(0.8f), quadratic(0.032f),
+        specular(1.0f), padding(0.0f)
+    {
+    }
+
+    // 衰减后最亮的分量低于 threshold 的距离：解 constant + linear * d + quadratic * d^2 = maxColor / threshold。
+    // 超出这个半径的贡献可以忽略，用于光源分簇和光照体积
+    float Radius(float threshold = 5.0f / 256.0f) const
+    {
+        glm::vec3 color = glm::max(glm::max(ambient, diffuse), specular);
+        float brightest = std::max(color.x, std::max(color.y, color.z));
+        float c = constant - brightest / threshold;
+        if (c >= 0.0f)
+            return 0.0f;
+        if (quadratic > 0.0f)
+            return (-linear + std::sqrt(linear * linear - 4.0f * quadratic * c)) / (2.0f * quadratic);
+        if (linear > 0.0f)
+            return -c / linear;
+        return INFINITY; // 不衰减
+    }
+};
+
+#endif
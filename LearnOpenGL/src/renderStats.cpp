@@ -0,0 +1,61 @@
+#include "renderStats.h"
+
+#include <iostream>
+
+RenderStats &RenderStats::Instance()
+{
+    static RenderStats instance;
+    return instance;
+}
+
+RenderStats::RenderStats() :
+    vaoBinds(0), drawCalls(0), textureBinds(0), triangles(0), uniformLookups(0), uniformUploads(0), uniformSkips(0),
+    _frames(0), _totalVaoBinds(0), _totalDrawCalls(0), _totalTextureBinds(0), _totalTriangles(0),
+    _totalUniformLookups(0), _totalUniformUploads(0), _totalUniformSkips(0), _lastPrint(-1.0)
+{
+}
+
+void RenderStats::BeginFrame()
+{
+    _totalVaoBinds += vaoBinds;
+    _totalDrawCalls += drawCalls;
+    _totalTextureBinds += textureBinds;
+    _totalTriangles += triangles;
+    _totalUniformLookups += uniformLookups;
+    _totalUniformUploads += uniformUploads;
+    _totalUniformSkips += uniformSkips;
+    _frames++;
+    vaoBinds = 0;
+    drawCalls = 0;
+    textureBinds = 0;
+    triangles = 0;
+    uniformLookups = 0;
+    uniformUploads = 0;
+    uniformSkips = 0;
+}
+
+void RenderStats::PrintEvery(double now, double interval)
+{
+    if (_lastPrint < 0.0)
+    {
+        _lastPrint = now;
+        _frames = 0;
+        _totalVaoBinds = _totalDrawCalls = _totalTextureBinds = _totalTriangles = 0;
+        _totalUniformLookups = _totalUniformUploads = _totalUniformSkips = 0;
+        return;
+    }
+    if (now - _lastPrint < interval || _frames == 0)
+        return;
+
+    std::cout << "RENDER::STATS per frame: VAO binds " << (double)_totalVaoBinds / _frames
+              << ", draw calls " << (double)_totalDrawCalls / _frames
+              << ", texture binds " << (double)_totalTextureBinds / _frames
+              << ", triangles " << (double)_totalTriangles / _frames
+              << ", uniform lookups " << (double)_totalUniformLookups / _frames
+              << ", uniform uploads " << (double)_totalUniformUploads / _frames
+              << " (skipped " << (double)_totalUniformSkips / _frames << ")" << std::endl;
+    _lastPrint = now;
+    _frames = 0;
+    _totalVaoBinds = _totalDrawCalls = _totalTextureBinds = _totalTriangles = 0;
+    _totalUniformLookups = _totalUniformUploads = _totalUniformSkips = 0;
+}
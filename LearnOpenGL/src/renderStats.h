@@ -0,0 +1,38 @@
+#ifndef RENDER_STATS_H
+#define RENDER_STATS_H
+
+// 每帧的渲染计数器，用来观察各种合批/缓存优化的效果
+class RenderStats
+{
+public:
+    static RenderStats &Instance();
+
+    // 每帧开始时调用，清零本帧计数并累计到统计区间
+    void BeginFrame();
+    // 每隔 interval 秒打印一次区间内的每帧平均值
+    void PrintEvery(double now, double interval = 1.0);
+
+public:
+    unsigned int vaoBinds;
+    unsigned int drawCalls;
+    unsigned int textureBinds;
+    unsigned long triangles;
+    unsigned int uniformLookups; // 按名字设置 uniform 的次数（查反射表，不调用 glGetUniformLocation）
+    unsigned int uniformUploads; // 实际调用 glUniform* 的次数
+    unsigned int uniformSkips;   // 值没有变化而跳过的上传
+
+private:
+    RenderStats();
+
+    unsigned int _frames;
+    unsigned long _totalVaoBinds;
+    unsigned long _totalDrawCalls;
+    unsigned long _totalTextureBinds;
+    unsigned long _totalTriangles;
+    unsigned long _totalUniformLookups;
+    unsigned long _totalUniformUploads;
+    unsigned long _totalUniformSkips;
+    double _lastPrint;
+};
+
+#endif
@@ -0,0 +1,147 @@
+#include "sceneGraph.h"
+
+#include <iostream>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define SCENE_GRAPH_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SCENE_GRAPH_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+    // 列主序 out = a * b：out 的每一列是 a 的四列按 b 对应列的四个分量加权求和
+    inline void multiply(const float *a, const float *b, float *out)
+    {
+#if defined(SCENE_GRAPH_SSE2)
+        __m128 a0 = _mm_loadu_ps(a);
+        __m128 a1 = _mm_loadu_ps(a + 4);
+        __m128 a2 = _mm_loadu_ps(a + 8);
+        __m128 a3 = _mm_loadu_ps(a + 12);
+        for (int i = 0; i < 4; i++)
+        {
+            const float *column = b + i * 4;
+            __m128 result = _mm_mul_ps(a0, _mm_set1_ps(column[0]));
+            result = _mm_add_ps(result, _mm_mul_ps(a1, _mm_set1_ps(column[1])));
+            result = _mm_add_ps(result, _mm_mul_ps(a2, _mm_set1_ps(column[2])));
+            result = _mm_add_ps(result, _mm_mul_ps(a3, _mm_set1_ps(column[3])));
+            _mm_storeu_ps(out + i * 4, result);
+        }
+#elif defined(SCENE_GRAPH_NEON)
+        float32x4_t a0 = vld1q_f32(a);
+        float32x4_t a1 = vld1q_f32(a + 4);
+        float32x4_t a2 = vld1q_f32(a + 8);
+        float32x4_t a3 = vld1q_f32(a + 12);
+        for (int i = 0; i < 4; i++)
+        {
+            float32x4_t column = vld1q_f32(b + i * 4);
+            float32x4_t result = vmulq_n_f32(a0, vgetq_lane_f32(column, 0));
+            result = vmlaq_n_f32(result, a1, vgetq_lane_f32(column, 1));
+            result = vmlaq_n_f32(result, a2, vgetq_lane_f32(column, 2));
+            result = vmlaq_n_f32(result, a3, vgetq_lane_f32(column, 3));
+            vst1q_f32(out + i * 4, result);
+        }
+#else
+        for (int i = 0; i < 4; i++)
+        {
+            for (int r = 0; r < 4; r++)
+            {
+                out[i * 4 + r] = a[r] * b[i * 4] + a[4 + r] * b[i * 4 + 1] + a[8 + r] * b[i * 4 + 2] + a[12 + r] * b[i * 4 + 3];
+            }
+        }
+#endif
+    }
+}
+
+SceneGraph::SceneGraph() : _anyDirty(false)
+{
+}
+
+void SceneGraph::Clear()
+{
+    _parents.clear();
+    _locals.clear();
+    _worlds.clear();
+    _dirty.clear();
+    _names.clear();
+    _anyDirty = false;
+}
+
+unsigned int SceneGraph::AddNode(int parent, const glm::mat4 &local, const std::string &name)
+{
+    unsigned int index = (unsigned int)_parents.size();
+    if (parent >= (int)index)
+    {
+        std::cout << "ERROR::SCENE_GRAPH::PARENT_AFTER_CHILD " << name << std::endl;
+        parent = -1;
+    }
+    _parents.push_back(parent);
+    _locals.push_back(local);
+    _worlds.push_back(local);
+    _dirty.push_back(1);
+    _names.push_back(name);
+    _anyDirty = true;
+    return index;
+}
+
+int SceneGraph::Find(const std::string &name) const
+{
+    for (size_t i = 0; i < _names.size(); i++)
+    {
+        if (_names[i] == name)
+            return (int)i;
+    }
+    return -1;
+}
+
+void SceneGraph::SetLocal(unsigned int node, const glm::mat4 &local)
+{
+    _locals[node] = local;
+    _dirty[node] = 1;
+    _anyDirty = true;
+}
+
+unsigned int SceneGraph::Update()
+{
+    if (!_anyDirty)
+        return 0;
+
+    // 1. 父节点在前，顺序扫描一遍就能把脏标记传给所有子孙，同时收集要更新的节点
+    _updates.clear();
+    for (size_t i = 0; i < _parents.size(); i++)
+    {
+        int parent = _parents[i];
+        if (parent >= 0 && _dirty[parent])
+            _dirty[i] = 1;
+        if (_dirty[i])
+            _updates.push_back((unsigned int)i);
+    }
+
+    // 2. 按下标顺序批量计算，父节点的世界矩阵总是先算好
+    for (size_t i = 0; i < _updates.size(); i++)
+    {
+        unsigned int node = _updates[i];
+        int parent = _parents[node];
+        if (parent < 0)
+            _worlds[node] = _locals[node];
+        else
+            multiply(&_worlds[parent][0][0], &_locals[node][0][0], &_worlds[node][0][0]);
+    }
+    for (size_t i = 0; i < _updates.size(); i++)
+        _dirty[_updates[i]] = 0;
+    _anyDirty = false;
+    return (unsigned int)_updates.size();
+}
+
+const char *SceneGraph::SimdName()
+{
+#if defined(SCENE_GRAPH_SSE2)
+    return "SSE2";
+#elif defined(SCENE_GRAPH_NEON)
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,48 @@
+#ifndef SCENE_GRAPH_H
+#define SCENE_GRAPH_H
+
+#include "glm/glm.hpp"
+
+#include <string>
+#include <vector>
+
+// 扁平化的节点层级：节点按父节点在前的顺序存放，局部矩阵、世界矩阵、父节点下标和脏标记各是一个连续数组。
+// SetLocal 只标记脏节点，Update 顺序扫描一遍把脏标记传给子孙，
+// 再只对脏节点批量计算 world = world[parent] * local（SSE2/NEON 的 4x4 矩阵乘法）
+class SceneGraph
+{
+public:
+    SceneGraph();
+
+    void Clear();
+    // parent 为 -1 表示根节点，否则必须是已经添加的节点，保证父节点在前
+    unsigned int AddNode(int parent, const glm::mat4 &local, const std::string &name = std::string());
+
+    unsigned int NodeCount() const { return (unsigned int)_parents.size(); }
+    int Parent(unsigned int node) const { return _parents[node]; }
+    const std::string &Name(unsigned int node) const { return _names[node]; }
+    // 按名字查找，找不到返回 -1
+    int Find(const std::string &name) const;
+
+    const glm::mat4 &Local(unsigned int node) const { return _locals[node]; }
+    void SetLocal(unsigned int node, const glm::mat4 &local);
+    // 上一次 Update 之后的世界矩阵
+    const glm::mat4 &World(unsigned int node) const { return _worlds[node]; }
+
+    // 重新计算所有脏节点（及其子孙）的世界矩阵，返回更新的节点数
+    unsigned int Update();
+    bool Dirty() const { return _anyDirty; }
+
+    static const char *SimdName();
+
+private:
+    std::vector<int> _parents;
+    std::vector<glm::mat4> _locals;
+    std::vector<glm::mat4> _worlds;
+    std::vector<unsigned char> _dirty;
+    std::vector<std::string> _names;
+    std::vector<unsigned int> _updates; // Update 时收集的脏节点，复用避免每帧分配
+    bool _anyDirty;
+};
+
+#endif
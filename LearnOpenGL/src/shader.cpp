@@ -1,46 +1,117 @@
 #include "shader.hpp"
+#include "mappedFile.h"
+#include "assetPack.h"
+#include "traceRecorder.h"
+#include "renderStats.h"
 
-Shader::Shader(const char* vertexPath, const char* fragmentPath)
-{
-    // 1. 从文件路径中获取顶点/片段着色器
-    std::string vertexCode;
-    std::string fragmentCode;
-    std::ifstream vShaderFile;
-    std::ifstream fShaderFile;
-    // 保证ifstream对象可以抛出异常：
-    vShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-    fShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-    try
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    struct BlockBinding
+    {
+        const char *name;
+        GLuint binding;
+    };
+
+    const BlockBinding BLOCK_BINDINGS[] = {
+        { "Camera", UNIFORM_BLOCK_CAMERA },
+    };
+
+    // 把程序里的 uniform block 指向固定的绑定点，缓冲只需要绑定一次就对所有程序生效
+    void bindUniformBlocks(GLuint program)
+    {
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+        glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxLength);
+        std::vector<GLchar> buffer(std::max<GLint>(maxLength, 1));
+        for (GLint i = 0; i < count; i++)
+        {
+            GLsizei length = 0;
+            glGetActiveUniformBlockName(program, (GLuint)i, (GLsizei)buffer.size(), &length, &buffer[0]);
+            std::string name(&buffer[0], length);
+            size_t b = 0;
+            while (b < sizeof(BLOCK_BINDINGS) / sizeof(BLOCK_BINDINGS[0]) && name != BLOCK_BINDINGS[b].name)
+                b++;
+            if (b == sizeof(BLOCK_BINDINGS) / sizeof(BLOCK_BINDINGS[0]))
+            {
+                std::cout << "ERROR::SHADER::UNKNOWN_UNIFORM_BLOCK " << name << std::endl;
+                continue;
+            }
+            glUniformBlockBinding(program, (GLuint)i, BLOCK_BINDINGS[b].binding);
+        }
+    }
+}
+
+Shader::Shader(const char* vertexPath, const char* fragmentPath) : _vertexPath(vertexPath), _fragmentPath(fragmentPath)
+{
+    bool success;
+    progrom_id = build(vertexPath, fragmentPath, success);
+    reflect();
+}
+
+bool Shader::Reload()
+{
+    // 新程序编译链接都成功后才替换，否则继续使用原来的程序
+    bool success;
+    unsigned int program = build(_vertexPath.c_str(), _fragmentPath.c_str(), success);
+    if (!success)
+    {
+        glDeleteProgram(program);
+        std::cout << "ERROR::SHADER::RELOAD_FAILED keep previous program: " << _vertexPath << " + " << _fragmentPath << std::endl;
+        return false;
+    }
+    glDeleteProgram(progrom_id);
+    progrom_id = program;
+    reflect();
+    std::cout << "SHADER::RELOAD " << _vertexPath << " + " << _fragmentPath << std::endl;
+    return true;
+}
+
+bool Shader::Uses(const std::string &path) const
+{
+    return path == _vertexPath || path == _fragmentPath;
+}
+
+unsigned int Shader::build(const char* vertexPath, const char* fragmentPath, bool &ok)
+{
+    TRACE_ZONE_DETAIL("Shader::build", fragmentPath);
+    // 1. 优先从资源包取，否则映射顶点/片段着色器文件，直接把映射的字节连同长度交给 glShaderSource，
+    //    不再经过 ifstream/string 拷贝
+    AssetSpan vShaderSpan, fShaderSpan;
+    MappedFile vShaderFile;
+    MappedFile fShaderFile;
+    if (!AssetPack::Instance().Find(vertexPath, vShaderSpan) && vShaderFile.Open(vertexPath, true))
+    {
+        vShaderSpan.data = vShaderFile.Data();
+        vShaderSpan.size = vShaderFile.Size();
+    }
+    if (!AssetPack::Instance().Find(fragmentPath, fShaderSpan) && fShaderFile.Open(fragmentPath, true))
     {
-        // 打开文件
-        vShaderFile.open(vertexPath);
-        fShaderFile.open(fragmentPath);
-        std::stringstream vShaderStream, fShaderStream;
-        // 读取文件的缓冲内容到数据流中
-        vShaderStream << vShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();
-        // 关闭文件处理器
-        vShaderFile.close();
-        fShaderFile.close();
-        // 转换数据流到string
-        vertexCode   = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
+        fShaderSpan.data = fShaderFile.Data();
+        fShaderSpan.size = fShaderFile.Size();
     }
-    catch(std::ifstream::failure e)
+    if (!vShaderSpan.data || !fShaderSpan.data)
     {
         std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
+        ok = false;
+        return 0;
     }
-    const char* vShaderCode = vertexCode.c_str();
-    const char* fShaderCode = fragmentCode.c_str();
+    const char* vShaderCode = vShaderSpan.Chars();
+    const char* fShaderCode = fShaderSpan.Chars();
+    GLint vShaderLength = (GLint)vShaderSpan.size;
+    GLint fShaderLength = (GLint)fShaderSpan.size;
     
     // 2. 编译着色器
     unsigned int vertex, fragment;
     int success;
+    ok = true;
     char infoLog[512];
 
     // 顶点着色器
     vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, NULL);
+    glShaderSource(vertex, 1, &vShaderCode, &vShaderLength);
     glCompileShader(vertex);
     // 打印编译错误（如果有的话）
     glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
@@ -48,11 +119,12 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath)
     {
         glGetShaderInfoLog(vertex, 512, NULL, infoLog);
         std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+        ok = false;
     };
 
     // 片段着色器
     fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, NULL);
+    glShaderSource(fragment, 1, &fShaderCode, &fShaderLength);
     glCompileShader(fragment);
     // 打印编译错误（如果有的话）
     glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
@@ -60,24 +132,27 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath)
     {
         glGetShaderInfoLog(fragment, 512, NULL, infoLog);
         std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
+        ok = false;
     };
     
     // 3. 链接着色器程序
-    progrom_id = glCreateProgram();
-    glAttachShader(progrom_id, vertex);
-    glAttachShader(progrom_id, fragment);
-    glLinkProgram(progrom_id);
+    unsigned int program = glCreateProgram();
+    glAttachShader(program, vertex);
+    glAttachShader(program, fragment);
+    glLinkProgram(program);
     // 打印连接错误（如果有的话）
-    glGetProgramiv(progrom_id, GL_LINK_STATUS, &success);
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
     if(!success)
     {
-        glGetProgramInfoLog(progrom_id, 512, NULL, infoLog);
+        glGetProgramInfoLog(program, 512, NULL, infoLog);
         std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        ok = false;
     }
     
     // 删除着色器，它们已经链接到我们的程序中了，已经不再需要了
     glDeleteShader(vertex);
     glDeleteShader(fragment);
+    return program;
 }
 
 void Shader::use()
@@ -85,30 +160,180 @@ void Shader::use()
     glUseProgram(progrom_id);
 }
 
-void Shader::setBool(const std::string &name, bool value) const
+void Shader::setBool(const std::string &name, bool value)
 {
-    int location = glGetUniformLocation(progrom_id, name.c_str());
-    glUniform1i(location, (int)value);
+    RenderStats::Instance().uniformLookups++;
+    Set(Uniform<bool>(name), value);
 }
-void Shader::setInt(const std::string &name, int value) const
+void Shader::setInt(const std::string &name, int value)
 {
-    int location = glGetUniformLocation(progrom_id, name.c_str());
-    glUniform1i(location, value);
+    RenderStats::Instance().uniformLookups++;
+    Set(Uniform<int>(name), value);
 }
-void Shader::setFloat(const std::string &name, float value) const
+void Shader::setFloat(const std::string &name, float value)
 {
-    int location = glGetUniformLocation(progrom_id, name.c_str());
-    glUniform1f(location, value);
+    RenderStats::Instance().uniformLookups++;
+    Set(Uniform<float>(name), value);
 }
 
-void Shader::setMat4(const std::string &name, glm::mat4 mat) const
+void Shader::setMat3(const std::string &name, const glm::mat3 &mat)
 {
-    int location = glad_glGetUniformLocation(progrom_id, name.c_str());
-    glad_glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(mat));
+    RenderStats::Instance().uniformLookups++;
+    Set(Uniform<glm::mat3>(name), mat);
+}
+
+void Shader::setMat4(const std::string &name, glm::mat4 mat)
+{
+    RenderStats::Instance().uniformLookups++;
+    Set(Uniform<glm::mat4>(name), mat);
 }
 
 void Shader::setVec3(const std::string &name, glm::vec3 vector_value)
 {
-    int location = glad_glGetUniformLocation(progrom_id, name.c_str());
-    glad_glUniform3fv(location, 1, &vector_value[0]);
+    RenderStats::Instance().uniformLookups++;
+    Set(Uniform<glm::vec3>(name), vector_value);
+}
+
+void Shader::Set(ShaderUniform<bool> uniform, bool value)
+{
+    GLint data = value ? 1 : 0;
+    if (changed(uniform.slot, &data, sizeof(data)))
+        glUniform1i(_uniforms[uniform.slot].location, data);
+}
+
+void Shader::Set(ShaderUniform<int> uniform, int value)
+{
+    if (changed(uniform.slot, &value, sizeof(value)))
+        glUniform1i(_uniforms[uniform.slot].location, value);
+}
+
+void Shader::Set(ShaderUniform<float> uniform, float value)
+{
+    if (changed(uniform.slot, &value, sizeof(value)))
+        glUniform1f(_uniforms[uniform.slot].location, value);
+}
+
+void Shader::Set(ShaderUniform<glm::vec2> uniform, const glm::vec2 &value)
+{
+    if (changed(uniform.slot, glm::value_ptr(value), sizeof(GLfloat) * 2))
+        glUniform2fv(_uniforms[uniform.slot].location, 1, glm::value_ptr(value));
+}
+
+void Shader::Set(ShaderUniform<glm::ivec3> uniform, const glm::ivec3 &value)
+{
+    if (changed(uniform.slot, glm::value_ptr(value), sizeof(GLint) * 3))
+        glUniform3iv(_uniforms[uniform.slot].location, 1, glm::value_ptr(value));
+}
+
+void Shader::Set(ShaderUniform<glm::vec3> uniform, const glm::vec3 &value)
+{
+    if (changed(uniform.slot, glm::value_ptr(value), sizeof(GLfloat) * 3))
+        glUniform3fv(_uniforms[uniform.slot].location, 1, glm::value_ptr(value));
+}
+
+void Shader::Set(ShaderUniform<glm::mat3> uniform, const glm::mat3 &value)
+{
+    if (changed(uniform.slot, glm::value_ptr(value), sizeof(GLfloat) * 9))
+        glUniformMatrix3fv(_uniforms[uniform.slot].location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+void Shader::Set(ShaderUniform<glm::mat4> uniform, const glm::mat4 &value)
+{
+    if (changed(uniform.slot, glm::value_ptr(value), sizeof(GLfloat) * 16))
+        glUniformMatrix4fv(_uniforms[uniform.slot].location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+size_t Shader::ActiveUniformCount() const
+{
+    size_t count = 0;
+    for (size_t i = 0; i < _uniforms.size(); i++)
+    {
+        if (_uniforms[i].location >= 0)
+            count++;
+    }
+    return count;
+}
+
+void Shader::reflect()
+{
+    // 旧程序的 location 和缓存的值都不再有效；表项保留，外面拿着的句柄重新对应到新程序
+    for (size_t i = 0; i < _uniforms.size(); i++)
+    {
+        _uniforms[i].location = -1;
+        _uniforms[i].cached = false;
+    }
+
+    if (progrom_id == 0)
+        return;
+    bindUniformBlocks(progrom_id);
+
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(progrom_id, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(progrom_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::vector<GLchar> buffer(std::max<GLint>(maxLength, 1));
+    for (GLint i = 0; i < count; i++)
+    {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(progrom_id, (GLuint)i, (GLsizei)buffer.size(), &length, &size, &type, &buffer[0]);
+        std::string name(&buffer[0], length);
+
+        // 数组只报告第一个元素 "name[0]"，其余元素逐个查询 location（规范不保证连续）；
+        // 不带下标的名字等价于第 0 个元素
+        std::string base = name;
+        if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+            base = name.substr(0, name.size() - 3);
+        for (GLint element = 0; element < std::max<GLint>(size, 1); element++)
+        {
+            std::string elementName = size > 1 || base != name ? base + "[" + std::to_string(element) + "]" : name;
+            // uniform block 里的成员没有 location，由缓冲提供
+            GLint location = glGetUniformLocation(progrom_id, elementName.c_str());
+            if (location < 0)
+                continue;
+            UniformSlot &uniform = _uniforms[slot(elementName)];
+            uniform.location = location;
+            uniform.type = type;
+            if (element == 0 && elementName != base)
+            {
+                UniformSlot &alias = _uniforms[slot(base)];
+                alias.location = location;
+                alias.type = type;
+            }
+        }
+    }
+}
+
+int Shader::slot(const std::string &name)
+{
+    std::unordered_map<std::string, int>::const_iterator found = _uniformSlots.find(name);
+    if (found != _uniformSlots.end())
+        return found->second;
+
+    // 程序里没有的名字也登记一项（location 为 -1），热重载后着色器里加上了就能直接生效
+    UniformSlot uniform;
+    uniform.name = name;
+    uniform.location = -1;
+    uniform.type = 0;
+    uniform.cached = false;
+    _uniforms.push_back(uniform);
+    int index = (int)_uniforms.size() - 1;
+    _uniformSlots[name] = index;
+    return index;
+}
+
+bool Shader::changed(int slot, const void *value, size_t bytes)
+{
+    if (slot < 0 || _uniforms[slot].location < 0)
+        return false;
+    UniformSlot &uniform = _uniforms[slot];
+    if (uniform.cached && memcmp(uniform.value, value, bytes) == 0)
+    {
+        RenderStats::Instance().uniformSkips++;
+        return false;
+    }
+    memcpy(uniform.value, value, bytes);
+    uniform.cached = true;
+    RenderStats::Instance().uniformUploads++;
+    return true;
 }
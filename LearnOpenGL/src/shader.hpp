@@ -4,6 +4,8 @@
 #include <glad/glad.h>  // 包含glad来获取所有的必须OpenGL头文件
 
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -11,6 +13,24 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+// 所有程序共用的 uniform block 绑定点。GLSL 330 不能写 layout(binding = N)，
+// 程序链接后由 Shader 按块名设置（Camera -> UNIFORM_BLOCK_CAMERA）
+enum UniformBlockBinding
+{
+    UNIFORM_BLOCK_CAMERA = 0,
+};
+
+// 预先解析好的 uniform，模板参数是上传的值类型。slot 是 Shader 内部 uniform 表的下标，
+// 着色器热重载后按名字重新对应到新程序的 location，句柄仍然有效
+template <class T>
+struct ShaderUniform
+{
+    int slot;
+
+    ShaderUniform() : slot(-1) {}
+    bool Valid() const { return slot >= 0; }
+};
+
 class Shader
 {
 public:
@@ -22,13 +42,63 @@ public:
     // 使用/激活程序
     void use();
     
-    //uniform工具函数
-    void setBool(const std::string &name, bool value) const;
-    void setInt(const std::string &name, int value) const;
-    void setFloat(const std::string &name, float value) const;
-    void setMat4(const std::string &name, glm::mat4 mat) const;
+    //uniform工具函数：按名字在链接时反射出的表里查找（不再调用 glGetUniformLocation），
+    //值和上一次上传的相同时跳过
+    void setBool(const std::string &name, bool value);
+    void setInt(const std::string &name, int value);
+    void setFloat(const std::string &name, float value);
+    void setMat3(const std::string &name, const glm::mat3 &mat);
+    void setMat4(const std::string &name, glm::mat4 mat);
     void setVec3(const std::string &name, glm::vec3 vector_value);
-    
+
+    // 每帧都要设置的 uniform 先取句柄，设置时不再查找名字
+    template <class T>
+    ShaderUniform<T> Uniform(const std::string &name)
+    {
+        ShaderUniform<T> uniform;
+        uniform.slot = slot(name);
+        return uniform;
+    }
+    void Set(ShaderUniform<bool> uniform, bool value);
+    void Set(ShaderUniform<int> uniform, int value);
+    void Set(ShaderUniform<float> uniform, float value);
+    void Set(ShaderUniform<glm::vec2> uniform, const glm::vec2 &value);
+    void Set(ShaderUniform<glm::vec3> uniform, const glm::vec3 &value);
+    void Set(ShaderUniform<glm::ivec3> uniform, const glm::ivec3 &value);
+    void Set(ShaderUniform<glm::mat3> uniform, const glm::mat3 &value);
+    void Set(ShaderUniform<glm::mat4> uniform, const glm::mat4 &value);
+
+    // 链接后反射出的 active uniform 数量（数组按元素计）
+    size_t ActiveUniformCount() const;
+
+    // 重新读取、编译着色器文件，成功后替换程序；失败时保留原来的程序并返回 false
+    bool Reload();
+    // path 是否是这个程序使用的着色器文件
+    bool Uses(const std::string &path) const;
+
+private:
+    static unsigned int build(const GLchar* vertexPath, const GLchar* fragmentPath, bool &success);
+
+    // 一个 uniform（数组的每个元素单独一项），上一次上传的值按字节保存用来跳过重复上传
+    struct UniformSlot
+    {
+        std::string name;
+        GLint location;   // -1 表示当前程序里没有这个 uniform，设置时什么都不做
+        GLenum type;
+        bool cached;
+        GLfloat value[16];
+    };
+
+    // 用 glGetActiveUniform 枚举当前程序的 uniform，已有的项按名字更新 location，缓存的值作废
+    void reflect();
+    int slot(const std::string &name);
+    // 和缓存的值相同返回 false，否则记下新值并返回 true
+    bool changed(int slot, const void *value, size_t bytes);
+
+    std::string _vertexPath;
+    std::string _fragmentPath;
+    std::vector<UniformSlot> _uniforms;
+    std::unordered_map<std::string, int> _uniformSlots;
 };
 
 
@@ -0,0 +1,467 @@
+#include "textureCompressor.h"
+#include "mipmapGenerator.h"
+#include "mappedFile.h"
+#include "assetPack.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+    const char BCTEX_MAGIC[8] = { 'L', 'O', 'G', 'L', 'B', 'C', 'T', '\0' };
+
+    struct CacheHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t format;
+        uint64_t sourceSize;
+        int64_t sourceMtime;
+        uint32_t internalFormat;
+        uint32_t channels;
+        uint32_t levelCount;
+        uint32_t reserved;
+    };
+
+    struct CacheLevel
+    {
+        uint32_t width;
+        uint32_t height;
+        uint32_t size;
+        uint32_t reserved;
+    };
+
+    // 版本和魔数正确，并且（有源文件时）源文件没有修改过
+    bool cacheValid(const AssetSpan &file, bool hasSource, uint64_t sourceSize, int64_t sourceMtime)
+    {
+        if (file.size < sizeof(CacheHeader))
+            return false;
+        const CacheHeader *header = reinterpret_cast<const CacheHeader *>(file.data);
+        return memcmp(header->magic, BCTEX_MAGIC, sizeof(header->magic)) == 0
+            && header->version == TextureCompressor::VERSION
+            && (!hasSource || (header->sourceSize == sourceSize && header->sourceMtime == sourceMtime));
+    }
+
+    // 块格式、GL 格式和通道数要和 ChooseFormat/Transcode 能产生的组合一致，请求了通道数时还要相等
+    bool headerMatches(const CacheHeader &header, int desiredChannels)
+    {
+        if (header.levelCount == 0 || header.levelCount > 32 || header.format > BLOCK_BC5
+            || header.internalFormat != TextureCompressor::InternalFormat((BlockFormat)header.format)
+            || header.channels < 1 || header.channels > 4
+            || (desiredChannels != 0 && header.channels != (uint32_t)desiredChannels))
+        {
+            return false;
+        }
+        switch (header.channels)
+        {
+        case 1: return header.format == BLOCK_BC4;
+        case 2: return header.format == BLOCK_BC5;
+        default: return header.format == BLOCK_BC1 || header.format == BLOCK_BC3;
+        }
+    }
+
+    // 把任意通道数的图像展开成 RGBA8，方便统一处理
+    std::vector<unsigned char> expandToRGBA(const unsigned char *pixels, int width, int height, int channels)
+    {
+        size_t count = (size_t)width * height;
+        std::vector<unsigned char> rgba(count * 4);
+        for (size_t i = 0; i < count; i++)
+        {
+            const unsigned char *src = pixels + i * channels;
+            unsigned char *dst = &rgba[i * 4];
+            dst[0] = src[0];
+            dst[1] = channels > 1 ? src[1] : 0;
+            dst[2] = channels > 2 ? src[2] : 0;
+            dst[3] = channels > 3 ? src[3] : 255;
+        }
+        return rgba;
+    }
+
+    // 取出一个 4x4 块，超出边界的像素用边缘像素补齐
+    void fetchBlock(const std::vector<unsigned char> &rgba, int width, int height, int bx, int by, unsigned char block[16][4])
+    {
+        for (int y = 0; y < 4; y++)
+        {
+            int sy = std::min(by * 4 + y, height - 1);
+            for (int x = 0; x < 4; x++)
+            {
+                int sx = std::min(bx * 4 + x, width - 1);
+                memcpy(block[y * 4 + x], &rgba[((size_t)sy * width + sx) * 4], 4);
+            }
+        }
+    }
+
+    uint16_t packRGB565(const float color[3])
+    {
+        int r = (int)std::floor(std::max(0.0f, std::min(255.0f, color[0])) * 31.0f / 255.0f + 0.5f);
+        int g = (int)std::floor(std::max(0.0f, std::min(255.0f, color[1])) * 63.0f / 255.0f + 0.5f);
+        int b = (int)std::floor(std::max(0.0f, std::min(255.0f, color[2])) * 31.0f / 255.0f + 0.5f);
+        return (uint16_t)((r << 11) | (g << 5) | b);
+    }
+
+    void unpackRGB565(uint16_t packed, int color[3])
+    {
+        int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+        color[0] = (r << 3) | (r >> 2);
+        color[1] = (g << 2) | (g >> 4);
+        color[2] = (b << 3) | (b >> 2);
+    }
+
+    // BC1 颜色块：沿主成分方向取两个端点，再为每个像素选最近的调色板颜色
+    void encodeColorBlock(const unsigned char block[16][4], unsigned char *out)
+    {
+        float mean[3] = { 0.0f, 0.0f, 0.0f };
+        for (int i = 0; i < 16; i++)
+            for (int c = 0; c < 3; c++)
+                mean[c] += block[i][c] / 16.0f;
+
+        float cov[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+        for (int i = 0; i < 16; i++)
+        {
+            float r = block[i][0] - mean[0], g = block[i][1] - mean[1], b = block[i][2] - mean[2];
+            cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+            cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+        }
+
+        // 幂迭代求协方差矩阵的主特征向量
+        float axis[3] = { 1.0f, 1.0f, 1.0f };
+        for (int iteration = 0; iteration < 4; iteration++)
+        {
+            float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+            float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+            float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+            float length = std::max(std::max(std::fabs(x), std::fabs(y)), std::fabs(z));
+            if (length < 1e-6f)
+                break;
+            axis[0] = x / length; axis[1] = y / length; axis[2] = z / length;
+        }
+
+        float minProj = 1e30f, maxProj = -1e30f;
+        for (int i = 0; i < 16; i++)
+        {
+            float proj = (block[i][0] - mean[0]) * axis[0] + (block[i][1] - mean[1]) * axis[1] + (block[i][2] - mean[2]) * axis[2];
+            minProj = std::min(minProj, proj);
+            maxProj = std::max(maxProj, proj);
+        }
+        float axisLength2 = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+        float maxColor[3], minColor[3];
+        for (int c = 0; c < 3; c++)
+        {
+            maxColor[c] = mean[c] + axis[c] * maxProj / axisLength2;
+            minColor[c] = mean[c] + axis[c] * minProj / axisLength2;
+        }
+
+        uint16_t c0 = packRGB565(maxColor);
+        uint16_t c1 = packRGB565(minColor);
+        if (c0 < c1)
+            std::swap(c0, c1); // c0 > c1 时是四色模式
+
+        int palette[4][3];
+        unpackRGB565(c0, palette[0]);
+        unpackRGB565(c1, palette[1]);
+        for (int c = 0; c < 3; c++)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+
+        uint32_t indices = 0;
+        if (c0 != c1)
+        {
+            for (int i = 0; i < 16; i++)
+            {
+                int best = 0, bestError = 1 << 30;
+                for (int p = 0; p < 4; p++)
+                {
+                    int dr = block[i][0] - palette[p][0], dg = block[i][1] - palette[p][1], db = block[i][2] - palette[p][2];
+                    int error = dr * dr + dg * dg + db * db;
+                    if (error < bestError)
+                    {
+                        bestError = error;
+                        best = p;
+                    }
+                }
+                indices |= (uint32_t)best << (i * 2);
+            }
+        }
+
+        out[0] = (unsigned char)(c0 & 0xff); out[1] = (unsigned char)(c0 >> 8);
+        out[2] = (unsigned char)(c1 & 0xff); out[3] = (unsigned char)(c1 >> 8);
+        for (int b = 0; b < 4; b++)
+            out[4 + b] = (unsigned char)((indices >> (b * 8)) & 0xff);
+    }
+
+    // BC4 单通道块：8 级插值模式 (a0 > a1)
+    void encodeChannelBlock(const unsigned char block[16][4], int channel, unsigned char *out)
+    {
+        int maxValue = 0, minValue = 255;
+        for (int i = 0; i < 16; i++)
+        {
+            maxValue = std::max(maxValue, (int)block[i][channel]);
+            minValue = std::min(minValue, (int)block[i][channel]);
+        }
+
+        out[0] = (unsigned char)maxValue;
+        out[1] = (unsigned char)minValue;
+        uint64_t indices = 0;
+        if (maxValue != minValue)
+        {
+            int palette[8];
+            palette[0] = maxValue;
+            palette[1] = minValue;
+            for (int p = 1; p < 7; p++)
+                palette[p + 1] = ((7 - p) * maxValue + p * minValue) / 7;
+
+            for (int i = 0; i < 16; i++)
+            {
+                int best = 0, bestError = 1 << 30;
+                for (int p = 0; p < 8; p++)
+                {
+                    int error = std::abs(block[i][channel] - palette[p]);
+                    if (error < bestError)
+                    {
+                        bestError = error;
+                        best = p;
+                    }
+                }
+                indices |= (uint64_t)best << (i * 3);
+            }
+        }
+        for (int b = 0; b < 6; b++)
+            out[2 + b] = (unsigned char)((indices >> (b * 8)) & 0xff);
+    }
+
+    int blockBytes(BlockFormat format)
+    {
+        return (format == BLOCK_BC1 || format == BLOCK_BC4) ? 8 : 16;
+    }
+
+    uint64_t levelBytes(uint32_t width, uint32_t height, BlockFormat format)
+    {
+        return (uint64_t)((width + 3) / 4) * ((height + 3) / 4) * blockBytes(format);
+    }
+
+    CompressedLevel encodeLevel(const std::vector<unsigned char> &rgba, int width, int height, BlockFormat format)
+    {
+        CompressedLevel level;
+        level.width = width;
+        level.height = height;
+        int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+        int bytes = blockBytes(format);
+        level.data.resize((size_t)levelBytes(width, height, format));
+
+        unsigned char block[16][4];
+        for (int by = 0; by < blocksY; by++)
+        {
+            for (int bx = 0; bx < blocksX; bx++)
+            {
+                fetchBlock(rgba, width, height, bx, by, block);
+                unsigned char *out = &level.data[((size_t)by * blocksX + bx) * bytes];
+                switch (format)
+                {
+                case BLOCK_BC1:
+                    encodeColorBlock(block, out);
+                    break;
+                case BLOCK_BC3:
+                    encodeChannelBlock(block, 3, out);
+                    encodeColorBlock(block, out + 8);
+                    break;
+                case BLOCK_BC4:
+                    encodeChannelBlock(block, 0, out);
+                    break;
+                case BLOCK_BC5:
+                    encodeChannelBlock(block, 0, out);
+                    encodeChannelBlock(block, 1, out + 8);
+                    break;
+                }
+            }
+        }
+        return level;
+    }
+}
+
+size_t CompressedTexture::Bytes() const
+{
+    size_t bytes = 0;
+    for (size_t i = 0; i < levels.size(); i++)
+        bytes += levels[i].data.size();
+    return bytes;
+}
+
+BlockFormat TextureCompressor::ChooseFormat(const unsigned char *pixels, int width, int height, int channels)
+{
+    if (channels == 1)
+        return BLOCK_BC4;
+    if (channels == 2)
+        return BLOCK_BC5;
+    if (channels == 4)
+    {
+        size_t count = (size_t)width * height;
+        for (size_t i = 0; i < count; i++)
+        {
+            if (pixels[i * 4 + 3] != 255)
+                return BLOCK_BC3;
+        }
+    }
+    return BLOCK_BC1;
+}
+
+GLenum TextureCompressor::InternalFormat(BlockFormat format)
+{
+    switch (format)
+    {
+    case BLOCK_BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    case BLOCK_BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case BLOCK_BC4: return GL_COMPRESSED_RED_RGTC1;
+    case BLOCK_BC5: return GL_COMPRESSED_RG_RGTC2;
+    }
+    return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+}
+
+CompressedTexture TextureCompressor::Transcode(const unsigned char *pixels, int width, int height, int channels, bool srgb)
+{
+    CompressedTexture texture;
+    texture.format = ChooseFormat(pixels, width, height, channels);
+    texture.internalFormat = InternalFormat(texture.format);
+    texture.channels = channels;
+
+    std::vector<unsigned char> rgba = expandToRGBA(pixels, width, height, channels);
+    texture.levels.push_back(encodeLevel(rgba, width, height, texture.format));
+
+    // mip 链由 MipmapGenerator 生成，颜色贴图在线性空间滤波
+    std::vector<MipLevel> mips = MipmapGenerator::Generate(&rgba[0], width, height, 4, srgb && channels >= 3);
+    for (size_t i = 0; i < mips.size(); i++)
+        texture.levels.push_back(encodeLevel(mips[i].data, mips[i].width, mips[i].height, texture.format));
+    return texture;
+}
+
+std::string TextureCompressor::CachePathFor(const std::string &sourcePath, int desiredChannels, bool srgb)
+{
+    std::stringstream ss;
+    ss << sourcePath << "." << desiredChannels << (srgb ? ".srgb" : "") << ".bctex";
+    return ss.str();
+}
+
+bool TextureCompressor::LoadCache(const std::string &sourcePath, int desiredChannels, bool srgb, CompressedTexture &texture)
+{
+    // 和源图片的来源比较：松散文件存在时是它，否则是资源包里打包的那份
+    uint64_t sourceSize;
+    int64_t sourceMtime;
+    bool hasSource = AssetPack::Instance().Stamp(sourcePath, sourceSize, sourceMtime);
+
+    std::string cachePath = CachePathFor(sourcePath, desiredChannels, srgb);
+    AssetSpan file;
+    MappedFile mapped;
+    if (!AssetPack::Instance().Find(cachePath, file) || !cacheValid(file, hasSource, sourceSize, sourceMtime))
+    {
+        // 包里没有或者已经过期，读源文件旁边的缓存
+        if (!hasSource || !mapped.Open(cachePath))
+            return false;
+        file.data = mapped.Data();
+        file.size = mapped.Size();
+        if (!cacheValid(file, true, sourceSize, sourceMtime))
+            return false;
+    }
+
+    const CacheHeader *header = reinterpret_cast<const CacheHeader *>(file.data);
+    if (!headerMatches(*header, desiredChannels))
+    {
+        std::cout << "ERROR::TEXTURE_COMPRESSOR::CORRUPT_CACHE " << cachePath << std::endl;
+        return false;
+    }
+
+    // 先读到临时对象里，缓存损坏时不改动 texture，调用方退回解码源图片
+    CompressedTexture loaded;
+    loaded.format = (BlockFormat)header->format;
+    loaded.internalFormat = header->internalFormat;
+    loaded.channels = (int)header->channels;
+    loaded.levels.resize(header->levelCount);
+    size_t offset = sizeof(CacheHeader);
+    for (uint32_t i = 0; i < header->levelCount; i++)
+    {
+        if (offset + sizeof(CacheLevel) > file.size)
+            return false;
+        const CacheLevel *level = reinterpret_cast<const CacheLevel *>(file.data + offset);
+        offset += sizeof(CacheLevel);
+        // 尺寸要和上一级的 mip 链一致，数据大小要正好是这个尺寸的块数乘块大小
+        bool sizeMatches = i == 0
+            ? level->width > 0 && level->height > 0
+            : (int)level->width == std::max(1, loaded.levels[i - 1].width / 2)
+              && (int)level->height == std::max(1, loaded.levels[i - 1].height / 2);
+        if (!sizeMatches || level->width > 65536 || level->height > 65536
+            || level->size != levelBytes(level->width, level->height, loaded.format)
+            || offset + level->size > file.size)
+        {
+            std::cout << "ERROR::TEXTURE_COMPRESSOR::CORRUPT_CACHE " << cachePath << std::endl;
+            return false;
+        }
+        loaded.levels[i].width = (int)level->width;
+        loaded.levels[i].height = (int)level->height;
+        loaded.levels[i].data.assign(file.data + offset, file.data + offset + level->size);
+        offset += level->size;
+    }
+    texture = std::move(loaded);
+    return true;
+}
+
+bool TextureCompressor::SaveCache(const std::string &sourcePath, int desiredChannels, bool srgb, const CompressedTexture &texture,
+                                  uint64_t sourceSize, int64_t sourceMtime)
+{
+    CacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BCTEX_MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.format = (uint32_t)texture.format;
+    header.internalFormat = texture.internalFormat;
+    header.channels = (uint32_t)texture.channels;
+    header.levelCount = (uint32_t)texture.levels.size();
+    header.sourceSize = sourceSize;
+    header.sourceMtime = sourceMtime;
+
+    // 可能有多个解码线程同时写缓存，先写临时文件再改名
+    std::string cachePath = CachePathFor(sourcePath, desiredChannels, srgb);
+    std::string tempPath = cachePath + ".tmp";
+    FILE *file = fopen(tempPath.c_str(), "wb");
+    if (!file)
+    {
+        std::cout << "ERROR::TEXTURE_CACHE::CANNOT_WRITE " << tempPath << std::endl;
+        return false;
+    }
+    fwrite(&header, sizeof(header), 1, file);
+    for (size_t i = 0; i < texture.levels.size(); i++)
+    {
+        CacheLevel level;
+        level.width = (uint32_t)texture.levels[i].width;
+        level.height = (uint32_t)texture.levels[i].height;
+        level.size = (uint32_t)texture.levels[i].data.size();
+        level.reserved = 0;
+        fwrite(&level, sizeof(level), 1, file);
+        fwrite(&texture.levels[i].data[0], 1, level.size, file);
+    }
+    bool ok = ferror(file) == 0;
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(tempPath.c_str(), cachePath.c_str()) != 0)
+    {
+        std::cout << "ERROR::TEXTURE_CACHE::CANNOT_WRITE " << cachePath << std::endl;
+        remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool TextureCompressor::IsSupported()
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++)
+    {
+        const char *name = reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, i));
+        if (name && strcmp(name, "GL_EXT_texture_compression_s3tc") == 0)
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,70 @@
+#ifndef TEXTURE_COMPRESSOR_H
+#define TEXTURE_COMPRESSOR_H
+
+#include <glad/glad.h>
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// glad 只生成了 GL 3.3 core，S3TC 属于扩展，这里补上枚举值
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+enum BlockFormat
+{
+    BLOCK_BC1, // RGB，4bpp
+    BLOCK_BC3, // RGBA，8bpp
+    BLOCK_BC4, // R，4bpp
+    BLOCK_BC5  // RG，8bpp
+};
+
+struct CompressedLevel
+{
+    int width;
+    int height;
+    std::vector<unsigned char> data;
+};
+
+// 一张完整mip链的块压缩纹理，可以直接用 glCompressedTexImage2D 逐级上传
+struct CompressedTexture
+{
+    BlockFormat format;
+    GLenum internalFormat;
+    int channels; // 原图（或请求）的通道数
+    std::vector<CompressedLevel> levels;
+
+    size_t Bytes() const;
+};
+
+// CPU 端的块压缩转码，以及 <图片路径>.<通道数>[.srgb].bctex 形式的磁盘缓存
+class TextureCompressor
+{
+public:
+    static const uint32_t VERSION = 2; // 2: mip 链改由 MipmapGenerator 生成
+
+    // 按通道使用情况选择格式：单通道BC4，双通道BC5，不透明RGB(A)用BC1，带透明度用BC3
+    static BlockFormat ChooseFormat(const unsigned char *pixels, int width, int height, int channels);
+    static GLenum InternalFormat(BlockFormat format);
+
+    // 生成完整mip链并逐级编码，pixels 为紧密排列的 channels 通道 8bit 数据，
+    // srgb 为 true 时 mip 在线性空间滤波
+    static CompressedTexture Transcode(const unsigned char *pixels, int width, int height, int channels, bool srgb);
+
+    // sRGB 和线性贴图的 mip 链不同，分别缓存
+    static std::string CachePathFor(const std::string &sourcePath, int desiredChannels, bool srgb);
+    // 读取缓存，源文件（松散文件或资源包里的）的大小或修改时间变化时返回 false
+    static bool LoadCache(const std::string &sourcePath, int desiredChannels, bool srgb, CompressedTexture &texture);
+    // sourceSize/sourceMtime 是读取源图片之前用 AssetPack::Stamp 取得的，记录的是实际解码的内容
+    static bool SaveCache(const std::string &sourcePath, int desiredChannels, bool srgb, const CompressedTexture &texture,
+                          uint64_t sourceSize, int64_t sourceMtime);
+
+    // 需要在GL线程调用：当前上下文是否支持 BC1/BC3 (S3TC)
+    static bool IsSupported();
+};
+
+#endif
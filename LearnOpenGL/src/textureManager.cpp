@@ -0,0 +1,898 @@
+#include "textureManager.h"
+#include "threadPool.h"
+#include "mappedFile.h"
+#include "assetPack.h"
+#include "stb_image.h"
+#include "traceRecorder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+    std::string canonicalPath(const std::string &path)
+    {
+#ifdef _WIN32
+        char resolved[_MAX_PATH];
+        if (_fullpath(resolved, path.c_str(), _MAX_PATH))
+            return std::string(resolved);
+#else
+        char resolved[PATH_MAX];
+        if (realpath(path.c_str(), resolved))
+            return std::string(resolved);
+#endif
+        return path; // 文件不存在时保持原样，交给stbi报错
+    }
+
+    int channelsForFormat(GLenum format)
+    {
+        switch (format)
+        {
+        case GL_RED:  return 1;
+        case GL_RG:   return 2;
+        case GL_RGB:  return 3;
+        case GL_RGBA: return 4;
+        default:      return 0;
+        }
+    }
+
+    GLenum formatForChannels(int channels)
+    {
+        if (channels == 1)
+            return GL_RED;
+        else if (channels == 2)
+            return GL_RG;
+        else if (channels == 4)
+            return GL_RGBA;
+        return GL_RGB;
+    }
+}
+
+TextureResource::TextureResource() : id(0), target(GL_TEXTURE_2D), width(0), height(0), channels(0), layers(1), screenSize(-1.0f)
+{
+}
+
+void TextureResource::RequestScreenSize(float pixels)
+{
+    screenSize = std::max(screenSize, pixels);
+}
+
+TextureResource::~TextureResource()
+{
+    if (id != 0)
+        glDeleteTextures(1, &id);
+}
+
+TextureCacheStats::TextureCacheStats() :
+    hits(0), misses(0), failures(0), bytesUploaded(0), bytesSaved(0),
+    decodeSeconds(0.0), uploadSeconds(0.0), secondsSaved(0.0),
+    compressedFromCache(0), compressedTranscoded(0), bytesStreamed(0), streamedTextures(0)
+{
+}
+
+bool TextureManager::Key::operator<(const Key &other) const
+{
+    if (path != other.path)
+        return path < other.path;
+    if (format != other.format)
+        return format < other.format;
+    if (wrap != other.wrap)
+        return wrap < other.wrap;
+    return srgb < other.srgb;
+}
+
+TextureManager &TextureManager::Instance()
+{
+    static TextureManager instance;
+    return instance;
+}
+
+TextureManager::TextureManager() : _decodePool(new ThreadPool()), _compression(false), _streaming(false)
+{
+}
+
+TextureManager::~TextureManager()
+{
+}
+
+void TextureManager::SetDecodeThreads(unsigned int threadCount)
+{
+    FinishPending();
+    _decodePool.reset(threadCount > 0 ? new ThreadPool(threadCount) : nullptr);
+}
+
+bool TextureManager::SetCompression(bool enabled)
+{
+    FinishPending();
+    if (enabled && !TextureCompressor::IsSupported())
+    {
+        std::cout << "WARNING::TEXTURE::S3TC_NOT_SUPPORTED, keep uncompressed textures" << std::endl;
+        enabled = false;
+    }
+    _compression = enabled;
+    return _compression;
+}
+
+bool TextureManager::Compression() const
+{
+    return _compression;
+}
+
+void TextureManager::SetStreaming(bool enabled)
+{
+    _streaming = enabled;
+}
+
+bool TextureManager::Streaming() const
+{
+    return _streaming;
+}
+
+size_t TextureManager::StreamingCount() const
+{
+    return _streamingTextures.size();
+}
+
+unsigned int TextureManager::DecodeThreads() const
+{
+    return _decodePool ? _decodePool->Size() : 0;
+}
+
+TextureHandle TextureManager::Load(const std::string &path, GLenum format, GLint wrap, bool srgb)
+{
+    return acquire(path, format, wrap, srgb, false);
+}
+
+TextureHandle TextureManager::LoadAsync(const std::string &path, GLenum format, GLint wrap, bool srgb)
+{
+    return acquire(path, format, wrap, srgb, true);
+}
+
+TextureHandle TextureManager::acquire(const std::string &path, GLenum format, GLint wrap, bool srgb, bool async)
+{
+    Key key;
+    key.path = canonicalPath(path);
+    key.format = format;
+    key.wrap = wrap;
+    key.srgb = srgb;
+
+    TextureHandle cached = findCached(key);
+    if (cached)
+        return cached;
+
+    int desiredChannels = channelsForFormat(format);
+    if (async && _streaming && _decodePool)
+        return stream(key, std::vector<std::string>(1, key.path), GL_TEXTURE_2D, desiredChannels, srgb);
+
+    // 先在GL线程分配好id，调用方可以立即保存，内容等解码完成后再上传
+    TextureHandle texture(new TextureResource());
+    texture->path = key.path;
+    glGenTextures(1, &texture->id);
+
+    Entry &entry = _cache[key];
+    entry.texture = texture;
+    entry.bytes = 0;
+    entry.seconds = 0.0;
+
+    if (!async || !_decodePool)
+    {
+        DecodedImage image = decode(key.path, desiredChannels, _compression, srgb);
+        if (!upload(key, *texture, image))
+        {
+            _cache.erase(key);
+            return TextureHandle();
+        }
+        return texture;
+    }
+
+    Pending pending;
+    pending.key = key;
+    pending.texture = texture;
+    std::string decodePath = key.path;
+    bool compress = _compression;
+    pending.image = _decodePool->Submit([decodePath, desiredChannels, compress, srgb]() {
+        return TextureManager::decode(decodePath, desiredChannels, compress, srgb);
+    });
+    _pending.push_back(std::move(pending));
+    return texture;
+}
+
+TextureHandle TextureManager::findCached(const Key &key)
+{
+    std::map<Key, Entry>::iterator it = _cache.find(key);
+    if (it != _cache.end())
+    {
+        TextureHandle cached = it->second.texture.lock();
+        if (cached)
+        {
+            _stats.hits++;
+            _stats.bytesSaved += it->second.bytes;
+            _stats.secondsSaved += it->second.seconds;
+            return cached;
+        }
+    }
+    _stats.misses++;
+    return TextureHandle();
+}
+
+TextureHandle TextureManager::LoadArray(const std::vector<std::string> &paths, GLenum format, GLint wrap, bool srgb)
+{
+    if (paths.empty())
+        return TextureHandle();
+
+    Key key;
+    key.format = format;
+    key.wrap = wrap;
+    key.srgb = srgb;
+    std::vector<std::string> canonical(paths.size());
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        canonical[i] = canonicalPath(paths[i]);
+        key.path += (i ? "\n" : "") + canonical[i];
+    }
+
+    TextureHandle cached = findCached(key);
+    if (cached)
+        return cached;
+
+    int desiredChannels = channelsForFormat(format);
+    if (_streaming && _decodePool)
+        return stream(key, canonical, GL_TEXTURE_2D_ARRAY, desiredChannels, srgb);
+
+    // 各层并行解码（包括 mip 生成或块压缩），全部完成后在GL线程一次上传
+    std::vector<DecodedImage> images = decodeAll(canonical, desiredChannels, srgb);
+
+    TextureHandle texture(new TextureResource());
+    texture->path = key.path;
+    texture->target = GL_TEXTURE_2D_ARRAY;
+    glGenTextures(1, &texture->id);
+
+    Entry &entry = _cache[key];
+    entry.texture = texture;
+    entry.bytes = 0;
+    entry.seconds = 0.0;
+    if (!uploadArray(key, *texture, images))
+    {
+        _cache.erase(key);
+        return TextureHandle();
+    }
+    return texture;
+}
+
+std::vector<TextureManager::DecodedImage> TextureManager::decodeAll(const std::vector<std::string> &paths, int desiredChannels, bool srgb)
+{
+    bool compress = _compression;
+    std::vector<DecodedImage> images(paths.size());
+    if (_decodePool)
+    {
+        std::vector<std::future<DecodedImage> > futures;
+        for (size_t i = 0; i < paths.size(); i++)
+        {
+            std::string decodePath = paths[i];
+            futures.push_back(_decodePool->Submit([decodePath, desiredChannels, compress, srgb]() {
+                return TextureManager::decode(decodePath, desiredChannels, compress, srgb);
+            }));
+        }
+        for (size_t i = 0; i < futures.size(); i++)
+            images[i] = futures[i].get();
+    }
+    else
+    {
+        for (size_t i = 0; i < paths.size(); i++)
+            images[i] = decode(paths[i], desiredChannels, compress, srgb);
+    }
+    return images;
+}
+
+unsigned int TextureManager::Reload(const std::string &path)
+{
+    // 异步加载的纹理先完成，避免旧的解码结果覆盖新内容
+    FinishPending();
+
+    std::string changed = canonicalPath(path);
+    unsigned int reloaded = 0;
+    for (std::map<Key, Entry>::iterator it = _cache.begin(); it != _cache.end(); ++it)
+    {
+        TextureHandle texture = it->second.texture.lock();
+        if (!texture)
+            continue;
+        const Key &key = it->first;
+        std::vector<std::string> layers;
+        std::istringstream stream(key.path);
+        for (std::string layer; std::getline(stream, layer);)
+            layers.push_back(layer);
+        if (std::find(layers.begin(), layers.end(), changed) == layers.end())
+            continue;
+
+        std::vector<DecodedImage> images = decodeAll(layers, channelsForFormat(key.format), key.srgb);
+        bool uploaded = texture->target == GL_TEXTURE_2D_ARRAY
+            ? uploadArray(key, *texture, images) : upload(key, *texture, images[0]);
+        if (!uploaded)
+        {
+            std::cout << "ERROR::TEXTURE::RELOAD_FAILED keep previous content: " << changed << std::endl;
+            continue;
+        }
+
+        // 重新上传了完整的 mip 链，不再需要流式加载
+        cancelStreaming(texture.get());
+        glBindTexture(texture->target, texture->id);
+        glTexParameteri(texture->target, GL_TEXTURE_BASE_LEVEL, 0);
+        glBindTexture(texture->target, 0);
+        reloaded++;
+    }
+    if (reloaded > 0)
+        std::cout << "TEXTURE::RELOAD " << changed << " textures: " << reloaded << std::endl;
+    return reloaded;
+}
+
+void TextureManager::cancelStreaming(const TextureResource *texture)
+{
+    for (size_t i = _streamingTextures.size(); i-- > 0;)
+    {
+        StreamingTexture &streaming = _streamingTextures[i];
+        if (streaming.texture.lock().get() != texture)
+            continue;
+        // 还在解码的话等它结束，释放解码结果
+        for (size_t f = 0; f < streaming.futures.size(); f++)
+            streaming.images.push_back(streaming.futures[f].get());
+        release(streaming.images);
+        _streamingTextures.erase(_streamingTextures.begin() + i);
+    }
+}
+
+void TextureManager::FinishPending()
+{
+    for (size_t i = 0; i < _pending.size(); i++)
+    {
+        DecodedImage image = _pending[i].image.get();
+        if (!upload(_pending[i].key, *_pending[i].texture, image))
+            forget(_pending[i].key, _pending[i].texture.get());
+    }
+    _pending.clear();
+}
+
+void TextureManager::forget(const Key &key, const TextureResource *texture)
+{
+    // 缓存里已经换成了别的纹理（比如重新加载过）时不动它
+    std::map<Key, Entry>::iterator it = _cache.find(key);
+    if (it == _cache.end())
+        return;
+    TextureHandle current = it->second.texture.lock();
+    if (!current || current.get() == texture)
+        _cache.erase(it);
+}
+
+TextureManager::DecodedImage TextureManager::decode(const std::string &path, int desiredChannels, bool compress, bool srgb)
+{
+    TRACE_ZONE_DETAIL("TextureManager::decode", path);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    DecodedImage image;
+    image.data = nullptr;
+    image.width = image.height = image.channels = 0;
+    image.fromCache = false;
+
+    // 有可用的块压缩缓存时连图片解码都省掉
+    if (compress && TextureCompressor::LoadCache(path, desiredChannels, srgb, image.compressed))
+    {
+        image.width = image.compressed.levels[0].width;
+        image.height = image.compressed.levels[0].height;
+        image.channels = image.compressed.channels;
+        image.fromCache = true;
+        image.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return image;
+    }
+
+    // 直接从资源包或映射的文件解码，省掉 stdio 的缓冲拷贝。
+    // 读之前记下来源的大小和修改时间，写进块压缩缓存，读的过程中文件被修改也不会把旧内容当成新的
+    uint64_t sourceSize = 0;
+    int64_t sourceMtime = 0;
+    bool hasSource = AssetPack::Instance().Stamp(path, sourceSize, sourceMtime);
+    int nrComponents = 0;
+    AssetSpan span;
+    MappedFile file;
+    if (!AssetPack::Instance().Find(path, span) && file.Open(path, true))
+    {
+        span.data = file.Data();
+        span.size = file.Size();
+    }
+    if (span.data && span.size <= (size_t)INT_MAX)
+    {
+        image.data = stbi_load_from_memory(span.data, (int)span.size, &image.width, &image.height,
+                                           &nrComponents, desiredChannels);
+    }
+    image.channels = desiredChannels != 0 ? desiredChannels : nrComponents;
+    if (compress && image.data)
+    {
+        image.compressed = TextureCompressor::Transcode(image.data, image.width, image.height, image.channels, srgb);
+        if (hasSource)
+            TextureCompressor::SaveCache(path, desiredChannels, srgb, image.compressed, sourceSize, sourceMtime);
+        stbi_image_free(image.data);
+        image.data = nullptr;
+    }
+    else if (image.data)
+    {
+        // 在解码线程上生成 mip 链，GL线程只需要逐级上传
+        image.mips = MipmapGenerator::Generate(image.data, image.width, image.height, image.channels, srgb);
+    }
+    image.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return image;
+}
+
+bool TextureManager::upload(const Key &key, TextureResource &texture, const DecodedImage &image)
+{
+    TRACE_ZONE_DETAIL("TextureManager::upload", key.path);
+    bool compressed = !image.compressed.levels.empty();
+    if (!image.data && !compressed)
+    {
+        std::cout << "Texture failed to load at path: " << key.path << std::endl;
+        _stats.failures++;
+        return false;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    texture.width = image.width;
+    texture.height = image.height;
+    texture.channels = image.channels;
+
+    size_t bytes;
+    glBindTexture(GL_TEXTURE_2D, texture.id);
+    if (compressed)
+    {
+        // 块压缩数据自带完整mip链，逐级上传，不再需要 glGenerateMipmap
+        const CompressedTexture &blocks = image.compressed;
+        for (size_t level = 0; level < blocks.levels.size(); level++)
+        {
+            glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)level, blocks.internalFormat,
+                                   blocks.levels[level].width, blocks.levels[level].height, 0,
+                                   (GLsizei)blocks.levels[level].data.size(), &blocks.levels[level].data[0]);
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)blocks.levels.size() - 1);
+        bytes = blocks.Bytes();
+        if (image.fromCache)
+            _stats.compressedFromCache++;
+        else
+            _stats.compressedTranscoded++;
+    }
+    else
+    {
+        // mip 链已经在解码线程上生成，逐级上传，不再调用 glGenerateMipmap
+        GLenum uploadFormat = formatForChannels(image.channels);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // 单通道/三通道的行宽不一定是4字节对齐
+        glTexImage2D(GL_TEXTURE_2D, 0, uploadFormat, image.width, image.height, 0, uploadFormat, GL_UNSIGNED_BYTE, image.data);
+        bytes = (size_t)image.width * image.height * image.channels;
+        for (size_t level = 0; level < image.mips.size(); level++)
+        {
+            const MipLevel &mip = image.mips[level];
+            glTexImage2D(GL_TEXTURE_2D, (GLint)level + 1, uploadFormat, mip.width, mip.height, 0, uploadFormat, GL_UNSIGNED_BYTE, &mip.data[0]);
+            bytes += mip.data.size();
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)image.mips.size());
+    }
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, key.wrap);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, key.wrap);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    if (image.data)
+        stbi_image_free(image.data);
+
+    double uploadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    record(key, bytes, image.seconds, uploadSeconds);
+    return true;
+}
+
+bool TextureManager::uploadArray(const Key &key, TextureResource &texture, std::vector<DecodedImage> &images)
+{
+    TRACE_ZONE_DETAIL("TextureManager::uploadArray", key.path);
+    if (!validateLayers(key, images))
+    {
+        _stats.failures++;
+        release(images);
+        return false;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const DecodedImage &first = images[0];
+    texture.width = first.width;
+    texture.height = first.height;
+    texture.channels = first.channels;
+    texture.layers = (int)images.size();
+
+    // 先按整个数组分配每一级的存储，再逐层填充
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture.id);
+    size_t bytes = allocateLevels(texture, images);
+    for (int level = 0; level < levelCount(first); level++)
+        uploadLevel(texture, images, level);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, key.wrap);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, key.wrap);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    double decodeSeconds = 0.0;
+    for (size_t i = 0; i < images.size(); i++)
+        decodeSeconds += images[i].seconds;
+    if (!first.compressed.levels.empty())
+    {
+        if (first.fromCache)
+            _stats.compressedFromCache += texture.layers;
+        else
+            _stats.compressedTranscoded += texture.layers;
+    }
+    release(images);
+
+    double uploadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    record(key, bytes, decodeSeconds, uploadSeconds);
+    return true;
+}
+
+TextureHandle TextureManager::stream(const Key &key, const std::vector<std::string> &paths, GLenum target, int desiredChannels, bool srgb)
+{
+    TextureHandle texture(new TextureResource());
+    texture->path = key.path;
+    texture->target = target;
+    texture->layers = (int)paths.size();
+    glGenTextures(1, &texture->id);
+
+    // 解码完成之前先放一张 1x1 的中灰色占位纹理，模型可以立即绘制
+    std::vector<unsigned char> placeholder(paths.size() * 4, 128);
+    for (size_t i = 0; i < paths.size(); i++)
+        placeholder[i * 4 + 3] = 255;
+    glBindTexture(target, texture->id);
+    if (target == GL_TEXTURE_2D_ARRAY)
+        glTexImage3D(target, 0, GL_RGBA, 1, 1, (GLsizei)paths.size(), 0, GL_RGBA, GL_UNSIGNED_BYTE, &placeholder[0]);
+    else
+        glTexImage2D(target, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, &placeholder[0]);
+    glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexParameteri(target, GL_TEXTURE_WRAP_S, key.wrap);
+    glTexParameteri(target, GL_TEXTURE_WRAP_T, key.wrap);
+    glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(target, 0);
+
+    Entry &entry = _cache[key];
+    entry.texture = texture;
+    entry.bytes = 0;
+    entry.seconds = 0.0;
+
+    StreamingTexture streaming;
+    streaming.key = key;
+    streaming.texture = texture;
+    streaming.levels = 0;
+    streaming.baseLevel = 0;
+    bool compress = _compression;
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        std::string decodePath = paths[i];
+        streaming.futures.push_back(_decodePool->Submit([decodePath, desiredChannels, compress, srgb]() {
+            return TextureManager::decode(decodePath, desiredChannels, compress, srgb);
+        }));
+    }
+    _streamingTextures.push_back(std::move(streaming));
+    return texture;
+}
+
+bool TextureManager::beginStreaming(StreamingTexture &streaming, TextureResource &texture)
+{
+    std::vector<DecodedImage> &images = streaming.images;
+    if (!validateLayers(streaming.key, images))
+    {
+        _stats.failures++;
+        forget(streaming.key, &texture);
+        return false; // 保留占位色
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const DecodedImage &first = images[0];
+    texture.width = first.width;
+    texture.height = first.height;
+    texture.channels = first.channels;
+    streaming.levels = levelCount(first);
+
+    // 一次分配完整的 mip 链（替换掉占位纹理），但只填充最小的几级，
+    // BASE_LEVEL 指向其中最大的一级，纹理立即有了正确的整体颜色
+    glBindTexture(texture.target, texture.id);
+    size_t bytes = allocateLevels(texture, images);
+    int level = streaming.levels - 1;
+    size_t tail = uploadLevel(texture, images, level);
+    while (level > 0)
+    {
+        int width, height;
+        size_t levelBytes;
+        levelData(first, level - 1, width, height, levelBytes);
+        if (tail + levelBytes * images.size() > STREAMING_TAIL_BYTES)
+            break;
+        tail += uploadLevel(texture, images, --level);
+    }
+    glTexParameteri(texture.target, GL_TEXTURE_BASE_LEVEL, level);
+    glBindTexture(texture.target, 0);
+    streaming.baseLevel = level;
+
+    double decodeSeconds = 0.0;
+    for (size_t i = 0; i < images.size(); i++)
+        decodeSeconds += images[i].seconds;
+    if (!first.compressed.levels.empty())
+    {
+        if (first.fromCache)
+            _stats.compressedFromCache += texture.layers;
+        else
+            _stats.compressedTranscoded += texture.layers;
+    }
+    _stats.bytesStreamed += tail;
+
+    double uploadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    record(streaming.key, bytes, decodeSeconds, uploadSeconds);
+    return true;
+}
+
+void TextureManager::UpdateStreaming(size_t byteBudget)
+{
+    TRACE_ZONE("TextureManager::UpdateStreaming");
+    // 收取解码完成的纹理，某一层还没解码完的整个纹理留到下一帧
+    for (size_t i = 0; i < _streamingTextures.size(); i++)
+    {
+        StreamingTexture &streaming = _streamingTextures[i];
+        if (streaming.futures.empty())
+            continue;
+        bool ready = true;
+        for (size_t f = 0; f < streaming.futures.size() && ready; f++)
+            ready = streaming.futures[f].wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        if (!ready)
+            continue;
+
+        streaming.images.resize(streaming.futures.size());
+        for (size_t f = 0; f < streaming.futures.size(); f++)
+            streaming.images[f] = streaming.futures[f].get();
+        streaming.futures.clear();
+        TextureHandle texture = streaming.texture.lock();
+        if (!texture || !beginStreaming(streaming, *texture))
+            streaming.baseLevel = 0; // 已经释放或解码失败，下面直接清理
+    }
+
+    // 屏幕尺寸越大越先上传，需要的最高精度是尺寸与屏幕像素数相当的一级；
+    // 从没上报过尺寸的纹理（比如不带 LodView 绘制）按纹理自身尺寸排序并完整上传
+    std::vector<std::pair<float, size_t> > order;
+    std::vector<int> desiredLevels(_streamingTextures.size(), 0);
+    for (size_t i = 0; i < _streamingTextures.size(); i++)
+    {
+        StreamingTexture &streaming = _streamingTextures[i];
+        if (!streaming.futures.empty() || streaming.baseLevel == 0)
+            continue;
+        TextureHandle texture = streaming.texture.lock();
+        if (!texture)
+        {
+            streaming.baseLevel = 0;
+            continue;
+        }
+
+        float size = (float)std::max(texture->width, texture->height);
+        float priority = size;
+        if (texture->screenSize >= 0.0f)
+        {
+            priority = texture->screenSize;
+            int desired = 0;
+            while (desired < streaming.levels - 1 && size * 0.5f >= texture->screenSize)
+            {
+                size *= 0.5f;
+                desired++;
+            }
+            desiredLevels[i] = desired;
+            texture->screenSize = 0.0f; // 每帧重新上报，这一帧没画到的纹理不再继续上传
+        }
+        if (streaming.baseLevel > desiredLevels[i])
+            order.push_back(std::make_pair(priority, i));
+    }
+    std::sort(order.begin(), order.end(), std::greater<std::pair<float, size_t> >());
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    size_t uploaded = 0;
+    bool budgetLeft = true;
+    for (size_t o = 0; o < order.size() && budgetLeft; o++)
+    {
+        StreamingTexture &streaming = _streamingTextures[order[o].second];
+        TextureHandle texture = streaming.texture.lock();
+        glBindTexture(texture->target, texture->id);
+        while (streaming.baseLevel > desiredLevels[order[o].second])
+        {
+            int width, height;
+            size_t levelBytes;
+            levelData(streaming.images[0], streaming.baseLevel - 1, width, height, levelBytes);
+            levelBytes *= streaming.images.size();
+            if (uploaded > 0 && uploaded + levelBytes > byteBudget)
+            {
+                budgetLeft = false;
+                break;
+            }
+            uploaded += uploadLevel(*texture, streaming.images, --streaming.baseLevel);
+            glTexParameteri(texture->target, GL_TEXTURE_BASE_LEVEL, streaming.baseLevel);
+        }
+        glBindTexture(texture->target, 0);
+    }
+    if (uploaded > 0)
+    {
+        _stats.bytesStreamed += uploaded;
+        _stats.uploadSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // 全部驻留（或已释放、失败）的纹理不再需要CPU端的数据
+    for (size_t i = _streamingTextures.size(); i-- > 0;)
+    {
+        StreamingTexture &streaming = _streamingTextures[i];
+        if (!streaming.futures.empty() || streaming.baseLevel > 0)
+            continue;
+        if (streaming.levels > 0 && !streaming.texture.expired())
+            _stats.streamedTextures++;
+        release(streaming.images);
+        _streamingTextures.erase(_streamingTextures.begin() + i);
+    }
+}
+
+bool TextureManager::validateLayers(const Key &key, const std::vector<DecodedImage> &images)
+{
+    // 所有层的尺寸、通道数、压缩格式和mip级数必须一致
+    bool valid = true;
+    const DecodedImage &first = images[0];
+    bool compressed = !first.compressed.levels.empty();
+    for (size_t i = 0; i < images.size(); i++)
+    {
+        const DecodedImage &image = images[i];
+        if (!image.data && image.compressed.levels.empty())
+        {
+            std::cout << "Texture failed to load at path: " << key.path << std::endl;
+            valid = false;
+        }
+        else if (image.width != first.width || image.height != first.height || image.channels != first.channels
+                 || image.compressed.levels.empty() == compressed
+                 || image.compressed.internalFormat != first.compressed.internalFormat
+                 || image.compressed.levels.size() != first.compressed.levels.size())
+        {
+            std::cout << "ERROR::TEXTURE::ARRAY_LAYER_MISMATCH " << key.path << std::endl;
+            valid = false;
+        }
+    }
+    return valid;
+}
+
+int TextureManager::levelCount(const DecodedImage &image)
+{
+    if (!image.compressed.levels.empty())
+        return (int)image.compressed.levels.size();
+    return (int)image.mips.size() + 1;
+}
+
+const unsigned char *TextureManager::levelData(const DecodedImage &image, int level, int &width, int &height, size_t &bytes)
+{
+    if (!image.compressed.levels.empty())
+    {
+        const CompressedLevel &compressed = image.compressed.levels[level];
+        width = compressed.width;
+        height = compressed.height;
+        bytes = compressed.data.size();
+        return &compressed.data[0];
+    }
+    if (level == 0)
+    {
+        width = image.width;
+        height = image.height;
+        bytes = (size_t)width * height * image.channels;
+        return image.data;
+    }
+    const MipLevel &mip = image.mips[level - 1];
+    width = mip.width;
+    height = mip.height;
+    bytes = mip.data.size();
+    return &mip.data[0];
+}
+
+size_t TextureManager::allocateLevels(const TextureResource &texture, const std::vector<DecodedImage> &images)
+{
+    const DecodedImage &first = images[0];
+    bool compressed = !first.compressed.levels.empty();
+    GLenum format = compressed ? first.compressed.internalFormat : formatForChannels(first.channels);
+    GLsizei layers = (GLsizei)images.size();
+    int levels = levelCount(first);
+    size_t total = 0;
+    for (int level = 0; level < levels; level++)
+    {
+        int width, height;
+        size_t bytes;
+        levelData(first, level, width, height, bytes);
+        if (texture.target == GL_TEXTURE_2D_ARRAY && compressed)
+            glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, format, width, height, layers, 0, (GLsizei)(bytes * layers), nullptr);
+        else if (texture.target == GL_TEXTURE_2D_ARRAY)
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, level, format, width, height, layers, 0, format, GL_UNSIGNED_BYTE, nullptr);
+        else if (compressed)
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, format, width, height, 0, (GLsizei)bytes, nullptr);
+        else
+            glTexImage2D(GL_TEXTURE_2D, level, format, width, height, 0, format, GL_UNSIGNED_BYTE, nullptr);
+        total += bytes * layers;
+    }
+    glTexParameteri(texture.target, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    return total;
+}
+
+size_t TextureManager::uploadLevel(const TextureResource &texture, const std::vector<DecodedImage> &images, int level)
+{
+    bool compressed = !images[0].compressed.levels.empty();
+    GLenum format = compressed ? images[0].compressed.internalFormat : formatForChannels(images[0].channels);
+    size_t total = 0;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // 单通道/三通道的行宽不一定是4字节对齐
+    for (size_t layer = 0; layer < images.size(); layer++)
+    {
+        int width, height;
+        size_t bytes;
+        const unsigned char *data = levelData(images[layer], level, width, height, bytes);
+        if (texture.target == GL_TEXTURE_2D_ARRAY && compressed)
+            glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, (GLint)layer, width, height, 1, format, (GLsizei)bytes, data);
+        else if (texture.target == GL_TEXTURE_2D_ARRAY)
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, (GLint)layer, width, height, 1, format, GL_UNSIGNED_BYTE, data);
+        else if (compressed)
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, format, (GLsizei)bytes, data);
+        else
+            glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, format, GL_UNSIGNED_BYTE, data);
+        total += bytes;
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    return total;
+}
+
+void TextureManager::release(std::vector<DecodedImage> &images)
+{
+    for (size_t i = 0; i < images.size(); i++)
+    {
+        if (images[i].data)
+            stbi_image_free(images[i].data);
+        images[i].data = nullptr;
+    }
+}
+
+void TextureManager::record(const Key &key, size_t bytes, double decodeSeconds, double uploadSeconds)
+{
+    std::map<Key, Entry>::iterator it = _cache.find(key);
+    if (it != _cache.end())
+    {
+        it->second.bytes = bytes;
+        it->second.seconds = decodeSeconds + uploadSeconds;
+    }
+
+    _stats.bytesUploaded += bytes;
+    _stats.decodeSeconds += decodeSeconds;
+    _stats.uploadSeconds += uploadSeconds;
+}
+
+const TextureCacheStats &TextureManager::Stats() const
+{
+    return _stats;
+}
+
+void TextureManager::PrintStats() const
+{
+    std::cout << "TEXTURE::CACHE hits: " << _stats.hits
+              << " misses: " << _stats.misses
+              << " failures: " << _stats.failures
+              << " | uploaded " << _stats.bytesUploaded / (1024.0 * 1024.0) << " MB"
+              << " (decode " << _stats.decodeSeconds * 1000.0 << " ms on " << DecodeThreads() << " threads"
+              << ", upload " << _stats.uploadSeconds * 1000.0 << " ms)"
+              << " | saved " << _stats.bytesSaved / (1024.0 * 1024.0) << " MB VRAM, "
+              << _stats.secondsSaved * 1000.0 << " ms";
+    if (_compression)
+    {
+        std::cout << " | BC cache hits: " << _stats.compressedFromCache
+                  << " transcoded: " << _stats.compressedTranscoded;
+    }
+    if (_streaming)
+    {
+        std::cout << " | streamed " << _stats.bytesStreamed / (1024.0 * 1024.0) << " MB, "
+                  << _stats.streamedTextures << " textures resident, " << _streamingTextures.size() << " streaming";
+    }
+    std::cout << std::endl;
+}
@@ -0,0 +1,194 @@
+#ifndef TEXTURE_MANAGER_H
+#define TEXTURE_MANAGER_H
+
+#include <glad/glad.h>
+#include "textureCompressor.h"
+#include "mipmapGenerator.h"
+
+#include <future>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+// 一张已经上传到GPU的纹理，最后一个持有者释放时删除对应的GL纹理
+struct TextureResource
+{
+    unsigned int id;
+    GLenum target; // GL_TEXTURE_2D 或 GL_TEXTURE_2D_ARRAY
+    int width;
+    int height;
+    int channels;
+    int layers;    // 纹理数组的层数，普通纹理为 1
+    std::string path; // 规范化之后的绝对路径，纹理数组为各层路径用换行连接
+    float screenSize; // 本帧使用这张纹理的mesh投影到屏幕上的最大尺寸（像素），负数表示从未上报
+
+    TextureResource();
+
+    // 绘制时上报所在mesh的屏幕尺寸，流式加载按它决定上传顺序和需要的最高精度
+    void RequestScreenSize(float pixels);
+    ~TextureResource();
+
+private:
+    TextureResource(const TextureResource &);
+    TextureResource &operator=(const TextureResource &);
+};
+
+typedef std::shared_ptr<TextureResource> TextureHandle;
+
+struct TextureCacheStats
+{
+    unsigned int hits;
+    unsigned int misses;
+    unsigned int failures;
+    size_t bytesUploaded; // 估算的显存占用（含mipmap）
+    size_t bytesSaved;    // 命中缓存而省下的显存
+    double decodeSeconds; // 解码的总耗时（多线程时为各线程之和）
+    double uploadSeconds; // GL线程上传的总耗时
+    double secondsSaved;  // 命中缓存而省下的耗时
+    unsigned int compressedFromCache; // 直接读取 .bctex 缓存、跳过解码的次数
+    unsigned int compressedTranscoded; // 本次运行新转码的次数
+    size_t bytesStreamed;             // 流式加载逐级上传的数据量
+    unsigned int streamedTextures;    // 已经完整驻留的流式纹理数
+
+    TextureCacheStats();
+};
+
+// 进程内共享的纹理管理器：以 (规范化路径, 请求的格式, 环绕方式) 为键，
+// 同一张图片只解码、上传一次，之后返回同一个引用计数的句柄
+class TextureManager
+{
+public:
+    static TextureManager &Instance();
+
+    // format 为 0 时按图片自身的通道数选择 GL_RED/GL_RGB/GL_RGBA，
+    // 否则按请求的格式强制转换通道数。srgb 表示颜色贴图，mipmap 在线性空间滤波；
+    // 高光、法线之类的数据贴图传 false。加载失败时返回空句柄
+    TextureHandle Load(const std::string &path, GLenum format = 0, GLint wrap = GL_REPEAT, bool srgb = true);
+
+    // 异步加载：立即分配纹理id并返回句柄，解码和 mipmap 生成交给后台线程，
+    // 直到 FinishPending() 在GL线程完成上传之前纹理内容是空的
+    TextureHandle LoadAsync(const std::string &path, GLenum format = 0, GLint wrap = GL_REPEAT, bool srgb = true);
+    // 等待所有后台解码完成，并在当前(GL)线程上传
+    void FinishPending();
+
+    // 把尺寸相同的多张图片打包成一个 GL_TEXTURE_2D_ARRAY，第 i 张图片为第 i 层。
+    // 各层在后台线程并行解码，函数返回前完成上传。尺寸或压缩格式不一致时返回空句柄
+    TextureHandle LoadArray(const std::vector<std::string> &paths, GLenum format = 0, GLint wrap = GL_REPEAT, bool srgb = true);
+
+    // 开启后贴图在后台线程转码为 BC1/BC3/BC4/BC5 并缓存到磁盘，
+    // 之后用 glCompressedTexImage2D 直接上传完整mip链。需要在GL线程调用，
+    // 当前上下文不支持 S3TC 时保持关闭并返回 false
+    bool SetCompression(bool enabled);
+    bool Compression() const;
+
+    // 热重载：重新解码所有用到 path 这张图片的纹理（包括纹理数组的某一层），在原来的GL纹理上重新上传，
+    // 持有者拿到的 id 不变。解码失败时保留原来的内容。返回重新加载的纹理数
+    unsigned int Reload(const std::string &path);
+
+    // 开启后 LoadAsync/LoadArray 立即返回一张 1x1 占位色纹理，也不再需要 FinishPending()：
+    // 后台解码完成后先上传最小的几级 mip，更高精度的级别由 UpdateStreaming() 按屏幕尺寸逐帧补上，
+    // 期间用 GL_TEXTURE_BASE_LEVEL 把采样限制在已经驻留的级别。没有解码线程时不生效
+    void SetStreaming(bool enabled);
+    bool Streaming() const;
+    // 每帧在GL线程调用一次：收取后台解码完成的纹理，按上报的屏幕尺寸从大到小上传更高一级的 mip，
+    // 每帧上传的数据不超过 byteBudget（至少一级）。屏幕尺寸用不到的级别暂不上传
+    void UpdateStreaming(size_t byteBudget = DEFAULT_STREAMING_BUDGET);
+    // 还没有完全驻留（或仍在解码）的流式纹理数
+    size_t StreamingCount() const;
+
+    static const size_t DEFAULT_STREAMING_BUDGET = 4 * 1024 * 1024;
+    static const size_t STREAMING_TAIL_BYTES = 64 * 1024; // 解码完成后立即上传的最小几级 mip 的总大小
+
+    // 设置解码线程数，0 表示在调用线程上串行解码
+    void SetDecodeThreads(unsigned int threadCount);
+    unsigned int DecodeThreads() const;
+
+    const TextureCacheStats &Stats() const;
+    void PrintStats() const;
+
+private:
+    TextureManager();
+    ~TextureManager();
+
+    struct Key
+    {
+        std::string path;
+        GLenum format;
+        GLint wrap;
+        bool srgb;
+
+        bool operator<(const Key &other) const;
+    };
+
+    struct Entry
+    {
+        std::weak_ptr<TextureResource> texture;
+        size_t bytes;
+        double seconds; // 首次加载花费的时间，命中时记为节省
+    };
+
+    struct DecodedImage
+    {
+        unsigned char *data;
+        int width;
+        int height;
+        int channels;
+        double seconds;
+        CompressedTexture compressed; // levels 非空时表示已经是块压缩数据
+        std::vector<MipLevel> mips;   // 未压缩时第 1 级开始的 mip 链
+        bool fromCache;
+    };
+
+    struct Pending
+    {
+        Key key;
+        TextureHandle texture;
+        std::future<DecodedImage> image;
+    };
+
+    struct StreamingTexture
+    {
+        Key key;
+        std::weak_ptr<TextureResource> texture;
+        std::vector<std::future<DecodedImage> > futures; // 非空表示还在解码
+        std::vector<DecodedImage> images; // 每层一张，保留到需要的级别全部上传为止
+        int levels;
+        int baseLevel;                    // 已经驻留的最高精度 mip
+    };
+
+    static DecodedImage decode(const std::string &path, int desiredChannels, bool compress, bool srgb);
+    // 在解码线程上并行解码多张图片，等待全部完成
+    std::vector<DecodedImage> decodeAll(const std::vector<std::string> &paths, int desiredChannels, bool srgb);
+    void cancelStreaming(const TextureResource *texture);
+    TextureHandle acquire(const std::string &path, GLenum format, GLint wrap, bool srgb, bool async);
+    TextureHandle findCached(const Key &key);
+    bool upload(const Key &key, TextureResource &texture, const DecodedImage &image);
+    bool uploadArray(const Key &key, TextureResource &texture, std::vector<DecodedImage> &images);
+    TextureHandle stream(const Key &key, const std::vector<std::string> &paths, GLenum target, int desiredChannels, bool srgb);
+    bool beginStreaming(StreamingTexture &streaming, TextureResource &texture);
+    // 异步解码或上传失败：从缓存里移除，之后的 Load 重新解码（文件修好后热重载也能重试），
+    // 已经拿到句柄的调用方继续持有空纹理或占位色
+    void forget(const Key &key, const TextureResource *texture);
+
+    // 按整个纹理（所有层）分配每一级的存储 / 上传其中一级，纹理需要已经绑定，返回字节数
+    size_t allocateLevels(const TextureResource &texture, const std::vector<DecodedImage> &images);
+    size_t uploadLevel(const TextureResource &texture, const std::vector<DecodedImage> &images, int level);
+    static bool validateLayers(const Key &key, const std::vector<DecodedImage> &images);
+    static int levelCount(const DecodedImage &image);
+    static const unsigned char *levelData(const DecodedImage &image, int level, int &width, int &height, size_t &bytes);
+    static void release(std::vector<DecodedImage> &images);
+    void record(const Key &key, size_t bytes, double decodeSeconds, double uploadSeconds);
+
+    std::map<Key, Entry> _cache;
+    std::vector<Pending> _pending;
+    std::vector<StreamingTexture> _streamingTextures;
+    std::unique_ptr<ThreadPool> _decodePool;
+    bool _compression;
+    bool _streaming;
+    TextureCacheStats _stats;
+};
+
+#endif
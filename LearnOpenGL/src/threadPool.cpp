@@ -0,0 +1,48 @@
+#include "threadPool.h"
+#include "traceRecorder.h"
+
+ThreadPool::ThreadPool(unsigned int threadCount) : _stopping(false)
+{
+    if (threadCount == 0)
+        threadCount = std::thread::hardware_concurrency();
+    if (threadCount == 0)
+        threadCount = 1;
+
+    for (unsigned int i = 0; i < threadCount; i++)
+        _workers.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _wakeup.notify_all();
+    for (size_t i = 0; i < _workers.size(); i++)
+        _workers[i].join();
+}
+
+unsigned int ThreadPool::Size() const
+{
+    return (unsigned int)_workers.size();
+}
+
+void ThreadPool::workerLoop(unsigned int index)
+{
+    TraceRecorder::Instance().SetThreadName("worker " + std::to_string(index));
+    while (true)
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wakeup.wait(lock, [this]() { return _stopping || !_jobs.empty(); });
+            // 退出前先把已提交的任务做完，保证future都能拿到结果
+            if (_jobs.empty())
+                return;
+            job = std::move(_jobs.front());
+            _jobs.pop_front();
+        }
+        job();
+    }
+}
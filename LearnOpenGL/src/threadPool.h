@@ -0,0 +1,52 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 固定线程数的任务池，用于把图片解码之类不依赖GL上下文的工作放到后台线程
+class ThreadPool
+{
+public:
+    // threadCount 为 0 时使用硬件线程数
+    explicit ThreadPool(unsigned int threadCount = 0);
+    ~ThreadPool();
+
+    unsigned int Size() const;
+
+    // 提交一个任务，返回可以在任意线程等待结果的future
+    template <class F>
+    std::future<typename std::result_of<F()>::type> Submit(F task)
+    {
+        typedef typename std::result_of<F()>::type Result;
+        std::shared_ptr<std::packaged_task<Result()> > job(new std::packaged_task<Result()>(task));
+        std::future<Result> result = job->get_future();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _jobs.push_back([job]() { (*job)(); });
+        }
+        _wakeup.notify_one();
+        return result;
+    }
+
+private:
+    ThreadPool(const ThreadPool &);
+    ThreadPool &operator=(const ThreadPool &);
+
+    void workerLoop(unsigned int index);
+
+private:
+    std::vector<std::thread> _workers;
+    std::deque<std::function<void()> > _jobs;
+    std::mutex _mutex;
+    std::condition_variable _wakeup;
+    bool _stopping;
+};
+
+#endif
@@ -0,0 +1,219 @@
+#include "traceRecorder.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+    // 每块 4096 个事件（约 288KB），每个线程最多 1024 块；每帧只有十几个区间，按 60 帧算能记录一个多小时
+    const size_t TRACE_CHUNK_EVENTS = 1 << 12;
+    const size_t TRACE_MAX_CHUNKS = 1 << 10;
+
+    uint64_t steadyNs()
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // 路径之类的附加信息只保留末尾，文件名最有用
+    void copyDetail(char *target, size_t capacity, const char *detail, size_t length)
+    {
+        if (!detail)
+        {
+            target[0] = '\0';
+            return;
+        }
+        if (length >= capacity)
+        {
+            detail += length - (capacity - 1);
+            length = capacity - 1;
+        }
+        memcpy(target, detail, length);
+        target[length] = '\0';
+    }
+
+    void writeEscaped(FILE *file, const char *text)
+    {
+        for (; *text; text++)
+        {
+            unsigned char c = (unsigned char)*text;
+            if (c == '"' || c == '\\')
+                fprintf(file, "\\%c", c);
+            else if (c < 0x20)
+                fprintf(file, "\\u%04x", c);
+            else
+                fputc(c, file);
+        }
+    }
+
+    thread_local void *currentBuffer = nullptr;
+    // 还没有记录过事件的线程先把名字存在这里，注册缓冲区时再带上，从不记录的线程不占用缓冲区
+    thread_local std::string pendingName;
+}
+
+TraceRecorder &TraceRecorder::Instance()
+{
+    static TraceRecorder instance;
+    return instance;
+}
+
+TraceRecorder::TraceRecorder() : _enabled(true), _origin(steadyNs())
+{
+}
+
+uint64_t TraceRecorder::Now() const
+{
+    return steadyNs() - _origin;
+}
+
+TraceRecorder::ThreadBuffer *TraceRecorder::threadBuffer()
+{
+    if (currentBuffer)
+        return static_cast<ThreadBuffer *>(currentBuffer);
+
+    // 每个线程只在第一次记录时加锁注册，缓冲区一直保留到进程退出，线程结束后事件仍然可以导出
+    std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer());
+    buffer->chunks.reset(new std::unique_ptr<TraceEvent[]>[TRACE_MAX_CHUNKS]);
+    buffer->chunks[0].reset(new TraceEvent[TRACE_CHUNK_EVENTS]);
+    buffer->count.store(0, std::memory_order_relaxed);
+    buffer->dropped.store(0, std::memory_order_relaxed);
+    buffer->name.swap(pendingName);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    buffer->id = (unsigned int)_buffers.size() + 1;
+    currentBuffer = buffer.get();
+    _buffers.push_back(std::move(buffer));
+    return _buffers.back().get();
+}
+
+void TraceRecorder::Record(const char *name, uint64_t startNs, uint64_t endNs, const char *detail)
+{
+    if (!Enabled())
+        return;
+
+    ThreadBuffer *buffer = threadBuffer();
+    size_t index = buffer->count.load(std::memory_order_relaxed);
+    size_t chunk = index / TRACE_CHUNK_EVENTS;
+    if (chunk >= TRACE_MAX_CHUNKS)
+    {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    // 只有本线程写块表，新块在下面的 release 之前分配好
+    if (!buffer->chunks[chunk])
+        buffer->chunks[chunk].reset(new TraceEvent[TRACE_CHUNK_EVENTS]);
+    TraceEvent &event = buffer->chunks[chunk][index % TRACE_CHUNK_EVENTS];
+    event.name = name;
+    event.startNs = startNs;
+    event.durationNs = endNs > startNs ? endNs - startNs : 0;
+    copyDetail(event.detail, sizeof(event.detail), detail, detail ? strlen(detail) : 0);
+    // 事件写完才发布，导出线程看到的计数之内的事件都是完整的
+    buffer->count.store(index + 1, std::memory_order_release);
+}
+
+void TraceRecorder::SetThreadName(const std::string &name)
+{
+    if (!currentBuffer)
+    {
+        pendingName = name;
+        return;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    static_cast<ThreadBuffer *>(currentBuffer)->name = name;
+}
+
+bool TraceRecorder::WriteJson(const std::string &path)
+{
+    FILE *file = fopen(path.c_str(), "wb");
+    if (!file)
+    {
+        std::cout << "ERROR::TRACE::CANNOT_WRITE " << path << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    size_t total = 0, dropped = 0;
+    bool first = true;
+    fprintf(file, "{\"traceEvents\":[\n");
+    for (size_t i = 0; i < _buffers.size(); i++)
+    {
+        const ThreadBuffer &buffer = *_buffers[i];
+        std::string name = buffer.name.empty() ? "thread " + std::to_string(buffer.id) : buffer.name;
+        fprintf(file, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"",
+                first ? "" : ",\n", buffer.id);
+        writeEscaped(file, name.c_str());
+        fprintf(file, "\"}}");
+        first = false;
+
+        size_t count = buffer.count.load(std::memory_order_acquire);
+        for (size_t e = 0; e < count; e++)
+        {
+            const TraceEvent &event = buffer.chunks[e / TRACE_CHUNK_EVENTS][e % TRACE_CHUNK_EVENTS];
+            // Chrome 的时间单位是微秒，保留三位小数即纳秒精度
+            fprintf(file, ",\n{\"ph\":\"X\",\"name\":\"");
+            writeEscaped(file, event.name);
+            fprintf(file, "\",\"pid\":1,\"tid\":%u,\"ts\":%llu.%03u,\"dur\":%llu.%03u", buffer.id,
+                    (unsigned long long)(event.startNs / 1000), (unsigned int)(event.startNs % 1000),
+                    (unsigned long long)(event.durationNs / 1000), (unsigned int)(event.durationNs % 1000));
+            if (event.detail[0])
+            {
+                fprintf(file, ",\"args\":{\"detail\":\"");
+                writeEscaped(file, event.detail);
+                fprintf(file, "\"}");
+            }
+            fprintf(file, "}");
+        }
+        total += count;
+        dropped += buffer.dropped.load(std::memory_order_relaxed);
+    }
+    fprintf(file, "\n],\"displayTimeUnit\":\"ns\"}\n");
+
+    bool ok = ferror(file) == 0;
+    ok = fclose(file) == 0 && ok;
+    if (!ok)
+    {
+        std::cout << "ERROR::TRACE::CANNOT_WRITE " << path << std::endl;
+        return false;
+    }
+    std::cout << "TRACE::WRITE " << path << ": " << total << " events, " << _buffers.size() << " threads";
+    if (dropped > 0)
+        std::cout << ", " << dropped << " dropped";
+    std::cout << std::endl;
+    return true;
+}
+
+TraceZone::TraceZone(const char *name, const char *detail) : _name(name), _start(0)
+{
+    _detail[0] = '\0';
+    TraceRecorder &recorder = TraceRecorder::Instance();
+    if (!recorder.Enabled())
+    {
+        _name = nullptr;
+        return;
+    }
+    copyDetail(_detail, sizeof(_detail), detail, detail ? strlen(detail) : 0);
+    _start = recorder.Now();
+}
+
+TraceZone::TraceZone(const char *name, const std::string &detail) : _name(name), _start(0)
+{
+    _detail[0] = '\0';
+    TraceRecorder &recorder = TraceRecorder::Instance();
+    if (!recorder.Enabled())
+    {
+        _name = nullptr;
+        return;
+    }
+    copyDetail(_detail, sizeof(_detail), detail.c_str(), detail.size());
+    _start = recorder.Now();
+}
+
+TraceZone::~TraceZone()
+{
+    if (!_name)
+        return;
+    TraceRecorder &recorder = TraceRecorder::Instance();
+    recorder.Record(_name, _start, recorder.Now(), _detail[0] ? _detail : nullptr);
+}
@@ -0,0 +1,85 @@
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 一个计时区间，时间是相对记录器创建时刻的纳秒数
+struct TraceEvent
+{
+    const char *name;   // 必须是字符串常量，记录时不拷贝
+    uint64_t startNs;
+    uint64_t durationNs;
+    char detail[48];    // 可选的附加信息（文件名等），超长截断
+};
+
+// 启动阶段和每帧的耗时记录，导出为 Chrome/Perfetto 能直接打开的 JSON（chrome://tracing 或 ui.perfetto.dev）。
+// 每个线程第一次记录时注册一个缓冲区，之后只有本线程追加事件，缓冲区按块增长，已写的事件不会搬动；
+// 写完后用 release 递增计数发布，导出时 acquire 读计数，记录路径上没有锁；块数到上限后丢弃并计数
+class TraceRecorder
+{
+public:
+    static TraceRecorder &Instance();
+
+    void SetEnabled(bool enabled) { _enabled.store(enabled, std::memory_order_relaxed); }
+    bool Enabled() const { return _enabled.load(std::memory_order_relaxed); }
+
+    uint64_t Now() const;
+    void Record(const char *name, uint64_t startNs, uint64_t endNs, const char *detail = nullptr);
+    // 导出里显示的线程名，对调用线程生效
+    void SetThreadName(const std::string &name);
+
+    // 写出到目前为止所有线程记录的事件，可以在运行中多次调用
+    bool WriteJson(const std::string &path);
+
+private:
+    struct ThreadBuffer
+    {
+        unsigned int id;
+        std::string name;
+        // 块表长度固定，块在写到时才分配；发布计数之前块指针已经写好，导出线程只访问计数之内的块
+        std::unique_ptr<std::unique_ptr<TraceEvent[]>[]> chunks;
+        std::atomic<size_t> count;
+        std::atomic<size_t> dropped;
+    };
+
+    TraceRecorder();
+    TraceRecorder(const TraceRecorder &);
+    TraceRecorder &operator=(const TraceRecorder &);
+
+    ThreadBuffer *threadBuffer();
+
+private:
+    std::atomic<bool> _enabled;
+    uint64_t _origin;
+    std::mutex _mutex;  // 只保护 _buffers 的注册和导出时的遍历
+    std::vector<std::unique_ptr<ThreadBuffer> > _buffers;
+};
+
+// 作用域内的一个区间，析构时记录
+class TraceZone
+{
+public:
+    explicit TraceZone(const char *name, const char *detail = nullptr);
+    TraceZone(const char *name, const std::string &detail);
+    ~TraceZone();
+
+private:
+    TraceZone(const TraceZone &);
+    TraceZone &operator=(const TraceZone &);
+
+    const char *_name;
+    uint64_t _start;
+    char _detail[48];
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_ZONE(name) TraceZone TRACE_CONCAT(traceZone, __LINE__)(name)
+#define TRACE_ZONE_DETAIL(name, detail) TraceZone TRACE_CONCAT(traceZone, __LINE__)(name, detail)
+
+#endif
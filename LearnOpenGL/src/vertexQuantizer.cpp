@@ -0,0 +1,143 @@
+#include "vertexQuantizer.h"
+#include "model.h"
+
+#include <glad/glad.h>
+#include "glm/gtc/packing.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace
+{
+    float signNotZero(float value)
+    {
+        return value >= 0.0f ? 1.0f : -1.0f;
+    }
+
+    int16_t packSnorm16(float value)
+    {
+        value = std::max(-1.0f, std::min(1.0f, value));
+        return (int16_t)std::floor(value * 32767.0f + 0.5f);
+    }
+
+    float unpackSnorm16(int16_t value)
+    {
+        return std::max(value / 32767.0f, -1.0f);
+    }
+}
+
+size_t QuantizedMesh::Bytes() const
+{
+    return vertices.size() * sizeof(PackedVertex) + indices16.size() * sizeof(uint16_t) + indices32.size() * sizeof(unsigned int);
+}
+
+glm::vec2 VertexQuantizer::EncodeOctahedral(const glm::vec3 &normal)
+{
+    float length = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+    if (length <= 0.0f)
+        return glm::vec2(0.0f);
+    glm::vec3 n = normal / length;
+    if (n.z < 0.0f)
+        return glm::vec2((1.0f - std::fabs(n.y)) * signNotZero(n.x), (1.0f - std::fabs(n.x)) * signNotZero(n.y));
+    return glm::vec2(n.x, n.y);
+}
+
+glm::vec3 VertexQuantizer::DecodeOctahedral(const glm::vec2 &encoded)
+{
+    glm::vec3 n(encoded.x, encoded.y, 1.0f - std::fabs(encoded.x) - std::fabs(encoded.y));
+    if (n.z < 0.0f)
+    {
+        float x = (1.0f - std::fabs(n.y)) * signNotZero(n.x);
+        float y = (1.0f - std::fabs(n.x)) * signNotZero(n.y);
+        n.x = x;
+        n.y = y;
+    }
+    return glm::normalize(n);
+}
+
+QuantizedMesh VertexQuantizer::Quantize(const MeshData &mesh)
+{
+    QuantizedMesh result;
+    result.maxPositionError = 0.0f;
+    result.maxNormalError = 0.0f;
+    result.maxTexCoordError = 0.0f;
+
+    const Vertex *vertices = mesh.VertexData();
+    size_t vertexCount = mesh.VertexCount();
+    glm::vec3 minimum(0.0f), maximum(0.0f);
+    if (vertexCount > 0)
+    {
+        minimum = maximum = vertices[0].Position;
+        for (size_t i = 1; i < vertexCount; i++)
+        {
+            minimum = glm::min(minimum, vertices[i].Position);
+            maximum = glm::max(maximum, vertices[i].Position);
+        }
+    }
+    result.positionOffset = minimum;
+    result.positionScale = glm::max(maximum - minimum, glm::vec3(1e-20f)); // 避免扁平的轴除零
+
+    result.vertices.resize(vertexCount);
+    float maxNormalCos = 1.0f;
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        const Vertex &source = vertices[i];
+        PackedVertex &packed = result.vertices[i];
+
+        glm::vec3 unit = (source.Position - result.positionOffset) / result.positionScale;
+        for (int c = 0; c < 3; c++)
+        {
+            float q = std::max(0.0f, std::min(1.0f, unit[c]));
+            packed.Position[c] = (uint16_t)std::floor(q * 65535.0f + 0.5f);
+        }
+        packed.Position[3] = 0;
+
+        glm::vec2 octahedral = EncodeOctahedral(source.Normal);
+        packed.Normal[0] = packSnorm16(octahedral.x);
+        packed.Normal[1] = packSnorm16(octahedral.y);
+
+        packed.TexCoords[0] = glm::packHalf1x16(source.TexCoords.x);
+        packed.TexCoords[1] = glm::packHalf1x16(source.TexCoords.y);
+
+        // 解码回来统计误差，和 GPU 上的反量化方式一致
+        glm::vec3 position = result.positionOffset + result.positionScale
+            * glm::vec3(packed.Position[0], packed.Position[1], packed.Position[2]) / 65535.0f;
+        glm::vec3 error = glm::abs(position - source.Position);
+        result.maxPositionError = std::max(result.maxPositionError, std::max(error.x, std::max(error.y, error.z)));
+
+        float normalLength = glm::length(source.Normal);
+        if (normalLength > 0.0f)
+        {
+            glm::vec3 normal = DecodeOctahedral(glm::vec2(unpackSnorm16(packed.Normal[0]), unpackSnorm16(packed.Normal[1])));
+            maxNormalCos = std::min(maxNormalCos, glm::dot(normal, source.Normal / normalLength));
+        }
+
+        glm::vec2 texCoords(glm::unpackHalf1x16(packed.TexCoords[0]), glm::unpackHalf1x16(packed.TexCoords[1]));
+        glm::vec2 texError = glm::abs(texCoords - source.TexCoords);
+        result.maxTexCoordError = std::max(result.maxTexCoordError, std::max(texError.x, texError.y));
+    }
+    result.maxNormalError = glm::degrees(std::acos(std::max(-1.0f, std::min(1.0f, maxNormalCos))));
+
+    const unsigned int *indices = mesh.IndexData();
+    if (vertexCount < 65536)
+        result.indices16.assign(indices, indices + mesh.IndexCount());
+    else
+        result.indices32.assign(indices, indices + mesh.IndexCount());
+    return result;
+}
+
+void VertexQuantizer::SetupAttributes()
+{
+    // 位置：归一化的无符号16位整数，shader 里再乘包围盒尺寸加最小点
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (GLvoid*)offsetof(PackedVertex, Position));
+
+    // 法线：八面体编码的两个分量，shader 里解码
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(PackedVertex), (GLvoid*)offsetof(PackedVertex, Normal));
+
+    // 纹理坐标：半精度浮点
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex), (GLvoid*)offsetof(PackedVertex, TexCoords));
+}
@@ -0,0 +1,53 @@
+#ifndef VERTEX_QUANTIZER_H
+#define VERTEX_QUANTIZER_H
+
+#include "glm/glm.hpp"
+
+#include <stdint.h>
+#include <vector>
+
+struct Vertex;
+struct MeshData;
+
+// 16 字节的压缩顶点，是 Vertex 的一半：
+// 位置为相对mesh包围盒归一化的 16bit 整数，法线为 16bit 八面体编码，纹理坐标为半精度浮点
+struct PackedVertex
+{
+    uint16_t Position[4]; // xyz + 填充，GL_UNSIGNED_SHORT normalized
+    int16_t Normal[2];    // 八面体编码，GL_SHORT normalized
+    uint16_t TexCoords[2]; // GL_HALF_FLOAT
+};
+
+// 量化后的mesh，以及反量化需要的参数和实测误差
+struct QuantizedMesh
+{
+    std::vector<PackedVertex> vertices;
+    std::vector<uint16_t> indices16; // 顶点数小于 65536 时使用
+    std::vector<unsigned int> indices32;
+
+    glm::vec3 positionOffset; // 包围盒最小点
+    glm::vec3 positionScale;  // 包围盒尺寸，position = offset + scale * q
+
+    float maxPositionError;   // 与原始坐标的最大绝对误差（模型空间单位）
+    float maxNormalError;     // 法线最大夹角误差（度）
+    float maxTexCoordError;   // 纹理坐标最大绝对误差
+
+    bool Uses16BitIndices() const { return !indices16.empty(); }
+    size_t IndexCount() const { return indices16.empty() ? indices32.size() : indices16.size(); }
+    size_t Bytes() const;
+};
+
+class VertexQuantizer
+{
+public:
+    // 纯CPU：量化一个mesh，并解码回去统计误差上界
+    static QuantizedMesh Quantize(const MeshData &mesh);
+
+    // 在当前绑定的VAO上设置 PackedVertex 的顶点属性指针
+    static void SetupAttributes();
+
+    static glm::vec2 EncodeOctahedral(const glm::vec3 &normal);
+    static glm::vec3 DecodeOctahedral(const glm::vec2 &encoded);
+};
+
+#endif
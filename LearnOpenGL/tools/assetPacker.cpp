@@ -0,0 +1,25 @@
+// 资源打包工具：把资源目录打成一个 .pak，程序启动时挂载后只需要映射这一个文件
+// 用法: assetPacker [资源目录] [输出文件]，默认 resource 目录和 resource.pak
+
+#include "config.h"
+#include "assetPack.h"
+
+#include <chrono>
+#include <iostream>
+
+int main(int argc, char **argv)
+{
+    std::string directory = argc > 1 ? argv[1] : PROJECT_PATH + "/resource";
+    std::string packPath = argc > 2 ? argv[2] : PROJECT_PATH + "/resource.pak";
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    if (!AssetPack::Build(directory, packPath))
+        return 1;
+
+    // 重新挂载一遍，确认索引可以正常读取
+    if (!AssetPack::Instance().Mount(packPath, directory))
+        return 1;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "ASSET_PACK::DONE " << AssetPack::Instance().EntryCount() << " files in " << seconds * 1000.0 << " ms" << std::endl;
+    return 0;
+}